@@ -7,6 +7,7 @@
 #include <vector>
 
 #include "debugger/disassembly.h"
+#include "gameboy/util/byte_view.h"
 #include "gameboy/util/observer.h"
 #include "gameboy/memory/address.h"
 
@@ -22,14 +23,14 @@ public:
     static constexpr std::string_view name_wram = "WRM";
     static constexpr std::string_view name_hram = "HRM";
 
-    disassembly_db(observer<bus> bus, std::string_view name, const std::vector<uint8_t>& data) noexcept;
+    disassembly_db(observer<bus> bus, std::string_view name, byte_view data) noexcept;
 
     void on_write(const address16& addr, uint8_t data) noexcept;
     [[nodiscard]] const std::vector<disassembly>& get() noexcept;
 
 private:
     observer<bus> bus_;
-    const std::vector<uint8_t>* data_;
+    byte_view data_;
     std::vector<disassembly> disassemblies_;
     std::string_view name_;
     size_t bank_size_ = 0u;
@@ -38,7 +39,7 @@ private:
     uint32_t earliest_dirty_bank_ = 0u;
 
     [[nodiscard]] std::pair<size_t, disassembly> disassemble(size_t physical_addr) noexcept;
-    void generate_disassembly(size_t start) noexcept { generate_disassembly(start, data_->size()); }
+    void generate_disassembly(size_t start) noexcept { generate_disassembly(start, data_.size()); }
     void generate_disassembly(size_t start, size_t end) noexcept;
 
     [[nodiscard]] uint16_t base_address() const noexcept
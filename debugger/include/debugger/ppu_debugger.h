@@ -2,10 +2,13 @@
 #define GAMEBOY_PPU_DEBUGGER_H
 
 #include <array>
+#include <cstddef>
 
 #include <SFML/Graphics/Image.hpp>
 #include <SFML/Graphics/Texture.hpp>
 
+#include "gameboy/ppu/color.h"
+#include "gameboy/ppu/line_compositor.h"
 #include "gameboy/util/observer.h"
 
 namespace gameboy {
@@ -26,6 +29,11 @@ private:
     sf::Image bg_map_img_;
     sf::Texture bg_map_;
 
+    /** the map without the scroll overlay, only tiles the ppu redrew are drawn again */
+    sf::Image bg_map_base_img_;
+    int bg_map_layer_idx_ = -1;
+    std::array<color, line_compositor::obj_color_offset> bg_map_colors_;
+
     std::array<sf::Image, 40u> oam_imgs_;
     std::array<sf::Texture, 40u> oam_;
 
@@ -37,6 +45,7 @@ private:
     void draw_vram_view();
     void draw_tiles();
     void draw_bg_map();
+    void draw_bg_map_layer(size_t map_idx);
     void draw_bg_map_overlay();
     void draw_oam();
 };
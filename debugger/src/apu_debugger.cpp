@@ -57,7 +57,7 @@ void apu_debugger::draw() noexcept
             ImGui::Columns(1);
             ImGui::Separator();
 
-            std::array<float, apu::sample_size> samples_f;
+            std::vector<float> samples_f(apu_->sound_buffer_.size());
             std::transform(begin(apu_->sound_buffer_), end(apu_->sound_buffer_), begin(samples_f),
                 [](const int16_t sample) {
                     return static_cast<float>(sample) / static_cast<float>(std::numeric_limits<int16_t>::max());
@@ -86,7 +86,7 @@ void apu_debugger::draw() noexcept
 
             ImGui::TextUnformatted("Sound buffer visualizer");
             ImGui::PlotLines("",
-                samples_f.data(), samples_f.size(), apu_->buffer_fill_amount_,
+                samples_f.data(), samples_f.size(), 0,
                 nullptr, -0.1f, 1.0f, ImVec2(400.f,160.f));
 
             ImGui::EndTabItem();
@@ -32,7 +32,8 @@ void gameboy::memory_bank_debugger::draw() noexcept
                     const int banks = cartridge->rom_bank_count();
                     ImGui::SliderInt("BANK", &selected_bank, 0, banks - 1);
 
-                    memory_editor_.DrawContents(cartridge->rom_.data() + selected_bank * 16_kb, 16_kb, selected_bank == 0 ? 0x0000u : 0x4000u);
+                    // the editor is read only, the rom is never written through it
+                    memory_editor_.DrawContents(const_cast<uint8_t*>(cartridge->rom_->data()) + selected_bank * 16_kb, 16_kb, selected_bank == 0 ? 0x0000u : 0x4000u);
                     ImGui::EndTabItem();
                 }
 
@@ -1,5 +1,6 @@
 #include "debugger/ppu_debugger.h"
 
+#include <algorithm>
 #include <cstring>
 
 #include <SFML/Graphics/Sprite.hpp>
@@ -26,6 +27,7 @@ gameboy::ppu_debugger::ppu_debugger(const observer<ppu> ppu) noexcept
 
     bg_map_.create(bg_map_tile_count * ppu::tile_pixel_count, bg_map_tile_count * ppu::tile_pixel_count);
     bg_map_img_.create(bg_map_tile_count * ppu::tile_pixel_count, bg_map_tile_count * ppu::tile_pixel_count);
+    bg_map_base_img_.create(bg_map_tile_count * ppu::tile_pixel_count, bg_map_tile_count * ppu::tile_pixel_count);
 
     for(size_t i = 0u; i < 40u; ++i) {
         oam_imgs_[i].create(ppu::tile_pixel_count, ppu::tile_pixel_count * 2, sf::Color::White);
@@ -78,17 +80,17 @@ void gameboy::ppu_debugger::draw_registers() const noexcept
     ImGui::Separator();
 
     ImGui::Text("VBK:  %02X", ppu_->vram_bank_);
-    ImGui::Text("LCDC: %02X", ppu_->lcdc_.reg.value());
-    ImGui::Text("STAT: %02X", ppu_->stat_.reg.value());
+    ImGui::Text("LCDC: %02X", ppu_->registers_.lcdc.reg.value());
+    ImGui::Text("STAT: %02X", ppu_->registers_.stat.reg.value());
     
     ImGui::NextColumn();
 
-    ImGui::Text("LY:   %02X", ppu_->ly_.value());
-    ImGui::Text("LYC:  %02X", ppu_->lyc_.value());
-    ImGui::Text("SCX:  %02X", ppu_->scx_.value());
-    ImGui::Text("SCY:  %02X", ppu_->scy_.value());
-    ImGui::Text("WX:   %02X", ppu_->wx_.value());
-    ImGui::Text("WY:   %02X", ppu_->wy_.value());
+    ImGui::Text("LY:   %02X", ppu_->registers_.ly.value());
+    ImGui::Text("LYC:  %02X", ppu_->registers_.lyc.value());
+    ImGui::Text("SCX:  %02X", ppu_->registers_.scx.value());
+    ImGui::Text("SCY:  %02X", ppu_->registers_.scy.value());
+    ImGui::Text("WX:   %02X", ppu_->registers_.wx.value());
+    ImGui::Text("WY:   %02X", ppu_->registers_.wy.value());
 
     ImGui::Columns(1);
 }
@@ -102,24 +104,24 @@ void gameboy::ppu_debugger::draw_lcdc_n_stat() const
 
     ImGui::Separator();
     
-    ImGui::Text("LCD:  %s", ppu_->lcdc_.lcd_enabled() ? "on" : "off");
-    ImGui::Text("WIN:  %04X", ppu_->lcdc_.window_map_secondary() ? 0x9C00u : 0x9800u);
-    ImGui::Text("WIN:  %s", ppu_->lcdc_.window_enabled() ? "on" : "off");
-    ImGui::Text("CHR:  %04X", ppu_->lcdc_.unsigned_mode() ? 0x8800u : 0x8000u);
-    ImGui::Text("BG:   %04X", ppu_->lcdc_.bg_map_secondary() ? 0x9C00u : 0x9800u);
-    ImGui::Text("OBJ:  %s", ppu_->lcdc_.large_obj() ? "8x16" : "8x8");
-    ImGui::Text("OBJ:  %s" ,ppu_->lcdc_.obj_enabled() ? "on" : "off");
-    ImGui::Text("BG:   %s", ppu_->lcdc_.bg_enabled() ? "on" : "off");
+    ImGui::Text("LCD:  %s", ppu_->registers_.lcdc.lcd_enabled() ? "on" : "off");
+    ImGui::Text("WIN:  %04X", ppu_->registers_.lcdc.window_map_secondary() ? 0x9C00u : 0x9800u);
+    ImGui::Text("WIN:  %s", ppu_->registers_.lcdc.window_enabled() ? "on" : "off");
+    ImGui::Text("CHR:  %04X", ppu_->registers_.lcdc.unsigned_mode() ? 0x8800u : 0x8000u);
+    ImGui::Text("BG:   %04X", ppu_->registers_.lcdc.bg_map_secondary() ? 0x9C00u : 0x9800u);
+    ImGui::Text("OBJ:  %s", ppu_->registers_.lcdc.large_obj() ? "8x16" : "8x8");
+    ImGui::Text("OBJ:  %s" ,ppu_->registers_.lcdc.obj_enabled() ? "on" : "off");
+    ImGui::Text("BG:   %s", ppu_->registers_.lcdc.bg_enabled() ? "on" : "off");
 
     ImGui::NextColumn();
 
-    ImGui::Text("<LYC=LY>: %d", bit::test(ppu_->stat_.reg, 6));
-    ImGui::Text("<OAM>:    %d", bit::test(ppu_->stat_.reg, 5));
-    ImGui::Text("<VBlank>: %d", bit::test(ppu_->stat_.reg, 4));
-    ImGui::Text("<HBlank>: %d", bit::test(ppu_->stat_.reg, 3));
-    ImGui::Text("LYC=LY:   %d", bit::test(ppu_->stat_.reg, 2));
-    ImGui::Text("mode:     %d (%s)", static_cast<int8_t>(ppu_->stat_.get_mode()), [&]() {
-        switch(ppu_->stat_.get_mode()) {
+    ImGui::Text("<LYC=LY>: %d", bit::test(ppu_->registers_.stat.reg, 6));
+    ImGui::Text("<OAM>:    %d", bit::test(ppu_->registers_.stat.reg, 5));
+    ImGui::Text("<VBlank>: %d", bit::test(ppu_->registers_.stat.reg, 4));
+    ImGui::Text("<HBlank>: %d", bit::test(ppu_->registers_.stat.reg, 3));
+    ImGui::Text("LYC=LY:   %d", bit::test(ppu_->registers_.stat.reg, 2));
+    ImGui::Text("mode:     %d (%s)", static_cast<int8_t>(ppu_->registers_.stat.get_mode()), [&]() {
+        switch(ppu_->registers_.stat.get_mode()) {
             case stat_mode::h_blank: return "hblank";
             case stat_mode::v_blank: return "vblank";
             case stat_mode::reading_oam: return "reading oam";
@@ -254,7 +256,7 @@ void gameboy::ppu_debugger::draw_tiles()
         ImGui::Combo("Tile Area", &current_tile_area, bank_names.data(), bank_names.size());
     }
 
-    const auto ram = ppu_->ram_;
+    const auto& ram = ppu_->ram_;
 
     const auto palette = ppu_->bus_->get_cartridge()->cgb_enabled()
         ? ppu_->cgb_bg_palettes_[0]
@@ -338,48 +340,43 @@ void gameboy::ppu_debugger::draw_bg_map()
     ImGui::Combo("Tile Address", &current_tile_address, tile_addresses.data(), tile_addresses.size());
 
     const auto tile_start_addr = address16(current_bg_map_area == 1 ? 0x9C00u : 0x9800u);
-    for(size_t y = 0u; y < bg_map_tile_count; ++y) {
-        for(size_t x = 0u; x < bg_map_tile_count; ++x) {
-            const auto idx = y * bg_map_tile_count + x;
-            const auto tile_no = ppu_->read_ram_by_bank(tile_start_addr + idx, 0);
-            const attributes::bg tile_attr{ppu_->read_ram_by_bank(tile_start_addr + idx, 1)};
-
-            for(auto tile_y = 0u; tile_y < ppu::tile_pixel_count; ++tile_y) {
-                const auto tile_base_addr = current_tile_address == 1
-                    ? ppu_->tile_address<uint8_t>(0x8000u, tile_no)
-                    : ppu_->tile_address<int8_t>(0x9000u, tile_no);
-
-                auto tile_row = ppu_->get_tile_row(tile_attr.v_flipped() ? 7u - tile_y : tile_y, tile_base_addr, tile_attr.vram_bank());
-
-                if(tile_attr.h_flipped()) {
-                    std::reverse(begin(tile_row), end(tile_row));
-                }
-
-                for(auto tile_x = 0u; tile_x < ppu::tile_pixel_count; ++tile_x) {
-                    const auto color_idx = tile_row[tile_x];
-                    const auto color = [&]() {
-                        if(ppu_->bus_->get_cartridge()->cgb_enabled()) {
-                            return ppu_->correct_color(
-                                ppu_->cgb_bg_palettes_[tile_attr.palette_index()].colors[color_idx]);
-                        } 
-
-                        const auto background_palette = palette::from(ppu_->gb_palette_, ppu_->bgp_.value());
-                        return background_palette.colors[color_idx];
-                    }();
-
-                    bg_map_img_.setPixel(
-                        x * ppu::tile_pixel_count + tile_x,
-                        y * ppu::tile_pixel_count + tile_y, sf::Color{
-                            color.red,
-                            color.green,
-                            color.blue,
-                            255
-                        });
+    if((current_tile_address == 1) == ppu_->registers_.lcdc.unsigned_mode()) {
+        draw_bg_map_layer(static_cast<size_t>(current_bg_map_area));
+    } else {
+        // the ppu caches maps only with the tile addressing lcdc selects
+        bg_map_layer_idx_ = -1;
+
+        for(size_t y = 0u; y < bg_map_tile_count; ++y) {
+            for(size_t x = 0u; x < bg_map_tile_count; ++x) {
+                const auto idx = y * bg_map_tile_count + x;
+                const auto tile_no = ppu_->read_ram_by_bank(tile_start_addr + idx, 0);
+                const attributes::bg tile_attr{ppu_->read_ram_by_bank(tile_start_addr + idx, 1)};
+
+                for(auto tile_y = 0u; tile_y < ppu::tile_pixel_count; ++tile_y) {
+                    const auto tile_base_addr = current_tile_address == 1
+                        ? ppu_->tile_address<uint8_t>(0x8000u, tile_no)
+                        : ppu_->tile_address<int8_t>(0x9000u, tile_no);
+
+                    const auto& tile_row = ppu_->get_tile_row(tile_attr.v_flipped() ? 7u - tile_y : tile_y,
+                        tile_base_addr, tile_attr.vram_bank(), tile_attr.h_flipped());
+
+                    for(auto tile_x = 0u; tile_x < ppu::tile_pixel_count; ++tile_x) {
+                        const auto& color = ppu_->color_table_[tile_attr.palette_index() * 4u + tile_row[tile_x]];
+                        bg_map_base_img_.setPixel(
+                            x * ppu::tile_pixel_count + tile_x,
+                            y * ppu::tile_pixel_count + tile_y, sf::Color{
+                                color.red,
+                                color.green,
+                                color.blue,
+                                255
+                            });
+                    }
                 }
             }
         }
     }
 
+    bg_map_img_.copy(bg_map_base_img_, 0u, 0u);
     draw_bg_map_overlay();
 
     bg_map_.update(bg_map_img_);
@@ -419,11 +416,47 @@ void gameboy::ppu_debugger::draw_bg_map()
     ImGui::NewLine();
 }
 
+void gameboy::ppu_debugger::draw_bg_map_layer(const size_t map_idx)
+{
+    for(auto tile_row = 0u; tile_row < bg_map_tile_count; ++tile_row) {
+        ppu_->update_map_layer_row(map_idx, tile_row);
+    }
+
+    auto& layer = ppu_->map_layers_[map_idx];
+    const auto& colors = ppu_->color_table_;
+
+    const auto redraw_all = bg_map_layer_idx_ != static_cast<int>(map_idx) ||
+        !std::equal(begin(bg_map_colors_), end(bg_map_colors_), begin(colors), [](const color& l, const color& r) {
+            return l.red == r.red && l.green == r.green && l.blue == r.blue;
+        });
+
+    constexpr auto bg_map_pixel_count = bg_map_tile_count * ppu::tile_pixel_count;
+    for(auto map_tile_idx = 0u; map_tile_idx < layer.redrawn_tiles.size(); ++map_tile_idx) {
+        if(!redraw_all && !layer.redrawn_tiles.test(map_tile_idx)) {
+            continue;
+        }
+
+        const auto pixel_x = map_tile_idx % bg_map_tile_count * ppu::tile_pixel_count;
+        const auto pixel_y = map_tile_idx / bg_map_tile_count * ppu::tile_pixel_count;
+        for(auto y = pixel_y; y < pixel_y + ppu::tile_pixel_count; ++y) {
+            for(auto x = pixel_x; x < pixel_x + ppu::tile_pixel_count; ++x) {
+                const auto pixel_idx = y * bg_map_pixel_count + x;
+                const auto& color = colors[layer.palettes[pixel_idx] * 4u + layer.color_indices[pixel_idx]];
+                bg_map_base_img_.setPixel(x, y, sf::Color{color.red, color.green, color.blue, 255});
+            }
+        }
+    }
+
+    layer.redrawn_tiles.reset();
+    bg_map_layer_idx_ = static_cast<int>(map_idx);
+    std::copy_n(begin(colors), bg_map_colors_.size(), begin(bg_map_colors_));
+}
+
 void gameboy::ppu_debugger::draw_bg_map_overlay()
 {
     constexpr auto bg_map_pixel_count = bg_map_tile_count * ppu::tile_pixel_count;
-    const auto scy = ppu_->scy_.value();
-    const auto scx = ppu_->scx_.value();
+    const auto scy = ppu_->registers_.scy.value();
+    const auto scx = ppu_->registers_.scx.value();
 
     const auto edge_y = (scy + screen_height) % bg_map_pixel_count;
     const auto edge_x = (scx + screen_width) % bg_map_pixel_count;
@@ -453,14 +486,15 @@ void gameboy::ppu_debugger::draw_oam()
         auto& img = oam_imgs_[obj_idx];
         auto& tex = oam_[obj_idx];
 
-        const auto tile_y_end = ppu_->lcdc_.large_obj() ? ppu::tile_pixel_count * 2 : ppu::tile_pixel_count;
+        const auto tile_y_end = ppu_->registers_.lcdc.large_obj() ? ppu::tile_pixel_count * 2 : ppu::tile_pixel_count;
         for(auto tile_y = 0u; tile_y < tile_y_end; ++tile_y) {
-            const auto tile_row = ppu_->get_tile_row(
+            const auto& tile_row = ppu_->get_tile_row(
                 tile_y, 
-                ppu_->tile_address<uint8_t>(0x8000u, ppu_->lcdc_.large_obj()
+                ppu_->tile_address<uint8_t>(0x8000u, ppu_->registers_.lcdc.large_obj()
                      ? obj.tile_number & 0xFEu
                      : obj.tile_number),
-                obj.vram_bank());
+                obj.vram_bank(),
+                false);
 
             for(auto tile_x = 0u; tile_x < ppu::tile_pixel_count; ++tile_x) {
                 const auto color_idx = tile_row[tile_x];
@@ -501,7 +535,7 @@ void gameboy::ppu_debugger::draw_oam()
             return sf::Color::White;
         }(obj_disabled);
 
-        if(ppu_->lcdc_.large_obj()) {
+        if(ppu_->registers_.lcdc.large_obj()) {
             ImGui::Image(tex, {32, 64}, entry_color);
         } else {
             ImGui::Image(tex, {64, 64},
@@ -15,6 +15,7 @@
 #include <nlohmann/json.hpp>
 
 #include "gameboy/gameboy.h"
+#include "gameboy/rewind_buffer.h"
 #include "list_view.h"
 #include "sdl_audio.h"
 
@@ -43,7 +44,6 @@ public:
 
     void play_sound(const gameboy::apu::sound_buffer& sound_buffer) noexcept;
     void rescale_view() noexcept;
-    void render_line(uint8_t line_number, const gameboy::render_line& line) noexcept;
     void draw_sprite() noexcept;
     void render_frame() noexcept;
 
@@ -68,8 +68,14 @@ private:
     nlohmann::json config_;
     std::vector<rom_entry> roms_;
 
+    uint32_t audio_sampling_rate_;
+    uint32_t audio_sample_size_;
+
     gameboy::observer<gameboy::gameboy> gb_;
-    sf::Image window_buffer_;
+    /** empty if rewinding is disabled with a zero memory budget */
+    std::optional<gameboy::rewind_buffer> rewind_;
+    gameboy::rewind_buffer::config rewind_config_;
+    bool rewinding_ = false;
     sf::Texture window_texture_;
     sf::Sprite window_sprite_;
     sf::RenderWindow window_;
@@ -35,10 +35,15 @@ constexpr auto* config_file_name = "config.json";
 constexpr auto* config_key_favorite = "favorite";
 constexpr auto* config_key_gb_palette_idx = "gb_palette_idx";
 constexpr auto* config_key_audio_device = "last_audio_device_id";
+constexpr auto* config_key_audio_sampling_rate = "audio_sampling_rate";
+constexpr auto* config_key_audio_sample_size = "audio_sample_size";
+constexpr auto* config_key_rewind_memory_kb = "rewind_memory_kb";
+constexpr auto* config_key_rewind_frame_interval = "rewind_frame_interval";
 
 } // namespace
 
 using json = nlohmann::json;
+using gameboy::operator""_kb;
 
 frontend::frontend(
   const uint32_t width, const uint32_t height, const bool fullscreen,
@@ -84,9 +89,14 @@ frontend::frontend(
 frontend::frontend(const uint32_t width, const uint32_t height, const bool fullscreen) noexcept
     : config_(
         gameboy::filesystem::exists(config_file_name)
-          ? json::parse(gameboy::read_file(config_file_name))
+          ? [] {
+              const auto config_file = gameboy::read_file(config_file_name);
+              return json::parse(config_file.begin(), config_file.end());
+          }()
           : json::object()
       ),
+      audio_sampling_rate_{config_.value(config_key_audio_sampling_rate, gameboy::apu::default_sampling_rate)},
+      audio_sample_size_{config_.value(config_key_audio_sample_size, gameboy::apu::default_sample_size)},
       window_(
         sf::VideoMode(width, height),
         "GAMEBOY",
@@ -96,17 +106,22 @@ frontend::frontend(const uint32_t width, const uint32_t height, const bool fulls
         sdl::audio_device::device_name(config_.contains(config_key_audio_device)
               ? config_[config_key_audio_device].get<int32_t>() : 0), 2u,
         sdl::audio_device::format::s16,
-        gameboy::apu::sampling_rate,
-        gameboy::apu::sample_size
+        audio_sampling_rate_,
+        static_cast<uint16_t>(audio_sample_size_)
       },
       menu_title_{"Pick ROM", font_, 45}
 {
+    rewind_config_.memory_budget = config_.value(config_key_rewind_memory_kb, rewind_config_.memory_budget / 1_kb) * 1_kb;
+    rewind_config_.frame_interval = std::max(config_.value(config_key_rewind_frame_interval, rewind_config_.frame_interval), 1u);
+
     menu_bg_.setFillColor(sf::Color{0x111111BB});
 
     window_.setFramerateLimit(60u);
     window_.setVerticalSyncEnabled(false);
-    window_buffer_.create(gameboy::screen_width, gameboy::screen_height, sf::Color::White);
+    sf::Image blank_screen;
+    blank_screen.create(gameboy::screen_width, gameboy::screen_height, sf::Color::White);
     window_texture_.create(gameboy::screen_width, gameboy::screen_height);
+    window_texture_.update(blank_screen);
 
     window_sprite_.setTexture(window_texture_);
 
@@ -114,7 +129,6 @@ frontend::frontend(const uint32_t width, const uint32_t height, const bool fulls
     window_sprite_.setOrigin(sprite_local_bounds.width * .5f, sprite_local_bounds.height * .5f);
 
     rescale_view();
-    render_frame();
 
     audio_device_.resume();
 
@@ -145,6 +159,11 @@ frontend::frontend(const uint32_t width, const uint32_t height, const bool fulls
 
 frontend::~frontend()
 {
+    config_[config_key_audio_sampling_rate] = audio_sampling_rate_;
+    config_[config_key_audio_sample_size] = audio_sample_size_;
+    config_[config_key_rewind_memory_kb] = rewind_config_.memory_budget / 1_kb;
+    config_[config_key_rewind_frame_interval] = rewind_config_.frame_interval;
+
     std::ofstream config_file{config_file_name};
     config_file << std::setw(4) /*pretty print*/ << config_;
 }
@@ -157,9 +176,15 @@ void frontend::register_gameboy(const gameboy::observer<gameboy::gameboy> gb) no
         gb_->load_rom(roms_.front().path);
     }
 
-    gb_->on_render_line({gameboy::connect_arg<&frontend::render_line>, this});
+    gb_->set_pixel_format(gameboy::pixel_format::rgba8888);
     gb_->on_vblank({gameboy::connect_arg<&frontend::render_frame>, this});
     gb_->on_audio_buffer_full({gameboy::connect_arg<&frontend::play_sound>, this});
+    gb_->set_audio_sampling_rate(audio_sampling_rate_);
+    gb_->set_audio_sample_size(audio_sample_size_);
+
+    if(rewind_config_.memory_budget != 0u) {
+        rewind_.emplace(gb_, rewind_config_);
+    }
 }
 
 void frontend::play_sound(const gameboy::apu::sound_buffer& sound_buffer) noexcept
@@ -208,16 +233,6 @@ void frontend::rescale_view() noexcept
     draw_sprite();
 }
 
-void frontend::render_line(const uint8_t line_number, const gameboy::render_line& line) noexcept
-{
-    for(size_t i = 0; i < line.size(); ++i) {
-        const auto& color = line[i];
-        window_buffer_.setPixel(i, line_number, {
-          color.red, color.green, color.blue, 255
-        });
-    }
-}
-
 void frontend::draw_sprite() noexcept
 {
     window_.clear();
@@ -227,7 +242,7 @@ void frontend::draw_sprite() noexcept
 
 void frontend::render_frame() noexcept
 {
-    window_texture_.update(window_buffer_);
+    window_texture_.update(gb_->frame().data());
     draw_sprite();
 }
 
@@ -329,6 +344,16 @@ frontend::tick_result frontend::tick()
             break;
 
         case state::game:
+            if(!rewind_) {
+                return tick_result::ticking;
+            }
+
+            if(rewinding_) {
+                // the frame after the loaded snapshot is emulated to show where the game went back to
+                return rewind_->step_back() ? tick_result::ticking : tick_result::paused;
+            }
+
+            rewind_->on_frame();
             return tick_result::ticking;
 
         default:
@@ -381,8 +406,8 @@ void frontend::on_audio_device_selected(const size_t idx) noexcept
     audio_device_ = sdl::audio_device{
       sdl::audio_device::device_name(idx),
       2u, sdl::audio_device::format::s16,
-      gameboy::apu::sampling_rate,
-      gameboy::apu::sample_size
+      audio_sampling_rate_,
+      static_cast<uint16_t>(audio_sample_size_)
     };
     audio_device_.resume();
 }
@@ -406,6 +431,9 @@ void frontend::on_rom_file_selected(const size_t idx) noexcept
     }
 
     gb_->load_rom(rom_path);
+    if(rewind_) {
+        rewind_->clear();
+    }
     window_.setTitle(fmt::format("GAMEBOY - {}", gb_->rom_name()));
 
     if(!cartridge->cgb_enabled()) {
@@ -462,6 +490,9 @@ void frontend::handle_game_keys(const sf::Event& key_event) noexcept
             case sf::Keyboard::Space:
                 gb_->press_key(gameboy::joypad::key::select);
                 break;
+            case sf::Keyboard::BackSpace:
+                rewinding_ = true;
+                break;
 #if WITH_DEBUGGER
             case sf::Keyboard::F:
             case sf::Keyboard::F7:
@@ -497,6 +528,9 @@ void frontend::handle_game_keys(const sf::Event& key_event) noexcept
             case sf::Keyboard::Space:
                 gb_->release_key(gameboy::joypad::key::select);
                 break;
+            case sf::Keyboard::BackSpace:
+                rewinding_ = false;
+                break;
             case sf::Keyboard::S:
                 gb_->save_ram_rtc();
                 break;
@@ -5,6 +5,7 @@
 #include <cstdint>
 #include <vector>
 
+#include "gameboy/apu/band_limited_buffer.h"
 #include "gameboy/apu/data/control.h"
 #include "gameboy/apu/noise_channel.h"
 #include "gameboy/apu/pulse_channel.h"
@@ -13,6 +14,7 @@
 #include "gameboy/memory/address_range.h"
 #include "gameboy/util/delegate.h"
 #include "gameboy/util/observer.h"
+#include "gameboy/util/state_buffer.h"
 
 namespace gameboy {
 
@@ -23,8 +25,9 @@ class apu {
     friend apu_debugger;
 
 public:
-    static constexpr auto sampling_rate = 44'100u;
-    static constexpr auto sample_size = 4096u;
+    static constexpr auto default_sampling_rate = 44'100u;
+    static constexpr auto default_sample_size = 4096u;
+    static constexpr auto state_section = make_state_tag("APU ");
 
     using sound_buffer = std::vector<int16_t>;
     using sound_buffer_full_func = delegate<void(const sound_buffer&)>;
@@ -32,9 +35,24 @@ public:
     explicit apu(observer<bus> bus);
     void reset() noexcept;
 
-    void tick(uint8_t cycles) noexcept;
+    /** the sound buffers are not part of the state, they keep filling from where they are */
+    void save_state(state_writer& writer) const;
+    void load_state(state_reader& reader) noexcept;
+    /** takes the sampling settings of the other apu, its callback and pending samples are not copied */
+    void copy_settings(const apu& other);
+
+    /** catches up with the scheduler */
+    void sync() noexcept;
     void on_sound_buffer_full(const sound_buffer_full_func on_buffer_full) noexcept { on_buffer_full_ = on_buffer_full; }
 
+    /** output samples per second of each terminal */
+    void set_sampling_rate(uint32_t sampling_rate);
+    /** amount of interleaved left and right samples passed to the sound buffer full callback */
+    void set_sample_size(uint32_t sample_size);
+
+    [[nodiscard]] uint32_t sampling_rate() const noexcept { return sampling_rate_; }
+    [[nodiscard]] uint32_t sample_size() const noexcept { return sample_size_; }
+
 private:
     observer<bus> bus_;
 
@@ -47,12 +65,23 @@ private:
 
     audio::control control_;
 
+    uint32_t sampling_rate_;
+    uint32_t sample_size_;
+
+    uint64_t last_sync_cycle_;
+    uint64_t frame_cycles_;
+    uint64_t cycles_until_buffer_full_;
+
     uint16_t frame_sequencer_counter_;
-    uint16_t buffer_fill_amount_;
     uint8_t frame_sequencer_;
-    uint8_t down_sample_counter_;
+
+    int32_t left_amplitude_;
+    int32_t right_amplitude_;
+    audio::band_limited_buffer left_buffer_;
+    audio::band_limited_buffer right_buffer_;
 
 #if WITH_DEBUGGER
+    uint32_t buffer_fill_amount_;
     std::vector<float> sound_buffer_1_;
     std::vector<float> sound_buffer_2_;
     std::vector<float> sound_buffer_3_;
@@ -63,10 +92,16 @@ private:
 
     sound_buffer_full_func on_buffer_full_;
 
-    void generate_samples() noexcept;
+    void advance(uint64_t cycles) noexcept;
+    void update_amplitudes() noexcept;
+    void flush_sound_buffer() noexcept;
+
+    void reset_sound_buffers();
+    void schedule_buffer_full() noexcept;
+    void on_buffer_full_deadline() noexcept;
 
     void on_write(const address16& address, uint8_t data) noexcept;
-    [[nodiscard]] uint8_t on_read(const address16& address) const noexcept;
+    [[nodiscard]] uint8_t on_read(const address16& address) noexcept;
 
     void on_wave_pattern_write(const address16& address, uint8_t data) noexcept;
     [[nodiscard]] uint8_t on_wave_pattern_read(const address16& address) const noexcept;
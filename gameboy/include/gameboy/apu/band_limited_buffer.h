@@ -0,0 +1,47 @@
+#ifndef GAMEBOY_BAND_LIMITED_BUFFER_H
+#define GAMEBOY_BAND_LIMITED_BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gameboy::audio {
+
+/**
+ * Turns amplitude changes which happen at exact clock timestamps into band-limited samples
+ * at an arbitrary output rate. Every change is recorded as a step smoothed by a windowed sinc
+ * kernel and the output is the running sum of all recorded steps.
+ */
+class band_limited_buffer {
+public:
+    void set_rates(uint32_t clock_rate, uint32_t sample_rate, uint32_t max_samples);
+    void clear() noexcept;
+
+    /** clock_time is relative to the start of the current frame, the buffer grows if it is past its end */
+    void add_delta(uint64_t clock_time, int32_t delta);
+    void end_frame(uint64_t clock_duration) noexcept;
+
+    /** clocks to run until the given amount of samples is available */
+    [[nodiscard]] uint64_t clocks_needed(uint32_t sample_count) const noexcept;
+    [[nodiscard]] uint32_t samples_available() const noexcept { return static_cast<uint32_t>(offset_ >> time_bits); }
+
+    /** writes count samples to out, every stride elements */
+    void read_samples(int16_t* out, uint32_t count, size_t stride) noexcept;
+
+private:
+    static constexpr auto time_bits = 40u;
+    static constexpr auto phase_bits = 6u;
+    static constexpr auto phase_count = 1u << phase_bits;
+    static constexpr auto kernel_width = 16u;
+    static constexpr auto kernel_bits = 15u;
+
+    uint64_t factor_ = 0u;
+    uint64_t offset_ = 0u;
+    int64_t integrator_ = 0;
+
+    std::vector<int32_t> samples_;
+};
+
+} // namespace gameboy::audio
+
+#endif //GAMEBOY_BAND_LIMITED_BUFFER_H
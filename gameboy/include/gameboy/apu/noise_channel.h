@@ -4,6 +4,7 @@
 #include "gameboy/apu/data/envelope.h"
 #include "gameboy/apu/data/frequency_data.h"
 #include "gameboy/apu/data/polynomial_counter.h"
+#include "gameboy/util/state_buffer.h"
 
 namespace gameboy {
 
@@ -29,9 +30,15 @@ struct noise_channel {
     bool enabled = false;
     bool dac_enabled = false;
 
+    void save_state(state_writer& writer) const;
+    void load_state(state_reader& reader) noexcept;
+
     void on_write(register_index index, uint8_t data) noexcept;
 
-    void tick() noexcept;
+    /** steps the frequency timer by the given amount of cycles, jumping from edge to edge */
+    void advance(uint32_t cycles) noexcept;
+    /** cycles until the output may change on its own, none while the channel stays silent */
+    [[nodiscard]] uint64_t cycles_until_edge() const noexcept;
 
     void length_click() noexcept;
     void envelope_click() noexcept;
@@ -5,6 +5,7 @@
 #include "gameboy/apu/data/frequency_data.h"
 #include "gameboy/apu/data/sweep.h"
 #include "gameboy/apu/data/wave_data.h"
+#include "gameboy/util/state_buffer.h"
 
 namespace gameboy {
 
@@ -32,7 +33,13 @@ struct pulse_channel {
     bool enabled = false;
     bool dac_enabled = false;
 
-    void tick() noexcept;
+    void save_state(state_writer& writer) const;
+    void load_state(state_reader& reader) noexcept;
+
+    /** steps the frequency timer by the given amount of cycles, jumping from edge to edge */
+    void advance(uint32_t cycles) noexcept;
+    /** cycles until the output may change on its own, none while the channel stays silent */
+    [[nodiscard]] uint64_t cycles_until_edge() const noexcept;
 
     void on_write(register_index index, uint8_t data);
 
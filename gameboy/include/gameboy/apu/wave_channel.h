@@ -34,7 +34,10 @@ struct wave_channel {
 
     void on_write(register_index index, uint8_t data) noexcept;
 
-    void tick() noexcept;
+    /** steps the frequency timer by the given amount of cycles, jumping from edge to edge */
+    void advance(uint32_t cycles) noexcept;
+    /** cycles until the output may change on its own, none while the channel stays silent */
+    [[nodiscard]] uint64_t cycles_until_edge() const noexcept;
     void length_click() noexcept;
     void restart() noexcept;
     void disable() noexcept;
@@ -14,6 +14,7 @@ class apu;
 class timer;
 class joypad;
 class link;
+class scheduler;
 
 class bus {
 public:
@@ -28,6 +29,7 @@ public:
     [[nodiscard]] observer<timer> get_timer() const noexcept;
     [[nodiscard]] observer<joypad> get_joypad() const noexcept;
     [[nodiscard]] observer<link> get_link() const noexcept;
+    [[nodiscard]] observer<scheduler> get_scheduler() const noexcept;
 
 private:
     observer<gameboy> gb_;
@@ -1,6 +1,7 @@
 #ifndef GAMEBOY_CARTRIDGE_H
 #define GAMEBOY_CARTRIDGE_H
 
+#include <memory>
 #include <string>
 #include <string_view>
 #include <variant>
@@ -13,6 +14,7 @@
 #include "gameboy/memory/controller/mbc5.h"
 #include "gameboy/memory/controller/mbc_regular.h"
 #include "gameboy/util/fileutil.h"
+#include "gameboy/util/state_buffer.h"
 
 namespace gameboy {
 
@@ -31,17 +33,24 @@ class cartridge {
     friend instruction::disassembly_db;
 
 public:
+    static constexpr auto state_section = make_state_tag("CART");
+
     cartridge() : mbc_{mbc_regular(make_observer(this))} {}
     explicit cartridge(const filesystem::path& rom_path);
+    /** shares the rom of the other cartridge, the ram and the mbc are copied */
+    cartridge(const cartridge& other);
+    cartridge& operator=(const cartridge&) = delete;
 
     [[nodiscard]] uint8_t read_rom(const address16& address) const;
     void write_rom(const address16& address, uint8_t data);
 
+    /** host memory of the rom bank mapped to the 16kb region of the address, nullptr if it is out of bounds */
+    [[nodiscard]] const uint8_t* rom_bank_data(const address16& address) const noexcept;
+
     [[nodiscard]] uint8_t read_ram(const address16& address) const;
     void write_ram(const address16& address, uint8_t data);
 
-    [[nodiscard]] std::vector<uint8_t>& rom() noexcept { return rom_; }
-    [[nodiscard]] const std::vector<uint8_t>& rom() const noexcept { return rom_; }
+    [[nodiscard]] byte_view rom() const noexcept { return rom_->view(); }
     [[nodiscard]] uint32_t rom_bank_count() const noexcept { return rom_bank_count_; }
 
     [[nodiscard]] std::vector<uint8_t>& ram() noexcept { return ram_; }
@@ -59,6 +68,9 @@ public:
     void load_rom(const filesystem::path& rom_path);
     void save_ram_rtc() const;
 
+    void save_state(state_writer& writer) const;
+    void load_state(state_reader& reader) noexcept;
+
 private:
     filesystem::path rom_path_;
 
@@ -75,7 +87,8 @@ private:
     std::string_view ram_type_;
 
     std::string name_;
-    std::vector<uint8_t> rom_;
+    /** never modified, cartridges copied from this one share it */
+    std::shared_ptr<const file_buffer> rom_ = std::make_shared<const file_buffer>();
     std::vector<uint8_t> ram_;
 
     std::variant<mbc_regular, mbc1, mbc2, mbc3, mbc5> mbc_;
@@ -1,9 +1,16 @@
 #ifndef GAMEBOY_CPU_H
 #define GAMEBOY_CPU_H
 
+#include <array>
+#include <utility>
+#include <vector>
+
+#include "../../3rdparty/parallel-hashmap/parallel_hashmap/phmap.h"
+
 #include "gameboy/cpu/alu.h"
 #include "gameboy/cpu/interrupt.h"
 #include "gameboy/cpu/register16.h"
+#include "gameboy/util/state_buffer.h"
 
 #if WITH_DEBUGGER
 #include "gameboy/util/delegate.h"
@@ -25,16 +32,38 @@ class cpu {
     friend alu;
 
 public:
+    enum class execution_mode : uint8_t {
+        interpreter,
+        /** runs pre-decoded blocks of rom, wram and hram code */
+        cached_interpreter
+    };
+
+    static constexpr auto state_section = make_state_tag("CPU ");
+
     explicit cpu(observer<bus> bus) noexcept;
     void reset() noexcept;
 
+    void save_state(state_writer& writer) const;
+    void load_state(state_reader& reader) noexcept;
+
     [[nodiscard]] uint8_t tick();
 
+    [[nodiscard]] execution_mode get_execution_mode() const noexcept { return execution_mode_; }
+    void set_execution_mode(execution_mode mode) noexcept;
+
+    /** drops the cached blocks decoded from the given host memory, called by the mmu when code gets overwritten */
+    void invalidate_code(const uint8_t* code, size_t size) noexcept;
+
     [[nodiscard]] bool interrupts_enabled() const noexcept { return interrupt_master_enable_; }
     void process_interrupts() noexcept;
     void request_interrupt(interrupt request) noexcept;
 
     [[nodiscard]] bool is_stopped() const noexcept { return is_stopped_; }
+    /** true while halted with nothing to do until a component requests an interrupt */
+    [[nodiscard]] bool is_waiting_for_interrupt() const noexcept;
+    [[nodiscard]] bool has_pending_interrupt() const noexcept;
+    /** accounts for the halted cycles skipped at once by the gameboy */
+    void skip_halted_cycles(const uint64_t cycles) noexcept { total_cycles_ += cycles; }
     [[nodiscard]] bool is_in_double_speed() const noexcept;
 
 #if WITH_DEBUGGER
@@ -61,6 +90,34 @@ private:
     static constexpr struct imm8_t {} imm8{};
     static constexpr struct imm16_t {} imm16{};
 
+    /** operand index of (HL) in the register encoding of opcodes: B, C, D, E, H, L, (HL), A */
+    static constexpr uint8_t hl_indirect = 6u;
+
+    using instruction_handler = uint8_t (cpu::*)();
+    using decoded_instruction_handler = uint8_t (cpu::*)(uint16_t);
+
+    /** an instruction with its immediate already fetched */
+    struct decoded_instruction {
+        decoded_instruction_handler handler;
+        uint16_t address;
+        uint16_t data;
+        uint8_t length;
+    };
+
+    /** straight-line run of instructions, ends at control flow or at the end of a page */
+    struct code_block {
+        std::vector<decoded_instruction> instructions;
+        uint16_t size;
+    };
+
+    /** blocks keyed by the host memory they were decoded from, hence by rom bank or wram bank as well */
+    using code_block_cache = phmap::node_hash_map<const uint8_t*, code_block>;
+
+    static const std::array<instruction_handler, 256> standard_handlers_;
+    static const std::array<instruction_handler, 256> extended_handlers_;
+    static const std::array<decoded_instruction_handler, 256> decoded_standard_handlers_;
+    static const std::array<decoded_instruction_handler, 256> decoded_extended_handlers_;
+
     observer<bus> bus_;
 
     alu alu_;
@@ -94,6 +151,14 @@ private:
     int8_t wait_before_unhalt_cycles_;
     int8_t extra_cycles_;
 
+    execution_mode execution_mode_;
+
+    code_block_cache rom_blocks_;
+    code_block_cache ram_blocks_;
+    const decoded_instruction* block_cursor_;
+    const decoded_instruction* block_end_;
+    uint32_t block_mapping_generation_;
+
 #if WITH_DEBUGGER
     register16 prev_program_counter_;
     delegate<void(const address16&, const instruction::info&, uint16_t)> on_instruction_executed_;
@@ -111,6 +176,49 @@ private:
     [[nodiscard]] uint8_t decode(uint8_t inst, standard_instruction_set_t);
     [[nodiscard]] uint8_t decode(uint8_t inst, extended_instruction_set_t);
 
+    [[nodiscard]] uint8_t execute_next_instruction();
+    [[nodiscard]] uint8_t execute_cached_instruction();
+    [[nodiscard]] bool enter_block();
+    [[nodiscard]] code_block decode_block(const uint8_t* code, uint16_t address, uint16_t size_limit) const;
+    void clear_code_blocks() noexcept;
+
+    template<size_t... Opcodes>
+    static constexpr std::array<instruction_handler, sizeof...(Opcodes)> make_handlers(
+        std::index_sequence<Opcodes...>, standard_instruction_set_t) noexcept;
+    template<size_t... Opcodes>
+    static constexpr std::array<instruction_handler, sizeof...(Opcodes)> make_handlers(
+        std::index_sequence<Opcodes...>, extended_instruction_set_t) noexcept;
+    template<size_t... Opcodes>
+    static constexpr std::array<decoded_instruction_handler, sizeof...(Opcodes)> make_decoded_handlers(
+        std::index_sequence<Opcodes...>, standard_instruction_set_t) noexcept;
+    template<size_t... Opcodes>
+    static constexpr std::array<decoded_instruction_handler, sizeof...(Opcodes)> make_decoded_handlers(
+        std::index_sequence<Opcodes...>, extended_instruction_set_t) noexcept;
+
+    /* opcode handlers, generated from the bit fields of the opcode */
+    template<uint8_t Opcode>
+    [[nodiscard]] uint8_t standard_instruction();
+    template<uint8_t Opcode>
+    [[nodiscard]] uint8_t extended_instruction();
+    template<uint8_t Opcode>
+    [[nodiscard]] uint8_t execute(uint16_t data);
+    template<uint8_t Opcode>
+    [[nodiscard]] uint8_t execute_extended(uint16_t data);
+    template<uint8_t Opcode>
+    [[nodiscard]] uint8_t executed(uint16_t data, bool branch_taken);
+
+    template<uint8_t Operation, typename Operand>
+    void arithmetic(const Operand& operand);
+    template<uint8_t Condition>
+    [[nodiscard]] bool condition() noexcept;
+
+    template<uint8_t Index>
+    [[nodiscard]] register8& r8() noexcept;
+    template<uint8_t Index>
+    [[nodiscard]] register16& rp() noexcept;
+    template<uint8_t Index>
+    [[nodiscard]] register16& rp2() noexcept;
+
     void set_flag(flag flag) noexcept;
     void reset_flag(flag flag) noexcept;
     void flip_flag(flag flag) noexcept;
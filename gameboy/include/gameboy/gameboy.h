@@ -1,6 +1,8 @@
 #ifndef GAMEBOY_GAMEBOY_H
 #define GAMEBOY_GAMEBOY_H
 
+#include <memory>
+
 #include "gameboy/apu/apu.h"
 #include "gameboy/bus.h"
 #include "gameboy/cartridge.h"
@@ -9,9 +11,11 @@
 #include "gameboy/link/link.h"
 #include "gameboy/memory/mmu.h"
 #include "gameboy/ppu/ppu.h"
+#include "gameboy/scheduler.h"
 #include "gameboy/timer/timer.h"
 #include "gameboy/util/delegate.h"
 #include "gameboy/util/fileutil.h"
+#include "gameboy/util/state_buffer.h"
 
 namespace gameboy {
 
@@ -26,22 +30,54 @@ public:
     gameboy();
     explicit gameboy(const filesystem::path& rom_path);
 
+    gameboy(const gameboy&) = delete;
+    gameboy& operator=(const gameboy&) = delete;
+
+    /**
+     * An independent copy of the emulation that shares the rom with this one, null if the emulation
+     * could not be copied. Settings are carried over, pending audio samples are not. Callbacks are not
+     * carried over either, they have to be connected on the copy as on a new gameboy.
+     */
+    [[nodiscard]] std::unique_ptr<gameboy> clone() const;
+
     void tick();
     void tick_one_frame();
 
+    void set_execution_mode(const cpu::execution_mode mode) noexcept { cpu_.set_execution_mode(mode); }
+
     void load_rom(const filesystem::path& rom_path);
     void save_ram_rtc() const { cartridge_.save_ram_rtc(); }
 
+    /**
+     * Snapshots the emulation into the buffer, reusing its capacity. The state is only
+     * valid for the same rom and build, frames and pending audio samples are not included.
+     */
+    void save_state(std::vector<uint8_t>& buffer) const;
+    /**
+     * False if the state was made by another version, for another rom or is truncated, the emulation
+     * is then left untouched. If a section still fails to load after its layout was checked, the
+     * emulation is reset and false is returned.
+     */
+    bool load_state(const std::vector<uint8_t>& buffer);
+
     [[nodiscard]] const std::string& rom_name() const noexcept { return cartridge_.name(); }
 
     void on_render_line(const ppu::render_line_func on_render_line) noexcept { ppu_.on_render_line(on_render_line); }
     void on_vblank(const ppu::vblank_func on_vblank) noexcept { ppu_.on_vblank(on_vblank); }
+    void set_render_mode(const ppu::render_mode mode, const uint32_t frame_interval = 1u) noexcept { ppu_.set_render_mode(mode, frame_interval); }
+    void set_renderer(const ppu::renderer r) noexcept { ppu_.set_renderer(r); }
+    void set_pixel_format(const pixel_format format) { ppu_.set_pixel_format(format); }
+    [[nodiscard]] frame_view frame() const noexcept { return ppu_.frame(); }
+    [[nodiscard]] ppu::palette_table get_palette_table() const noexcept { return ppu_.get_palette_table(); }
     void set_gb_palette(const palette& palette) noexcept { ppu_.set_gb_palette(palette); }
+    void set_color_correction(const color_correction& correction) noexcept { ppu_.set_color_correction(correction); }
 
     [[maybe_unused]] void on_link_transfer_master(const link::transfer_func on_transfer) noexcept { link_.on_transfer_master(on_transfer); }
     [[maybe_unused]] [[nodiscard]] uint8_t on_link_transfer_slave(const uint8_t data) noexcept { return link_.on_transfer_slave(data); }
 
     void on_audio_buffer_full(const apu::sound_buffer_full_func on_buffer_full) noexcept { apu_.on_sound_buffer_full(on_buffer_full); }
+    void set_audio_sampling_rate(const uint32_t sampling_rate) { apu_.set_sampling_rate(sampling_rate); }
+    void set_audio_sample_size(const uint32_t sample_size) { apu_.set_sample_size(sample_size); }
 
     void press_key(const joypad::key key) noexcept { joypad_.press(key); }
     void release_key(const joypad::key key) noexcept { joypad_.release(key); }
@@ -51,6 +87,7 @@ public:
 private:
     cartridge cartridge_;
     bus bus_;
+    scheduler scheduler_;
 
     mmu mmu_;
     cpu cpu_;
@@ -60,7 +97,10 @@ private:
     joypad joypad_;
     timer timer_;
 
-    explicit gameboy(cartridge cart);
+    explicit gameboy(const cartridge& cart);
+
+    void reset();
+    void skip_halt();
 };
 
 } // namespace gameboy
@@ -4,6 +4,7 @@
 #include "gameboy/cpu/register8.h"
 #include "gameboy/memory/addressfwd.h"
 #include "gameboy/util/observer.h"
+#include "gameboy/util/state_buffer.h"
 
 namespace gameboy {
 
@@ -25,9 +26,15 @@ public:
         start = 1u << 7u
     };
 
+    static constexpr auto state_section = make_state_tag("JOY ");
+
     explicit joypad(observer<bus> bus);
     void reset() noexcept;
 
+    /** only the selected key group is saved, the keys held by the player are kept */
+    void save_state(state_writer& writer) const;
+    void load_state(state_reader& reader) noexcept;
+
     void press(key key) noexcept;
     void release(key key) noexcept;
 
@@ -6,6 +6,7 @@
 #include "gameboy/cpu/register8.h"
 #include "gameboy/util/delegate.h"
 #include "gameboy/util/observer.h"
+#include "gameboy/util/state_buffer.h"
 
 namespace gameboy {
 
@@ -23,10 +24,21 @@ public:
 
     using transfer_func = delegate<uint8_t(uint8_t)>;
 
+    static constexpr auto state_section = make_state_tag("LNK ");
+
     explicit link(observer<bus> bus) noexcept;
     void reset() noexcept;
 
-    void tick(uint8_t cycles) noexcept;
+    void save_state(state_writer& writer) const;
+    void load_state(state_reader& reader) noexcept;
+
+    /**
+     * catches up with the scheduler and reschedules the end of the transfer. every bit takes
+     * exactly one clock period, so a sync may shift several bits when the period is shorter
+     * than the time since the last sync
+     */
+    void sync() noexcept;
+    void schedule_transfer_end() noexcept;
 
     void on_transfer_master(const transfer_func on_transfer) { on_transfer_ = on_transfer; }
     uint8_t on_transfer_slave(uint8_t data) noexcept;
@@ -37,16 +49,19 @@ private:
     register8 sb_;
     register8 sc_;
 
+    uint64_t last_sync_cycle_;
     uint16_t shift_clock_;
     uint8_t shift_counter_;
     
     transfer_func on_transfer_;
     
+    void on_transfer_end() noexcept;
+
     void on_sb_write(const address16&, uint8_t data) noexcept;
-    [[nodiscard]] uint8_t on_sb_read(const address16&) const noexcept;
+    [[nodiscard]] uint8_t on_sb_read(const address16&) noexcept;
 
     void on_sc_write(const address16&, uint8_t data) noexcept;
-    [[nodiscard]] uint8_t on_sc_read(const address16&) const noexcept;
+    [[nodiscard]] uint8_t on_sc_read(const address16&) noexcept;
 
     [[nodiscard]] bool is_transferring() const noexcept;
     [[nodiscard]] uint16_t clock_rate() const noexcept;
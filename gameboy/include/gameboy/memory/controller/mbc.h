@@ -4,6 +4,7 @@
 #include <cstdint>
 
 #include "gameboy/util/observer.h"
+#include "gameboy/util/state_buffer.h"
 
 namespace gameboy {
 
@@ -13,11 +14,28 @@ class mbc {
 public:
     explicit mbc(const observer<cartridge> cartridge) : cartridge_{cartridge} {}
 
+    /** used when the cartridge is copied */
+    void set_cartridge(const observer<cartridge> cartridge) noexcept { cartridge_ = cartridge; }
+
     void set_ram_enabled(const uint8_t data) noexcept { ram_enabled_ = (data & 0x0Fu) == 0x0Au; }
     [[nodiscard]] bool is_ram_enabled() const noexcept { return ram_enabled_; }
     [[nodiscard]] uint32_t rom_bank() const noexcept { return rom_bank_; }
     [[nodiscard]] uint32_t ram_bank() const noexcept { return ram_bank_; }
 
+    void save_state(state_writer& writer) const
+    {
+        writer.write(rom_bank_);
+        writer.write(ram_bank_);
+        writer.write(ram_enabled_);
+    }
+
+    void load_state(state_reader& reader) noexcept
+    {
+        reader.read(rom_bank_);
+        reader.read(ram_bank_);
+        reader.read(ram_enabled_);
+    }
+
 protected:
     observer<cartridge> cartridge_;
 
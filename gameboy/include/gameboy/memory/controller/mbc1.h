@@ -21,6 +21,9 @@ public:
 
     [[nodiscard]] bool rom_banking_active() const noexcept { return rom_banking_active_; }
 
+    void save_state(state_writer& writer) const;
+    void load_state(state_reader& reader) noexcept;
+
 private:
     bool rom_banking_active_ = true;
 };
@@ -45,6 +45,9 @@ public:
 
     [[nodiscard]] std::pair<std::time_t, rtc> get_rtc_data() const noexcept { return std::make_pair(rtc_last_time_, rtc_); }
 
+    void save_state(state_writer& writer) const;
+    void load_state(state_reader& reader) noexcept;
+
 private:
     rtc rtc_;
     rtc rtc_latch_;
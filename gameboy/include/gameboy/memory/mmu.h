@@ -1,13 +1,15 @@
 #ifndef GAMEBOY_MMU_H
 #define GAMEBOY_MMU_H
 
+#include <array>
 #include <cstdint>
 #include <vector>
 
-#include "../../3rdparty/parallel-hashmap/parallel_hashmap/phmap.h"
 #include "gameboy/memory/address.h"
+#include "gameboy/memory/address_range.h"
 #include "gameboy/util/delegate.h"
 #include "gameboy/util/observer.h"
+#include "gameboy/util/state_buffer.h"
 
 namespace gameboy {
 
@@ -21,8 +23,8 @@ class disassembly_db;
 } // namespace instruction
 
 struct memory_delegate {
-    delegate<uint8_t(const address16&)> on_read;
-    delegate<void(const address16&, uint8_t)> on_write;
+    delegate<uint8_t(const address16&)> on_read{connect_arg<&memory_delegate::open_bus_read>};
+    delegate<void(const address16&, uint8_t)> on_write{connect_arg<&memory_delegate::open_bus_write>};
 
     memory_delegate() noexcept = default;
     memory_delegate(
@@ -30,6 +32,10 @@ struct memory_delegate {
         const delegate<void(const address16&, uint8_t)> on_write_delegate) noexcept
         : on_read{on_read_delegate},
           on_write{on_write_delegate} {}
+
+    /** default handlers of unmapped registers, reads return high bits and writes are ignored */
+    static uint8_t open_bus_read(const address16&) noexcept { return 0xFFu; }
+    static void open_bus_write(const address16&, uint8_t) noexcept {}
 };
 
 class mmu {
@@ -39,15 +45,33 @@ class mmu {
     friend instruction::disassembly_db;
 
 public:
+    static constexpr auto state_section = make_state_tag("MMU ");
+
     explicit mmu(observer<bus> bus);
     void reset() noexcept;
 
+    void save_state(state_writer& writer) const;
+    /** the cpu drops its cached wram code after this, as the code pages are no longer protected */
+    void load_state(state_reader& reader) noexcept;
+
     void write(const address16& address, uint8_t data);
     [[nodiscard]] uint8_t read(const address16& address) const;
 
     void dma(const address16& source, const address16& destination, uint16_t length);
 
-    void add_memory_delegate(const address16& address, const memory_delegate& callback) { delegates_[address] = callback; }
+    void add_memory_delegate(const address16& address, const memory_delegate& callback) noexcept;
+
+    /** remaps rom pages to the banks currently selected by the cartridge */
+    void map_rom_pages() noexcept;
+    /** maps vram pages for cpu reads to the given 8kb bank, nullptr routes reads back to the ppu */
+    void map_vram_pages(const uint8_t* vram_bank) noexcept;
+    /** incremented every time the rom or wram pages get remapped */
+    [[nodiscard]] uint32_t mapping_generation() const noexcept { return mapping_generation_; }
+
+    /** host memory of the code at the given address, nullptr if the region is not cacheable by the cpu */
+    [[nodiscard]] const uint8_t* code_pointer(const address16& address) const noexcept;
+    /** routes writes of the page containing the address through the slow path to detect self-modifying code */
+    void protect_code(const address16& address) noexcept;
 
 #if WITH_DEBUGGER
     void on_read_access(const delegate<void(const address16&)> on_read) noexcept { on_read_access_ = on_read; }
@@ -55,25 +79,48 @@ public:
 #endif //WITH_DEBUGGER
 
 private:
+    static constexpr auto page_count = 0x100u;
+    static constexpr auto page_size = 0x100u;
+    static constexpr auto io_register_count = 0x80u;
+
     observer<bus> bus_;
 
     uint8_t wram_bank_;
+    uint32_t mapping_generation_ = 0u;
+
+    /** host memory of every 256 byte page, nullptr means the access takes the slow path */
+    std::array<const uint8_t*, page_count> read_pages_;
+    std::array<uint8_t*, page_count> write_pages_;
 
     std::vector<uint8_t> work_ram_;
     std::vector<uint8_t> high_ram_;
 
-    phmap::flat_hash_map<address16, memory_delegate> delegates_;
+    /** physical wram pages and hram which hold code cached by the cpu */
+    std::vector<bool> wram_code_pages_;
+    bool hram_has_code_;
+
+    /** handlers of 0xFF00-0xFF7F indexed by the low 7 bits of the address, and IE */
+    std::array<memory_delegate, io_register_count> io_delegates_;
+    memory_delegate ie_delegate_;
 
 #if WITH_DEBUGGER
     delegate<void(const address16&)> on_read_access_;
     delegate<void(const address16&, uint8_t)> on_write_access_;
 #endif //WITH_DEBUGGER
 
+    void write_slow(const address16& address, uint8_t data);
+    [[nodiscard]] uint8_t read_slow(const address16& address) const;
+
+    void map_wram_pages() noexcept;
+    void map_pages(const address_range& range, const uint8_t* read_data, uint8_t* write_data) noexcept;
+
     void write_wram(const address16& address, uint8_t data);
-    [[nodiscard]] uint8_t read_wram(const address16& address) const;
     void write_hram(const address16& address, uint8_t data);
     [[nodiscard]] uint8_t read_hram(const address16& address) const;
 
+    [[nodiscard]] uint8_t svbk_read(const address16& address) const noexcept;
+    void svbk_write(const address16& address, uint8_t data) noexcept;
+
     [[nodiscard]] physical_address physical_wram_addr(const address16& address) const noexcept;
 };
 
@@ -0,0 +1,22 @@
+#ifndef GAMEBOY_COLOR_CORRECTION_H
+#define GAMEBOY_COLOR_CORRECTION_H
+
+#include <array>
+
+#include "gameboy/ppu/color.h"
+
+namespace gameboy {
+
+/**
+ * Converts 5 bit cgb colors to 8 bit screen colors. Channels are scaled to 8 bits first,
+ * then every output channel is mixed from them with a row of the matrix.
+ */
+struct color_correction {
+    std::array<std::array<float, 3>, 3> matrix;
+
+    [[nodiscard]] color apply(const color& cgb_color) const noexcept;
+};
+
+} // namespace gameboy
+
+#endif //GAMEBOY_COLOR_CORRECTION_H
@@ -7,8 +7,6 @@
 
 namespace gameboy::attributes {
 
-struct uninitialized {};
-
 struct bg {
     uint8_t attributes = 0u;
 
@@ -0,0 +1,102 @@
+#ifndef GAMEBOY_FRAMEBUFFER_H
+#define GAMEBOY_FRAMEBUFFER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "gameboy/ppu/color.h"
+#include "gameboy/ppu/line_compositor.h"
+
+namespace gameboy {
+
+enum class pixel_format : uint8_t {
+    /** r, g, b, a bytes */
+    rgba8888,
+    /** native endian 16 bit words, red in the high bits */
+    rgb565,
+    /**
+     * one byte per pixel, the 2 bit shade on dmg, the palette slot and color index on cgb.
+     * their colors are in ppu::get_palette_table
+     */
+    index
+};
+
+[[nodiscard]] constexpr size_t bytes_per_pixel(const pixel_format format) noexcept
+{
+    switch(format) {
+        case pixel_format::rgba8888: return 4u;
+        case pixel_format::rgb565: return 2u;
+        case pixel_format::index: return 1u;
+    }
+
+    return 0u;
+}
+
+/** read only view of a completed frame, valid until the next frame completes */
+class frame_view {
+public:
+    static constexpr auto width = 160u;
+    static constexpr auto height = 144u;
+
+    constexpr frame_view() noexcept = default;
+    constexpr frame_view(const uint8_t* data, const pixel_format format) noexcept
+        : data_{data}, format_{format} {}
+
+    [[nodiscard]] constexpr const uint8_t* data() const noexcept { return data_; }
+    [[nodiscard]] constexpr size_t size() const noexcept { return data_ ? pitch() * height : 0u; }
+    [[nodiscard]] constexpr bool empty() const noexcept { return size() == 0u; }
+
+    [[nodiscard]] constexpr const uint8_t* begin() const noexcept { return data_; }
+    [[nodiscard]] constexpr const uint8_t* end() const noexcept { return data_ + size(); }
+
+    [[nodiscard]] constexpr pixel_format format() const noexcept { return format_; }
+    [[nodiscard]] constexpr size_t pitch() const noexcept { return width * bytes_per_pixel(format_); }
+    [[nodiscard]] constexpr const uint8_t* line(const size_t line_number) const noexcept { return data_ + line_number * pitch(); }
+
+private:
+    const uint8_t* data_ = nullptr;
+    pixel_format format_ = pixel_format::rgba8888;
+};
+
+/**
+ * Two frames in one allocation. Lines are written into the back frame and
+ * the frames are swapped when the ppu enters vblank.
+ */
+class framebuffer {
+public:
+    static constexpr auto width = frame_view::width;
+    static constexpr auto height = frame_view::height;
+
+    explicit framebuffer(pixel_format format = pixel_format::rgba8888);
+
+    [[nodiscard]] pixel_format format() const noexcept { return format_; }
+    void set_format(pixel_format format);
+
+    void set_color(uint8_t color_table_index, const color& c) noexcept;
+    /** the byte written for a color table index in the index format */
+    void set_index(uint8_t color_table_index, uint8_t index) noexcept { indices_[color_table_index] = index; }
+
+    /** writes the pixels of the line from first_x up to last_x */
+    void write_line(uint8_t line_number, const std::array<uint8_t, width>& color_table_indices,
+      size_t first_x = 0u, size_t last_x = width) noexcept;
+    void swap() noexcept { back_frame_ ^= 1u; }
+
+    [[nodiscard]] frame_view front() const noexcept;
+
+private:
+    pixel_format format_;
+    size_t back_frame_ = 0u;
+    std::vector<uint8_t> frames_;
+
+    std::array<std::array<uint8_t, 4>, line_compositor::color_table_size> rgba8888_colors_{};
+    std::array<uint16_t, line_compositor::color_table_size> rgb565_colors_{};
+    std::array<uint8_t, line_compositor::color_table_size> indices_{};
+
+    [[nodiscard]] size_t frame_size() const noexcept { return width * height * bytes_per_pixel(format_); }
+};
+
+} // namespace gameboy
+
+#endif //GAMEBOY_FRAMEBUFFER_H
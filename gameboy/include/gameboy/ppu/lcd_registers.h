@@ -0,0 +1,33 @@
+#ifndef GAMEBOY_LCD_REGISTERS_H
+#define GAMEBOY_LCD_REGISTERS_H
+
+#include <type_traits>
+
+#include "gameboy/cpu/register8.h"
+#include "gameboy/ppu/register_lcdc.h"
+#include "gameboy/ppu/register_stat.h"
+
+namespace gameboy {
+
+constexpr auto cache_line_size = 64u;
+
+/** registers read on every drawn line, kept in a single cache line */
+struct alignas(cache_line_size) lcd_registers {
+    register_lcdc lcdc{0u};
+    register_stat stat{0u};
+
+    register8 ly;
+    register8 lyc;
+
+    register8 scx;
+    register8 scy;
+    register8 wx;
+    register8 wy;
+};
+
+static_assert(sizeof(lcd_registers) == cache_line_size);
+static_assert(std::is_trivially_copyable_v<lcd_registers>);
+
+} // namespace gameboy
+
+#endif //GAMEBOY_LCD_REGISTERS_H
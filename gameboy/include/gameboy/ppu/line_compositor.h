@@ -0,0 +1,59 @@
+#ifndef GAMEBOY_LINE_COMPOSITOR_H
+#define GAMEBOY_LINE_COMPOSITOR_H
+
+#include <array>
+#include <cstdint>
+
+namespace gameboy {
+
+/**
+ * Background and object layers of one scanline, every property in its own array
+ * so that the compositor can resolve a whole line with vector instructions.
+ */
+struct line_buffer {
+    static constexpr auto width = 160u;
+
+    static constexpr uint8_t bg_flag_present = 0x01u;
+    static constexpr uint8_t bg_flag_prioritized = 0x02u;
+    static constexpr uint8_t obj_flag_prioritized = 0x01u;
+
+    alignas(32) std::array<uint8_t, width> bg_color_indices;
+    alignas(32) std::array<uint8_t, width> bg_palettes;
+    alignas(32) std::array<uint8_t, width> bg_flags;
+
+    /** color index of the topmost opaque object, zero if there is none */
+    alignas(32) std::array<uint8_t, width> obj_color_indices;
+    alignas(32) std::array<uint8_t, width> obj_palettes;
+    /** set when any opaque object on the pixel is drawn above the background */
+    alignas(32) std::array<uint8_t, width> obj_flags;
+
+    void clear() noexcept;
+};
+
+namespace line_compositor {
+
+/** index of a pixel's color in a table of 8 bg palettes, 8 obj palettes and the blank color */
+constexpr uint8_t obj_color_offset = 32u;
+constexpr uint8_t blank_color_index = 64u;
+constexpr auto color_table_size = blank_color_index + 1u;
+
+enum class instruction_set {
+    scalar,
+    sse2,
+    avx2,
+    neon
+};
+
+using kernel = void(*)(const line_buffer& buffer, bool master_priority, uint8_t* color_table_indices) noexcept;
+
+/** nullptr if the running cpu cannot execute the kernel */
+[[nodiscard]] kernel get_kernel(instruction_set set) noexcept;
+
+/** the widest instruction set the running cpu supports, detected once */
+[[nodiscard]] instruction_set best_instruction_set() noexcept;
+
+} // namespace line_compositor
+
+} // namespace gameboy
+
+#endif //GAMEBOY_LINE_COMPOSITOR_H
@@ -0,0 +1,111 @@
+#ifndef GAMEBOY_PIXEL_FIFO_H
+#define GAMEBOY_PIXEL_FIFO_H
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+
+#include "gameboy/ppu/color.h"
+#include "gameboy/ppu/data/attributes.h"
+#include "gameboy/ppu/line_compositor.h"
+#include "gameboy/util/observer.h"
+#include "gameboy/util/state_buffer.h"
+
+namespace gameboy {
+
+class ppu;
+
+/**
+ * Draws a line dot by dot with the background fetcher and the pixel fifos of the lcd,
+ * so the length of mode 3 depends on scx, the window and the objects on the line,
+ * and register writes made while the line is drawn show up from the pixel they hit.
+ */
+class pixel_fifo {
+public:
+    static constexpr auto width = line_buffer::width;
+    static constexpr auto max_objs = 10u;
+
+    explicit pixel_fifo(observer<ppu> ppu) noexcept;
+
+    void start_line() noexcept;
+
+    /** runs mode 3 up to the given dot, true once the last pixel of the line is out */
+    [[nodiscard]] bool advance_to(uint32_t dot) noexcept;
+
+    /** mode 3 dots elapsed so far, its length once the line is finished */
+    [[nodiscard]] uint32_t dot() const noexcept { return dot_; }
+
+    /** a lower bound, no dot outputs more than one pixel */
+    [[nodiscard]] uint32_t dots_until_finished() const noexcept;
+
+    /** outputs the pixels drawn so far, called before a write changes how they are colored */
+    void flush() noexcept;
+
+    /** the line in progress, written as part of the ppu section */
+    void save_state(state_writer& writer) const;
+    void load_state(state_reader& reader) noexcept;
+
+private:
+    static constexpr auto fifo_size = 8u;
+
+    struct bg_pixel {
+        uint8_t color_index = 0u;
+        uint8_t palette = 0u;
+        uint8_t flags = 0u;
+    };
+
+    struct obj_pixel {
+        uint8_t color_index = 0u;
+        uint8_t palette = 0u;
+        uint8_t flags = 0u;
+        uint8_t oam_index = 0u;
+    };
+
+    observer<ppu> ppu_;
+
+    uint32_t dot_ = 0u;
+    uint8_t start_delay_ = 0u;
+    uint8_t discard_count_ = 0u;
+    size_t x_ = 0u;
+    size_t flushed_x_ = 0u;
+    bool render_ = false;
+
+    uint8_t fetcher_step_ = 0u;
+    uint8_t fetcher_x_ = 0u;
+    bool fetching_window_ = false;
+    bool window_drawn_ = false;
+    std::array<bg_pixel, fifo_size> fetched_pixels_{};
+
+    std::array<bg_pixel, fifo_size> bg_fifo_{};
+    size_t bg_fifo_head_ = fifo_size;
+
+    /** slot k holds the object pixel k pixels right of the current one */
+    std::array<obj_pixel, fifo_size> obj_fifo_{};
+    size_t obj_fifo_head_ = 0u;
+
+    /** objects of the line in oam order, with their oam indices */
+    std::array<attributes::obj, max_objs> objs_{};
+    std::array<uint8_t, max_objs> obj_indices_{};
+    uint8_t obj_count_ = 0u;
+    std::bitset<max_objs> fetched_objs_;
+    uint8_t obj_fetch_dots_ = 0u;
+    uint8_t obj_fetch_idx_ = 0u;
+
+    line_buffer buffer_;
+    std::array<color, width> line_colors_{};
+
+    void tick() noexcept;
+    void step_fetcher() noexcept;
+    void fetch_tile() noexcept;
+    void output_pixel() noexcept;
+    void finish_line() noexcept;
+
+    [[nodiscard]] bool find_obj(uint8_t& obj_idx) const noexcept;
+    void fetch_obj(uint8_t obj_idx) noexcept;
+    [[nodiscard]] bool window_triggered() const noexcept;
+};
+
+} // namespace gameboy
+
+#endif //GAMEBOY_PIXEL_FIFO_H
@@ -2,20 +2,24 @@
 #define GAMEBOY_PPU_H
 
 #include <array>
+#include <bitset>
 #include <initializer_list>
-#include <variant>
 #include <vector>
 
 #include "gameboy/memory/addressfwd.h"
 #include "gameboy/ppu/color.h"
+#include "gameboy/ppu/color_correction.h"
 #include "gameboy/ppu/data/attributes.h"
 #include "gameboy/ppu/data/interrupt_request.h"
 #include "gameboy/ppu/data/palette.h"
 #include "gameboy/ppu/dma_transfer_data.h"
-#include "gameboy/ppu/register_lcdc.h"
-#include "gameboy/ppu/register_stat.h"
+#include "gameboy/ppu/framebuffer.h"
+#include "gameboy/ppu/lcd_registers.h"
+#include "gameboy/ppu/line_compositor.h"
+#include "gameboy/ppu/pixel_fifo.h"
 #include "gameboy/util/delegate.h"
 #include "gameboy/util/observer.h"
+#include "gameboy/util/state_buffer.h"
 
 namespace gameboy {
 
@@ -29,16 +33,38 @@ static constexpr auto screen_height = 144u;
 
 using render_line = std::array<color, screen_width>;
 
+static_assert(line_buffer::width == screen_width);
+static_assert(framebuffer::width == screen_width && framebuffer::height == screen_height);
+static_assert(pixel_fifo::width == screen_width);
+
 class ppu {
     friend ppu_debugger;
     friend cpu_debugger;
     friend memory_bank_debugger;
+    friend pixel_fifo;
 
 public:
     using render_line_func = delegate<void(uint8_t, const render_line&)>;
     using vblank_func = delegate<void()>;
+    using palette_table = std::array<color, line_compositor::color_table_size>;
+
+    enum class render_mode : uint8_t {
+        full,
+        /** renders one frame out of every frame_interval */
+        skip_n,
+        /** keeps the lcd timing and interrupts but never draws */
+        timing_only
+    };
+
+    enum class renderer : uint8_t {
+        /** draws a whole line at once with a fixed mode 3 length */
+        scanline,
+        /** draws dot by dot, mode 3 gets longer with scx, the window and objects */
+        pixel_fifo
+    };
 
     static constexpr address16 ly_addr{0xFF44u};
+    static constexpr auto state_section = make_state_tag("PPU ");
     static constexpr palette palette_grayscale{
         color{255u},
         color{192u},
@@ -64,14 +90,49 @@ public:
         color{15, 56, 15}
     };
 
+    static constexpr color_correction color_correction_none{{{
+        {1.f, 0.f, 0.f},
+        {0.f, 1.f, 0.f},
+        {0.f, 0.f, 1.f}
+    }}};
+    /** approximates the washed out colors of the cgb lcd */
+    static constexpr color_correction color_correction_cgb_lcd{{{
+        {.8125f, .125f, .0625f},
+        {0.f, .75f, .25f},
+        {.1875f, .125f, .6875f}
+    }}};
+
     explicit ppu(observer<bus> bus);
     void reset() noexcept;
 
-    void tick(uint8_t cycles);
+    /** the frames are not part of the state, the display keeps the last frame until the next one completes */
+    void save_state(state_writer& writer) const;
+    void load_state(state_reader& reader) noexcept;
+    /** takes the render settings and the last frame of the other ppu, the callbacks stay as they are */
+    void copy_settings(const ppu& other);
+
     void on_render_line(const render_line_func on_render_line) noexcept { on_render_line_ = on_render_line; }
     void on_vblank(const vblank_func on_vblank) noexcept { on_vblank_ = on_vblank; }
 
-    void set_gb_palette(const palette& palette) noexcept { gb_palette_ = palette; }
+    /** takes effect immediately, skipped frames keep the last rendered frame on display */
+    void set_render_mode(render_mode mode, uint32_t frame_interval = 1u) noexcept;
+    [[nodiscard]] render_mode get_render_mode() const noexcept { return render_mode_; }
+
+    /** takes effect from the next line */
+    void set_renderer(const renderer r) noexcept { renderer_ = r; }
+    [[nodiscard]] renderer get_renderer() const noexcept { return renderer_; }
+
+    void set_pixel_format(const pixel_format format) { framebuffer_.set_format(format); }
+    /** the last completed frame */
+    [[nodiscard]] frame_view frame() const noexcept { return framebuffer_.front(); }
+    /**
+     * colors of the bytes of a pixel_format::index frame. dmg shades are the first four entries,
+     * cgb bytes index bg palettes from 0, obj palettes from 32 and the blank color at 64
+     */
+    [[nodiscard]] palette_table get_palette_table() const noexcept;
+
+    void set_gb_palette(const palette& palette) noexcept;
+    void set_color_correction(const color_correction& correction) noexcept;
 
     [[nodiscard]] uint8_t read_ram(const address16& address) const;
     void write_ram(const address16& address, uint8_t data);
@@ -80,14 +141,56 @@ public:
     void write_oam(const address16& address, uint8_t data);
 
 private:
-    using tile_attribute = std::variant<attributes::uninitialized, attributes::bg, attributes::obj>;
-    using render_buffer = std::array<std::pair<uint8_t, tile_attribute>, screen_width>;
-
     static constexpr auto map_tile_count = 32u;
     static constexpr auto tile_pixel_count = 8u;
     static constexpr auto map_pixel_count = map_tile_count * tile_pixel_count;
+    static constexpr auto tile_count = 384u;
+    static constexpr auto tile_size = tile_pixel_count * 2u;
+    static constexpr auto map_tiles_size = map_tile_count * map_tile_count;
+    static constexpr auto map_tiles_offset = tile_count * tile_size;
+    static constexpr auto obj_count = 40u;
+    static constexpr auto max_objs_per_line = pixel_fifo::max_objs;
+    static constexpr auto vram_bank_size = 8_kb;
+    static constexpr auto oam_size = obj_count * sizeof(attributes::obj);
+
+    /** color indices of a 2bpp tile row, decoded when vram is written */
+    struct decoded_tile_row {
+        std::array<uint8_t, tile_pixel_count> pixels;
+        std::array<uint8_t, tile_pixel_count> flipped_pixels;
+    };
+
+    /**
+     * a tile map drawn with its attributes, one plane for every line_buffer bg array.
+     * tiles are redrawn when their map entry or their tile data gets dirty
+     */
+    struct map_layer {
+        std::vector<uint8_t> color_indices;
+        std::vector<uint8_t> palettes;
+        std::vector<uint8_t> flags;
+        std::bitset<map_tiles_size> dirty_tiles;
+        /** tiles redrawn since the debugger last reset the bits */
+        std::bitset<map_tiles_size> redrawn_tiles;
+    };
+
+    /** oam indices of the objects that intersect a line, in oam order */
+    struct obj_line {
+        std::array<uint8_t, max_objs_per_line> indices;
+        uint8_t count;
+    };
 
     observer<bus> bus_;
+    line_compositor::kernel compositor_;
+
+    render_mode render_mode_;
+    uint32_t render_frame_interval_;
+    uint32_t frame_count_;
+    bool render_frame_;
+
+    renderer renderer_;
+    pixel_fifo pixel_fifo_;
+    /** the current line is drawn by pixel_fifo_ */
+    bool fifo_line_;
+    uint32_t mode3_cycles_;
 
     bool cgb_enabled_;
     bool lcd_enabled_;
@@ -96,24 +199,26 @@ private:
     uint8_t window_line_;
     int8_t lcd_enable_delay_frame_count_;
     int16_t lcd_enable_delay_cycle_count_;
+    uint64_t last_sync_cycle_;
     uint32_t cycle_count_;
     uint32_t secondary_cycle_count_;
     uint8_t vram_bank_;
 
-    std::vector<uint8_t> ram_;
-    std::vector<uint8_t> oam_;
+    /** both banks are kept on dmg too, the second one is never written */
+    alignas(cache_line_size) std::array<uint8_t, 2 * vram_bank_size> ram_;
+    alignas(cache_line_size) std::array<uint8_t, oam_size> oam_;
+    std::vector<decoded_tile_row> tile_cache_;
 
-    interrupt_request interrupt_request_;
-    register_lcdc lcdc_{0u};
-    register_stat stat_{0u};
+    std::array<map_layer, 2> map_layers_;
+    /** tiles written since the last time the map layers were checked for them */
+    std::bitset<2 * tile_count> dirty_tile_data_;
 
-    register8 ly_;
-    register8 lyc_;
+    /** rebuilt before rendering if an object's y or the object size changed since the last build */
+    std::array<obj_line, screen_height> obj_lines_;
+    bool obj_lines_dirty_;
 
-    register8 scx_;
-    register8 scy_;
-    register8 wx_;
-    register8 wy_;
+    interrupt_request interrupt_request_;
+    lcd_registers registers_;
 
     palette gb_palette_;
     register8 bgp_;
@@ -121,6 +226,11 @@ private:
 
     std::array<palette, 8> cgb_bg_palettes_;
     std::array<palette, 8> cgb_obj_palettes_;
+    color_correction color_correction_;
+
+    /** screen colors of all palettes, laid out as the compositor indexes them */
+    std::array<color, line_compositor::color_table_size> color_table_;
+    framebuffer framebuffer_;
     register8 bgpi_;
     register8 bgpd_;
     register8 obpi_;
@@ -131,6 +241,12 @@ private:
     render_line_func on_render_line_;
     vblank_func on_vblank_;
 
+    void sync();
+    void advance(uint32_t cycles);
+    void schedule_next_event() noexcept;
+    [[nodiscard]] uint32_t cycles_until_next_event() const noexcept;
+    void on_event();
+
     [[nodiscard]] uint8_t read_ram_by_bank(const address16& address, uint8_t bank) const;
     void write_ram_by_bank(const address16& address, uint8_t data, uint8_t bank);
 
@@ -143,11 +259,14 @@ private:
     [[nodiscard]] uint8_t palette_read(const address16& address) const;
     void palette_write(const address16& address, uint8_t data);
 
+    [[nodiscard]] bool fifo_drawing() const noexcept;
+
     void compare_coincidence() noexcept;
     void set_ly(const register8& ly) noexcept;
     void set_lyc(const register8& lyc) noexcept;
 
     void disable_screen() noexcept;
+    void map_vram() noexcept;
 
     void request_interrupt(interrupt_request::type type) noexcept;
     void request_interrupt(interrupt_request& irq, interrupt_request::type type) noexcept;
@@ -156,17 +275,33 @@ private:
     void hdma();
     void gdma();
     void render() noexcept;
+    void skip_render() noexcept;
+    void update_render_frame() noexcept;
+
+    void render_background(line_buffer& buffer) noexcept;
+    void render_window(line_buffer& buffer) noexcept;
+    [[nodiscard]] bool window_visible() const noexcept;
+    void render_obj(line_buffer& buffer) noexcept;
+    void update_obj_lines() noexcept;
 
-    void render_background(render_buffer& buffer) const noexcept;
-    void render_window(render_buffer& buffer) noexcept;
-    void render_obj(render_buffer& buffer) const noexcept;
+    void decode_tile_row(size_t ram_offset) noexcept;
 
-    [[nodiscard]] std::array<uint8_t, tile_pixel_count> get_tile_row(
-        uint8_t row, uint8_t tile_no, uint8_t bank) const noexcept;
-    [[nodiscard]] std::array<uint8_t, tile_pixel_count> get_tile_row(
-        uint8_t row, const address16& tile_base_addr, uint8_t bank) const noexcept;
+    void invalidate_map_layers() noexcept;
+    void propagate_dirty_tile_data() noexcept;
+    void update_map_layer_row(size_t map_idx, uint32_t tile_row) noexcept;
+    void draw_map_tile(size_t map_idx, uint32_t map_tile_idx) noexcept;
+    void copy_map_layer(size_t map_idx, size_t map_pixel_idx, line_buffer& buffer, size_t x, size_t count) const noexcept;
 
-    [[nodiscard]] static color correct_color(const color& c) noexcept;
+    [[nodiscard]] const std::array<uint8_t, tile_pixel_count>& get_tile_row(
+        uint8_t row, uint8_t tile_no, uint8_t bank, bool h_flipped) const noexcept;
+    [[nodiscard]] const std::array<uint8_t, tile_pixel_count>& get_tile_row(
+        uint8_t row, const address16& tile_base_addr, uint8_t bank, bool h_flipped) const noexcept;
+
+    void set_table_color(size_t color_table_index, const color& c) noexcept;
+    void update_gb_colors() noexcept;
+    void update_cgb_colors() noexcept;
+
+    [[nodiscard]] color correct_color(const color& c) const noexcept { return color_correction_.apply(c); }
 
     template<typename T>
     [[nodiscard]] static address16 tile_address(const uint32_t base_addr, const uint8_t tile_no)
@@ -175,6 +310,9 @@ private:
     }
 };
 
+// vram, oam and the lcd registers start on their own cache lines
+static_assert(alignof(ppu) == cache_line_size);
+
 } // namespace gameboy
 
 #endif //GAMEBOY_PPU_H
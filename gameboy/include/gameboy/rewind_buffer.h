@@ -0,0 +1,69 @@
+#ifndef GAMEBOY_REWIND_BUFFER_H
+#define GAMEBOY_REWIND_BUFFER_H
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "gameboy/memory/address.h"
+#include "gameboy/util/observer.h"
+
+namespace gameboy {
+
+class gameboy;
+
+/**
+ * Keeps the recent history of the emulation in a fixed amount of memory.
+ * The newest snapshot is kept as it is, every older one is stored as the run-length
+ * encoded xor of itself and the snapshot after it, so a step back decodes a single
+ * delta. When the memory runs out, the oldest snapshots are dropped.
+ */
+class rewind_buffer {
+public:
+    struct config {
+        /** memory of the encoded snapshots, the newest snapshot is kept outside of it */
+        size_t memory_budget = 4096_kb;
+        /** a snapshot is taken once every this many frames */
+        uint32_t frame_interval = 2u;
+    };
+
+    explicit rewind_buffer(observer<gameboy> gb);
+    rewind_buffer(observer<gameboy> gb, const config& cfg);
+
+    void set_config(const config& cfg);
+    [[nodiscard]] const config& get_config() const noexcept { return config_; }
+
+    /** called after every emulated frame, takes a snapshot when the interval is up */
+    void on_frame();
+    /** loads the newest snapshot and forgets it, false if there is no history left */
+    bool step_back();
+    void clear() noexcept;
+
+    [[nodiscard]] size_t snapshot_count() const noexcept;
+    [[nodiscard]] size_t memory_used() const noexcept;
+
+private:
+    /** a delta stored in the ring */
+    struct record {
+        size_t offset;
+        size_t size;
+    };
+
+    observer<gameboy> gb_;
+    config config_;
+    uint32_t frame_count_ = 0u;
+
+    std::vector<uint8_t> storage_;
+    std::deque<record> records_;
+    size_t stored_size_ = 0u;
+
+    std::vector<uint8_t> latest_;
+    std::vector<uint8_t> state_;
+    std::vector<uint8_t> delta_;
+
+    void push(const std::vector<uint8_t>& delta);
+};
+
+} // namespace gameboy
+
+#endif //GAMEBOY_REWIND_BUFFER_H
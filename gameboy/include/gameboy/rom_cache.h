@@ -0,0 +1,19 @@
+#ifndef GAMEBOY_ROM_CACHE_H
+#define GAMEBOY_ROM_CACHE_H
+
+#include <memory>
+
+#include "gameboy/util/fileutil.h"
+
+namespace gameboy::rom_cache {
+
+/**
+ * The rom at the path, shared with every cartridge in the process that holds the same rom.
+ * The file is read or mapped again only if its size or modification time changed, and files
+ * with the same contents share one buffer. Roms are dropped once no cartridge holds them.
+ */
+[[nodiscard]] std::shared_ptr<const file_buffer> load(const filesystem::path& rom_path);
+
+} // namespace gameboy::rom_cache
+
+#endif //GAMEBOY_ROM_CACHE_H
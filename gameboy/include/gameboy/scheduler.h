@@ -0,0 +1,65 @@
+#ifndef GAMEBOY_SCHEDULER_H
+#define GAMEBOY_SCHEDULER_H
+
+#include <array>
+#include <cstdint>
+#include <limits>
+
+#include "gameboy/util/delegate.h"
+#include "gameboy/util/state_buffer.h"
+
+namespace gameboy {
+
+/**
+ * Keeps the cycle timestamp of the emulation and the next deadline of every component.
+ * Components catch up lazily when their registers are accessed and register a deadline
+ * for the next moment they have to act on their own, e.g. raise an interrupt.
+ */
+class scheduler {
+public:
+    /** events sharing a deadline are dispatched in declaration order */
+    enum class event : uint8_t {
+        timer,
+        apu,
+        ppu,
+        link,
+        count
+    };
+
+    using event_func = delegate<void()>;
+
+    static constexpr auto no_deadline = std::numeric_limits<uint64_t>::max();
+    static constexpr auto state_section = make_state_tag("SCHD");
+
+    scheduler() noexcept;
+    void reset() noexcept;
+
+    void save_state(state_writer& writer) const;
+    void load_state(state_reader& reader) noexcept;
+
+    /** moves the time forward and dispatches the events which became due */
+    void advance(uint64_t cycles);
+
+    void add_event_delegate(event e, event_func on_event) noexcept;
+    void schedule(event e, uint64_t cycle) noexcept;
+    void cancel(event e) noexcept;
+
+    /** cycle of the start of the instruction being executed, components are synchronised up to this point */
+    [[nodiscard]] uint64_t now() const noexcept { return now_; }
+    [[nodiscard]] uint64_t next_deadline() const noexcept { return next_deadline_; }
+
+private:
+    static constexpr auto event_count = static_cast<size_t>(event::count);
+
+    uint64_t now_;
+    uint64_t next_deadline_;
+
+    std::array<uint64_t, event_count> deadlines_;
+    std::array<event_func, event_count> event_delegates_;
+
+    void find_next_deadline() noexcept;
+};
+
+} // namespace gameboy
+
+#endif //GAMEBOY_SCHEDULER_H
@@ -4,6 +4,7 @@
 #include "gameboy/cpu/register8.h"
 #include "gameboy/util/mathutil.h"
 #include "gameboy/util/observer.h"
+#include "gameboy/util/state_buffer.h"
 
 namespace gameboy {
 
@@ -14,16 +15,30 @@ class timer {
     friend timer_debugger;
 
 public:
+    static constexpr auto state_section = make_state_tag("TIM ");
+
     explicit timer(observer<bus> bus);
     void reset() noexcept;
 
-    void tick(uint8_t cycles);
+    void save_state(state_writer& writer) const;
+    void load_state(state_reader& reader) noexcept;
+
+    /** advances the timer by the given amount of cpu clocks */
+    void advance(uint64_t cycles) noexcept;
+
+    /** catches up with the scheduler, the elapsed cycles are counted with the current cpu speed */
+    void sync() noexcept;
+    void schedule_overflow() noexcept;
+
+    /** scheduler cycle at which the next timer interrupt is requested */
+    [[nodiscard]] uint64_t next_overflow_cycle() const noexcept;
 
 private:
     observer<bus> bus_;
 
+    uint64_t last_sync_cycle_;
     uint16_t internal_clock_;
-    int8_t tima_reload_cycles_;
+    uint8_t tima_reload_cycles_;
     uint8_t timer_clock_overflow_bit_;
 
     register8 tima_;
@@ -31,12 +46,15 @@ private:
     register8 tac_;
 
     bool enabled_;
-    bool previous_tima_reload_bit_;
 
-    void update_internal_clock(uint16_t new_internal_clock) noexcept;
+    void on_overflow() noexcept;
+    void increment_tima() noexcept;
+
+    [[nodiscard]] bool timer_clock_bit() const noexcept;
+    [[nodiscard]] uint64_t clocks_until_overflow() const noexcept;
     [[nodiscard]] uint8_t timer_clock_overflow_index_select() const noexcept;
 
-    [[nodiscard]] uint8_t on_read(const address16& address) const noexcept;
+    [[nodiscard]] uint8_t on_read(const address16& address) noexcept;
     void on_write(const address16& address, uint8_t data) noexcept;
 };
 
@@ -0,0 +1,36 @@
+#ifndef GAMEBOY_BYTE_VIEW_H
+#define GAMEBOY_BYTE_VIEW_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gameboy {
+
+/** read only view of contiguous bytes, it does not own them */
+class byte_view {
+public:
+    constexpr byte_view() noexcept = default;
+    constexpr byte_view(const uint8_t* data, const size_t size) noexcept
+        : data_{data}, size_{size} {}
+    /** implicit so that buffers can be passed where a view is expected */
+    byte_view(const std::vector<uint8_t>& bytes) noexcept
+        : data_{bytes.data()}, size_{bytes.size()} {}
+
+    [[nodiscard]] constexpr const uint8_t* data() const noexcept { return data_; }
+    [[nodiscard]] constexpr size_t size() const noexcept { return size_; }
+    [[nodiscard]] constexpr bool empty() const noexcept { return size_ == 0u; }
+
+    [[nodiscard]] constexpr const uint8_t* begin() const noexcept { return data_; }
+    [[nodiscard]] constexpr const uint8_t* end() const noexcept { return data_ + size_; }
+
+    [[nodiscard]] constexpr const uint8_t& operator[](const size_t idx) const noexcept { return data_[idx]; }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0u;
+};
+
+} // namespace gameboy
+
+#endif //GAMEBOY_BYTE_VIEW_H
@@ -5,11 +5,51 @@
 #include <filesystem>
 #include <vector>
 
+#include "gameboy/util/byte_view.h"
+
 namespace gameboy {
 
 namespace filesystem = std::filesystem;
 
-std::vector<uint8_t> read_file(const filesystem::path& path);
+/**
+ * Read only contents of a file. Large files are mapped into memory where the platform
+ * supports it, smaller ones and everything else are read at once into an owned buffer.
+ * A mapped file must not be truncated while its buffer is alive.
+ */
+class file_buffer {
+public:
+    file_buffer() noexcept = default;
+    /** terminates if the file cannot be read */
+    explicit file_buffer(const filesystem::path& path);
+    ~file_buffer();
+
+    file_buffer(const file_buffer&) = delete;
+    file_buffer& operator=(const file_buffer&) = delete;
+    file_buffer(file_buffer&& other) noexcept;
+    file_buffer& operator=(file_buffer&& other) noexcept;
+
+    [[nodiscard]] byte_view view() const noexcept { return byte_view{data_, size_}; }
+    [[nodiscard]] const uint8_t* data() const noexcept { return data_; }
+    [[nodiscard]] size_t size() const noexcept { return size_; }
+    [[nodiscard]] bool empty() const noexcept { return size_ == 0u; }
+
+    [[nodiscard]] const uint8_t* begin() const noexcept { return data_; }
+    [[nodiscard]] const uint8_t* end() const noexcept { return data_ + size_; }
+
+    [[nodiscard]] const uint8_t& operator[](const size_t idx) const noexcept { return data_[idx]; }
+
+    [[nodiscard]] bool is_mapped() const noexcept { return mapped_; }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0u;
+    bool mapped_ = false;
+    std::vector<uint8_t> bytes_;
+
+    void release() noexcept;
+};
+
+[[nodiscard]] file_buffer read_file(const filesystem::path& path);
 void write_file(const filesystem::path&  path, const std::vector<uint8_t>& data);
 
 } // namespace gameboy
@@ -0,0 +1,114 @@
+#ifndef GAMEBOY_STATE_BUFFER_H
+#define GAMEBOY_STATE_BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace gameboy {
+
+/** four characters identifying a section of a save state */
+using state_tag = uint32_t;
+
+[[nodiscard]] constexpr state_tag make_state_tag(const char (&name)[5]) noexcept
+{
+    return static_cast<uint32_t>(static_cast<uint8_t>(name[0]))
+        | static_cast<uint32_t>(static_cast<uint8_t>(name[1])) << 8u
+        | static_cast<uint32_t>(static_cast<uint8_t>(name[2])) << 16u
+        | static_cast<uint32_t>(static_cast<uint8_t>(name[3])) << 24u;
+}
+
+/**
+ * Appends sections of raw values to a buffer. A section is its tag, the size of its
+ * payload and the payload, values are copied in host byte order. Types with padding
+ * are rejected so that the same emulation always gives the same bytes, their fields
+ * are written one by one instead.
+ */
+class state_writer {
+public:
+    /** clears the buffer, its capacity is reused */
+    explicit state_writer(std::vector<uint8_t>& buffer) noexcept
+        : buffer_{buffer}
+    {
+        buffer_.clear();
+    }
+
+    void begin_section(state_tag tag);
+    void end_section() noexcept;
+
+    template<typename T>
+    void write(const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        static_assert(std::has_unique_object_representations_v<T> || std::is_floating_point_v<T>);
+        write_bytes(&value, sizeof(T));
+    }
+
+    void write_bytes(const void* data, const size_t size)
+    {
+        const auto offset = buffer_.size();
+        buffer_.resize(offset + size);
+        std::memcpy(buffer_.data() + offset, data, size);
+    }
+
+private:
+    std::vector<uint8_t>& buffer_;
+    size_t section_offset_ = 0u;
+};
+
+/**
+ * Reads back what a state_writer wrote. Reading past the end of a section or a
+ * section with an unexpected tag fails the reader, after which reads leave values untouched.
+ */
+class state_reader {
+public:
+    state_reader(const uint8_t* data, const size_t size) noexcept
+        : data_{data}, size_{size}, section_end_{size} {}
+    explicit state_reader(const std::vector<uint8_t>& buffer) noexcept
+        : state_reader{buffer.data(), buffer.size()} {}
+
+    [[nodiscard]] bool ok() const noexcept { return ok_; }
+    void fail() noexcept { ok_ = false; }
+
+    /** true if the next section has the given tag and fits in the buffer */
+    bool begin_section(state_tag tag) noexcept;
+    /** true if the section was read to its end */
+    bool end_section() noexcept;
+    /** skips the next section, true if it has the given tag and fits in the buffer */
+    bool skip_section(state_tag tag) noexcept;
+
+    template<typename T>
+    void read(T& value) noexcept
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        read_bytes(&value, sizeof(T));
+    }
+
+    void read_bytes(void* data, const size_t size) noexcept
+    {
+        if(!ok_ || section_end_ - offset_ < size) {
+            ok_ = false;
+            return;
+        }
+
+        std::memcpy(data, data_ + offset_, size);
+        offset_ += size;
+    }
+
+    [[nodiscard]] bool at_end() const noexcept { return offset_ == size_; }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    size_t offset_ = 0u;
+    size_t section_end_;
+    bool ok_ = true;
+
+    bool read_section_header(state_tag& tag, uint32_t& size) noexcept;
+};
+
+} // namespace gameboy
+
+#endif //GAMEBOY_STATE_BUFFER_H
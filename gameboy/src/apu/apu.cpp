@@ -1,7 +1,12 @@
 #include "gameboy/apu/apu.h"
 
+#include <algorithm>
+
+#include <spdlog/spdlog.h>
+
 #include "gameboy/bus.h"
 #include "gameboy/memory/mmu.h"
+#include "gameboy/scheduler.h"
 
 namespace gameboy {
 
@@ -41,10 +46,12 @@ constexpr std::array apu_register_addresses{
 
 constexpr auto frame_sequence_count = 8192u;
 constexpr auto frame_sequencer_max = 8u;
-constexpr auto down_sample_count = 4'194'304u / 44100u; // cpu clock speed / sample rate
+constexpr auto clock_rate = 4'194'304u; // scheduler cycles per second, regardless of the cpu speed
 
 apu::apu(const observer<bus> bus)
-    : bus_{bus}
+    : bus_{bus},
+      sampling_rate_{default_sampling_rate},
+      sample_size_{default_sample_size}
 {
     reset();
 }
@@ -93,13 +100,9 @@ void apu::reset() noexcept
         register8{0xF3u}
     };
 
+    last_sync_cycle_ = 0u;
     frame_sequencer_counter_ = frame_sequence_count;
-    buffer_fill_amount_ = 0u;
     frame_sequencer_ = 0u;
-    down_sample_counter_ = down_sample_count;
-
-    sound_buffer_.resize(sample_size);
-    std::fill(begin(sound_buffer_), end(sound_buffer_), 0u);
 
     channel_1_.enabled = true;
 
@@ -119,15 +122,86 @@ void apu::reset() noexcept
         });
     }
 
-#if WITH_DEBUGGER
-    sound_buffer_1_.resize(sample_size / 2, 0.f);
-    sound_buffer_2_.resize(sample_size / 2, 0.f);
-    sound_buffer_3_.resize(sample_size / 2, 0.f);
-    sound_buffer_4_.resize(sample_size / 2, 0.f);
-#endif //WITH_DEBUGGER
+    bus_->get_scheduler()->add_event_delegate(scheduler::event::apu, {connect_arg<&apu::on_buffer_full_deadline>, this});
+    reset_sound_buffers();
+}
+
+void apu::save_state(state_writer& writer) const
+{
+    writer.begin_section(state_section);
+    writer.write(power_on_);
+    channel_1_.save_state(writer);
+    channel_2_.save_state(writer);
+    writer.write(channel_3_);
+    channel_4_.save_state(writer);
+    writer.write(control_);
+    writer.write(last_sync_cycle_);
+    writer.write(frame_sequencer_counter_);
+    writer.write(frame_sequencer_);
+    writer.end_section();
+}
+
+void apu::load_state(state_reader& reader) noexcept
+{
+    if(!reader.begin_section(state_section)) {
+        return;
+    }
+
+    reader.read(power_on_);
+    channel_1_.load_state(reader);
+    channel_2_.load_state(reader);
+    reader.read(channel_3_);
+    channel_4_.load_state(reader);
+    reader.read(control_);
+    reader.read(last_sync_cycle_);
+    reader.read(frame_sequencer_counter_);
+    reader.read(frame_sequencer_);
+    reader.end_section();
+
+    update_amplitudes();
+    bus_->get_scheduler()->schedule(scheduler::event::apu, last_sync_cycle_ + cycles_until_buffer_full_);
+}
+
+void apu::copy_settings(const apu& other)
+{
+    sync();
+    sampling_rate_ = other.sampling_rate_;
+    sample_size_ = other.sample_size_;
+    reset_sound_buffers();
 }
 
-void apu::tick(uint8_t cycles) noexcept
+void apu::set_sampling_rate(const uint32_t sampling_rate)
+{
+    if(sampling_rate == 0u) {
+        spdlog::critical("apu: sampling rate cannot be zero");
+        std::terminate();
+    }
+
+    sync();
+    sampling_rate_ = sampling_rate;
+    reset_sound_buffers();
+}
+
+void apu::set_sample_size(const uint32_t sample_size)
+{
+    if(sample_size < 2u) {
+        spdlog::critical("apu: sample size must hold at least one sample per terminal");
+        std::terminate();
+    }
+
+    sync();
+    sample_size_ = sample_size & ~1u;
+    reset_sound_buffers();
+}
+
+void apu::sync() noexcept
+{
+    const auto now = bus_->get_scheduler()->now();
+    advance(now - last_sync_cycle_);
+    last_sync_cycle_ = now;
+}
+
+void apu::advance(uint64_t cycles) noexcept
 {
     const auto length_click = [&]() {
         channel_1_.length_click();
@@ -136,7 +210,7 @@ void apu::tick(uint8_t cycles) noexcept
         channel_4_.length_click();
     };
 
-    for(; cycles > 0; --cycles, --frame_sequencer_counter_) {
+    while(cycles > 0) {
         if(frame_sequencer_counter_ == 0u) {
             frame_sequencer_counter_ = frame_sequence_count;
             switch(frame_sequencer_) {
@@ -162,66 +236,144 @@ void apu::tick(uint8_t cycles) noexcept
             if(frame_sequencer_ == frame_sequencer_max) {
                 frame_sequencer_ = 0u;
             }
+
+            update_amplitudes();
         }
 
-        channel_1_.tick();
-        channel_2_.tick();
-        channel_3_.tick();
-        channel_4_.tick();
+        // outputs only change on channel edges and sequencer steps, so every span is a single step in the output
+        const auto span = std::min({
+          cycles, uint64_t{frame_sequencer_counter_}, cycles_until_buffer_full_,
+          channel_1_.cycles_until_edge(), channel_2_.cycles_until_edge(),
+          channel_3_.cycles_until_edge(), channel_4_.cycles_until_edge()});
 
-        --down_sample_counter_;
-        if(down_sample_counter_ == 0u) {
-            down_sample_counter_ = down_sample_count;
+        channel_1_.advance(static_cast<uint32_t>(span));
+        channel_2_.advance(static_cast<uint32_t>(span));
+        channel_3_.advance(static_cast<uint32_t>(span));
+        channel_4_.advance(static_cast<uint32_t>(span));
 
-            generate_samples();
+        cycles -= span;
+        frame_sequencer_counter_ -= static_cast<uint16_t>(span);
+        frame_cycles_ += span;
+        cycles_until_buffer_full_ -= span;
 
-            if(buffer_fill_amount_ == sample_size) {
-                buffer_fill_amount_ = 0u;
-                on_buffer_full_(sound_buffer_);
-                break;
-            }
+        update_amplitudes();
+
+        if(cycles_until_buffer_full_ == 0u) {
+            flush_sound_buffer();
         }
     }
 }
 
-void apu::generate_samples() noexcept
+void apu::update_amplitudes() noexcept
 {
     const std::array channel_outputs{
-        static_cast<float>(channel_1_.output) / 15.f,
-        static_cast<float>(channel_2_.output) / 15.f,
-        static_cast<float>(channel_3_.output) / 15.f,
-        static_cast<float>(channel_4_.output) / 15.f,
+        channel_1_.output,
+        channel_2_.output,
+        channel_3_.output,
+        channel_4_.output,
     };
 
 #if WITH_DEBUGGER
-    sound_buffer_1_[buffer_fill_amount_ / 2] = channel_outputs[0];
-    sound_buffer_2_[buffer_fill_amount_ / 2] = channel_outputs[1];
-    sound_buffer_3_[buffer_fill_amount_ / 2] = channel_outputs[2];
-    sound_buffer_4_[buffer_fill_amount_ / 2] = channel_outputs[3];
+    const auto debug_fill_end = std::min<uint64_t>(frame_cycles_ * sampling_rate_ / clock_rate, sound_buffer_1_.size());
+    for(; buffer_fill_amount_ < debug_fill_end; ++buffer_fill_amount_) {
+        sound_buffer_1_[buffer_fill_amount_] = static_cast<float>(channel_outputs[0]) / 15.f;
+        sound_buffer_2_[buffer_fill_amount_] = static_cast<float>(channel_outputs[1]) / 15.f;
+        sound_buffer_3_[buffer_fill_amount_] = static_cast<float>(channel_outputs[2]) / 15.f;
+        sound_buffer_4_[buffer_fill_amount_] = static_cast<float>(channel_outputs[3]) / 15.f;
+    }
 #endif //WITH_DEBUGGER
 
-    const auto sample_for_terminal = [&](const audio::control::terminal terminal) {
-        constexpr auto amplitude = 30000.f;
-        float sample = 0.f;
+    const auto amplitude_for_terminal = [&](const audio::control::terminal terminal) {
+        constexpr auto amplitude = 30000;
+        constexpr auto max_channel_output = 15;
+        constexpr auto max_terminal_volume = 7;
 
-        for(auto channel_no = 0; channel_no < channel_outputs.size(); ++channel_no) {
+        int32_t sum = 0;
+        for(uint8_t channel_no = 0; channel_no < channel_outputs.size(); ++channel_no) {
             if(control_.channel_enabled_on_terminal(channel_no, terminal)) {
-                sample += channel_outputs[channel_no];
+                sum += channel_outputs[channel_no];
             }
         }
 
-        sample /= channel_outputs.size();
-
-        const auto terminal_volume = control_.terminal_volume<float>(terminal) / 7.f;
-        sound_buffer_[buffer_fill_amount_++] = sample * terminal_volume * amplitude;
+        return sum * control_.terminal_volume<int32_t>(terminal) * amplitude /
+            (max_channel_output * static_cast<int32_t>(channel_outputs.size()) * max_terminal_volume);
     };
 
-    sample_for_terminal(audio::control::terminal::left);
-    sample_for_terminal(audio::control::terminal::right);
+    if(const auto left = amplitude_for_terminal(audio::control::terminal::left); left != left_amplitude_) {
+        left_buffer_.add_delta(frame_cycles_, left - left_amplitude_);
+        left_amplitude_ = left;
+    }
+
+    if(const auto right = amplitude_for_terminal(audio::control::terminal::right); right != right_amplitude_) {
+        right_buffer_.add_delta(frame_cycles_, right - right_amplitude_);
+        right_amplitude_ = right;
+    }
+}
+
+void apu::flush_sound_buffer() noexcept
+{
+    const auto samples_per_terminal = sample_size_ / 2u;
+
+    left_buffer_.end_frame(frame_cycles_);
+    right_buffer_.end_frame(frame_cycles_);
+    frame_cycles_ = 0u;
+
+    left_buffer_.read_samples(sound_buffer_.data(), samples_per_terminal, 2u);
+    right_buffer_.read_samples(sound_buffer_.data() + 1u, samples_per_terminal, 2u);
+    cycles_until_buffer_full_ = left_buffer_.clocks_needed(samples_per_terminal);
+
+#if WITH_DEBUGGER
+    buffer_fill_amount_ = 0u;
+#endif //WITH_DEBUGGER
+
+    if(on_buffer_full_) {
+        on_buffer_full_(sound_buffer_);
+    }
+}
+
+void apu::reset_sound_buffers()
+{
+    const auto samples_per_terminal = sample_size_ / 2u;
+
+    sound_buffer_.assign(sample_size_, 0);
+    left_buffer_.set_rates(clock_rate, sampling_rate_, samples_per_terminal);
+    right_buffer_.set_rates(clock_rate, sampling_rate_, samples_per_terminal);
+
+    frame_cycles_ = 0u;
+    cycles_until_buffer_full_ = left_buffer_.clocks_needed(samples_per_terminal);
+
+    // the buffers start from silence, the current output is the first step
+    left_amplitude_ = 0;
+    right_amplitude_ = 0;
+
+#if WITH_DEBUGGER
+    buffer_fill_amount_ = 0u;
+    sound_buffer_1_.assign(samples_per_terminal, 0.f);
+    sound_buffer_2_.assign(samples_per_terminal, 0.f);
+    sound_buffer_3_.assign(samples_per_terminal, 0.f);
+    sound_buffer_4_.assign(samples_per_terminal, 0.f);
+#endif //WITH_DEBUGGER
+
+    update_amplitudes();
+    schedule_buffer_full();
+}
+
+void apu::schedule_buffer_full() noexcept
+{
+    auto scheduler = bus_->get_scheduler();
+    scheduler->schedule(scheduler::event::apu, scheduler->now() + cycles_until_buffer_full_);
+}
+
+void apu::on_buffer_full_deadline() noexcept
+{
+    sync();
+    schedule_buffer_full();
 }
 
 void apu::on_write(const address16& address, const uint8_t data) noexcept
 {
+    sync();
+
     if(!power_on_ && address != nr_52_addr) {
         return;
     }
@@ -261,10 +413,14 @@ void apu::on_write(const address16& address, const uint8_t data) noexcept
             power_on_ = true;
         }
     }
+
+    update_amplitudes();
 }
 
-uint8_t apu::on_read(const address16& address) const noexcept
+uint8_t apu::on_read(const address16& address) noexcept
 {
+    sync();
+
     // ch1
     if(address == nr_10_addr) { return channel_1_.sweep.reg.value() | 0x80u; }
     if(address == nr_11_addr) { return channel_1_.wave_data.reg.value() | 0x3Fu; }
@@ -303,6 +459,7 @@ uint8_t apu::on_read(const address16& address) const noexcept
 
 void apu::on_wave_pattern_write(const address16& address, const uint8_t data) noexcept
 {
+    sync();
     channel_3_.wave_pattern[(address - *begin(wave_pattern_range)).value()] = data;
 }
 
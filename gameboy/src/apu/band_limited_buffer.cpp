@@ -0,0 +1,113 @@
+#include "gameboy/apu/band_limited_buffer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+namespace gameboy::audio {
+
+namespace {
+
+template<size_t PhaseCount, size_t Width, size_t Bits>
+auto make_step_kernel() noexcept
+{
+    constexpr auto pi = 3.14159265358979323846;
+    constexpr auto cutoff = 0.9; // of the nyquist frequency
+    constexpr auto half_width = static_cast<double>(Width / 2);
+
+    std::array<std::array<int32_t, Width>, PhaseCount> kernel{};
+    for(size_t phase = 0; phase < PhaseCount; ++phase) {
+        std::array<double, Width> impulse{};
+        double sum = 0.;
+
+        for(size_t tap = 0; tap < Width; ++tap) {
+            // distance of the tap from the step which happens half the kernel later than the delta
+            const auto x = static_cast<double>(tap) - (half_width - 1.) -
+                static_cast<double>(phase) / static_cast<double>(PhaseCount);
+            const auto sinc = x == 0. ? 1. : std::sin(pi * cutoff * x) / (pi * cutoff * x);
+            const auto blackman = .42 + .5 * std::cos(pi * x / half_width) + .08 * std::cos(2. * pi * x / half_width);
+
+            impulse[tap] = sinc * blackman;
+            sum += impulse[tap];
+        }
+
+        // every phase has to add up to exactly one step, otherwise the integrated output drifts
+        int32_t total = 0;
+        for(size_t tap = 0; tap < Width; ++tap) {
+            kernel[phase][tap] = static_cast<int32_t>(std::lround(impulse[tap] / sum * (1 << Bits)));
+            total += kernel[phase][tap];
+        }
+        kernel[phase][Width / 2 - 1] += (1 << Bits) - total;
+    }
+
+    return kernel;
+}
+
+} // namespace
+
+void band_limited_buffer::set_rates(const uint32_t clock_rate, const uint32_t sample_rate, const uint32_t max_samples)
+{
+    factor_ = static_cast<uint64_t>(std::ceil(
+        std::ldexp(static_cast<double>(sample_rate) / static_cast<double>(clock_rate), time_bits)));
+    samples_.resize(max_samples + kernel_width);
+    clear();
+}
+
+void band_limited_buffer::clear() noexcept
+{
+    offset_ = 0u;
+    integrator_ = 0;
+    std::fill(begin(samples_), end(samples_), 0);
+}
+
+void band_limited_buffer::add_delta(const uint64_t clock_time, const int32_t delta)
+{
+    static const auto kernel = make_step_kernel<phase_count, kernel_width, kernel_bits>();
+
+    const auto position = offset_ + clock_time * factor_;
+    const auto index = position >> time_bits;
+    if(index + kernel_width > samples_.size()) {
+        // the step is past what is read until the next flush, dropping it would offset the integrated output
+        samples_.resize(index + kernel_width, 0);
+    }
+
+    const auto& steps = kernel[(position >> (time_bits - phase_bits)) & (phase_count - 1u)];
+    for(size_t tap = 0; tap < kernel_width; ++tap) {
+        samples_[index + tap] += steps[tap] * delta;
+    }
+}
+
+void band_limited_buffer::end_frame(const uint64_t clock_duration) noexcept
+{
+    offset_ += clock_duration * factor_;
+}
+
+uint64_t band_limited_buffer::clocks_needed(const uint32_t sample_count) const noexcept
+{
+    const auto needed = uint64_t{sample_count} << time_bits;
+    if(needed <= offset_) {
+        return 0u;
+    }
+
+    return (needed - offset_ + factor_ - 1u) / factor_;
+}
+
+void band_limited_buffer::read_samples(int16_t* out, const uint32_t count, const size_t stride) noexcept
+{
+    for(uint32_t i = 0; i < count; ++i, out += stride) {
+        integrator_ += samples_[i];
+        *out = static_cast<int16_t>(std::clamp<int64_t>(integrator_ >> kernel_bits,
+            std::numeric_limits<int16_t>::min(), std::numeric_limits<int16_t>::max()));
+    }
+
+    // samples past the read ones still hold the tails of recent steps
+    const auto tail_size = std::min<size_t>(samples_available() + kernel_width, samples_.size());
+    const auto tail_end = begin(samples_) + static_cast<std::vector<int32_t>::difference_type>(tail_size);
+    const auto moved_end = std::copy(begin(samples_) + count, tail_end, begin(samples_));
+    std::fill(moved_end, tail_end, 0);
+
+    offset_ -= uint64_t{count} << time_bits;
+}
+
+} // namespace gameboy::audio
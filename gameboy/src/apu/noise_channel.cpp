@@ -1,6 +1,7 @@
 #include "gameboy/apu/noise_channel.h"
 
 #include <array>
+#include <limits>
 
 namespace gameboy {
 
@@ -8,19 +9,69 @@ constexpr std::array<uint8_t, 8u> divisor_table{
     8, 16, 32, 48, 64, 80, 96, 112
 };
 
-void noise_channel::tick() noexcept
+void noise_channel::save_state(state_writer& writer) const
 {
-    --timer;
-    if(timer == 0) {
-        timer = divisor_table[polynomial_counter.dividing_ratio()] << polynomial_counter.shift_clock_frequency();
+    writer.write(sound_length);
+    writer.write(envelope.reg);
+    writer.write(envelope.timer);
+    writer.write(polynomial_counter);
+    writer.write(control);
+    writer.write(timer);
+    writer.write(lfsr);
+    writer.write(output);
+    writer.write(length_counter);
+    writer.write(volume);
+    writer.write(enabled);
+    writer.write(dac_enabled);
+}
+
+void noise_channel::load_state(state_reader& reader) noexcept
+{
+    reader.read(sound_length);
+    reader.read(envelope.reg);
+    reader.read(envelope.timer);
+    reader.read(polynomial_counter);
+    reader.read(control);
+    reader.read(timer);
+    reader.read(lfsr);
+    reader.read(output);
+    reader.read(length_counter);
+    reader.read(volume);
+    reader.read(enabled);
+    reader.read(dac_enabled);
+}
+
+void noise_channel::advance(uint32_t cycles) noexcept
+{
+    // a timer of zero wraps around before it can expire again
+    const auto cycles_to_edge = timer == 0u ? uint64_t{1u} << 32u : uint64_t{timer};
+    if(cycles < cycles_to_edge) {
+        timer -= cycles;
+        return;
+    }
+
+    cycles -= static_cast<uint32_t>(cycles_to_edge);
+
+    const auto period = static_cast<uint32_t>(divisor_table[polynomial_counter.dividing_ratio()]) << polynomial_counter.shift_clock_frequency();
+    for(auto edges = 1u + cycles / period; edges > 0u; --edges) {
         shift_register_click();
+    }
+    timer = period - cycles % period;
 
-        if(enabled && dac_enabled && !bit::test(lfsr, 0u)) {
-            output = volume;
-        } else {
-            output = 0u;
-        }
+    if(enabled && dac_enabled && !bit::test(lfsr, 0u)) {
+        output = volume;
+    } else {
+        output = 0u;
+    }
+}
+
+uint64_t noise_channel::cycles_until_edge() const noexcept
+{
+    if(output == 0u && (!enabled || !dac_enabled || volume == 0u)) {
+        return std::numeric_limits<uint64_t>::max();
     }
+
+    return timer == 0u ? uint64_t{1u} << 32u : uint64_t{timer};
 }
 
 void noise_channel::length_click() noexcept
@@ -1,6 +1,8 @@
 #include "gameboy/apu/pulse_channel.h"
 
+#include <algorithm>
 #include <array>
+#include <limits>
 
 namespace gameboy {
 
@@ -11,16 +13,68 @@ constexpr std::array<bool, 32u> waveform{
     false, true, true, true, true, true, true, false,
 };
 
-void pulse_channel::tick() noexcept
+void pulse_channel::save_state(state_writer& writer) const
 {
-    --timer;
+    writer.write(sweep);
+    writer.write(wave_data);
+    writer.write(envelope.reg);
+    writer.write(envelope.timer);
+    writer.write(frequency_data);
+    writer.write(waveform_duty_index);
+    writer.write(timer);
+    writer.write(length_counter);
+    writer.write(volume);
+    writer.write(output);
+    writer.write(waveform_index);
+    writer.write(enabled);
+    writer.write(dac_enabled);
+}
+
+void pulse_channel::load_state(state_reader& reader) noexcept
+{
+    reader.read(sweep);
+    reader.read(wave_data);
+    reader.read(envelope.reg);
+    reader.read(envelope.timer);
+    reader.read(frequency_data);
+    reader.read(waveform_duty_index);
+    reader.read(timer);
+    reader.read(length_counter);
+    reader.read(volume);
+    reader.read(output);
+    reader.read(waveform_index);
+    reader.read(enabled);
+    reader.read(dac_enabled);
+}
 
-    if(timer <= 0) {
-        waveform_index = (waveform_index + 1u) & 0x07u;
-        reset_timer();
-        adjust_waveform_duty_index();
-        adjust_output_volume();
+void pulse_channel::advance(uint32_t cycles) noexcept
+{
+    // the timer reaches zero at the first cycle when it is already expired
+    const auto cycles_to_edge = static_cast<uint32_t>(std::max<int16_t>(timer, 1));
+    if(cycles < cycles_to_edge) {
+        timer -= static_cast<int16_t>(cycles);
+        return;
     }
+
+    cycles -= cycles_to_edge;
+    reset_timer();
+
+    const auto period = static_cast<uint32_t>(timer);
+    const auto edges = 1u + cycles / period;
+    timer = static_cast<int16_t>(period - cycles % period);
+
+    waveform_index = (waveform_index + edges) & 0x07u;
+    adjust_waveform_duty_index();
+    adjust_output_volume();
+}
+
+uint64_t pulse_channel::cycles_until_edge() const noexcept
+{
+    if(output == 0u && (!enabled || !dac_enabled || volume == 0u)) {
+        return std::numeric_limits<uint64_t>::max();
+    }
+
+    return static_cast<uint64_t>(std::max<int16_t>(timer, 1));
 }
 
 void pulse_channel::on_write(const register_index index, const uint8_t data)
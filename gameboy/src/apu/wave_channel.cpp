@@ -1,30 +1,51 @@
 #include "gameboy/apu/wave_channel.h"
 
+#include <algorithm>
+#include <limits>
+
 namespace gameboy {
 
 constexpr std::array shift_table{4u, 0u, 1u, 2u};
 
-void wave_channel::tick() noexcept
+void wave_channel::advance(uint32_t cycles) noexcept
 {
-    --timer;
-    if(timer <= 0) {
-        reset_timer();
-        sample_index = (sample_index + 1u) & 0x1Fu;
+    const auto cycles_to_edge = static_cast<uint32_t>(std::max<int16_t>(timer, 1));
+    if(cycles < cycles_to_edge) {
+        timer -= static_cast<int16_t>(cycles);
+        return;
+    }
+
+    cycles -= cycles_to_edge;
+    reset_timer();
 
-        if(enabled && dac_enabled) {
-            const auto idx = sample_index / 2;
-            output = wave_pattern[idx];
+    const auto period = static_cast<uint32_t>(timer);
+    const auto edges = 1u + cycles / period;
+    timer = static_cast<int16_t>(period - cycles % period);
 
-            if(!bit::test(sample_index, 0u)) {
-                output >>= 4u;
-            }
+    sample_index = (sample_index + edges) & 0x1Fu;
+
+    if(enabled && dac_enabled) {
+        const auto idx = sample_index / 2u;
+        output = wave_pattern[idx];
 
-            output &= 0x0Fu;
-            output >>= shift_table[(output_level.value() >> 5u) & 0x3u];
-        } else {
-            output = 0u;
+        if(!bit::test(sample_index, 0u)) {
+            output >>= 4u;
         }
+
+        output &= 0x0Fu;
+        output >>= shift_table[(output_level.value() >> 5u) & 0x3u];
+    } else {
+        output = 0u;
+    }
+}
+
+uint64_t wave_channel::cycles_until_edge() const noexcept
+{
+    if(output == 0u && (!enabled || !dac_enabled || shift_table[(output_level.value() >> 5u) & 0x3u] == 4u)) {
+        return std::numeric_limits<uint64_t>::max();
     }
+
+    return static_cast<uint64_t>(std::max<int16_t>(timer, 1));
 }
 
 void wave_channel::length_click() noexcept
@@ -12,5 +12,6 @@ observer<apu> bus::get_apu() const noexcept { return make_observer(gb_->apu_); }
 observer<timer> bus::get_timer() const noexcept { return make_observer(gb_->timer_); }
 observer<joypad> bus::get_joypad() const noexcept { return make_observer(gb_->joypad_); }
 observer<link> bus::get_link() const noexcept { return make_observer(gb_->link_); }
+observer<scheduler> bus::get_scheduler() const noexcept { return make_observer(gb_->scheduler_); }
 
 } // namespace gameboy
@@ -7,6 +7,7 @@
 
 #include "gameboy/memory/address_range.h"
 #include "gameboy/memory/memory_constants.h"
+#include "gameboy/rom_cache.h"
 #include "gameboy/util/mathutil.h"
 #include "gameboy/util/variantutil.h"
 
@@ -70,7 +71,7 @@ enum class mbc_type : uint8_t {
 };
 
 template<typename T = uint8_t, typename AddrType>
-[[nodiscard]] T read(const std::vector<uint8_t>& rom_data, const AddrType& addr)
+[[nodiscard]] T read(const byte_view rom_data, const AddrType& addr)
 {
     return static_cast<T>(rom_data[addr.value()]);
 }
@@ -94,14 +95,37 @@ filesystem::path get_rtc_path(const filesystem::path& rom_path) noexcept
 
 cartridge::cartridge(const filesystem::path& rom_path)
     : rom_path_{rom_path},
-      rom_{read_file(rom_path)},
+      rom_{rom_cache::load(rom_path)},
       mbc_{mbc_regular{make_observer(this)}}
 {
     parse_rom();
 }
 
+cartridge::cartridge(const cartridge& other)
+    : rom_path_{other.rom_path_},
+      cgb_enabled_{other.cgb_enabled_},
+      has_battery_{other.has_battery_},
+      has_rtc_{other.has_rtc_},
+      rom_bank_count_{other.rom_bank_count_},
+      ram_bank_count_{other.ram_bank_count_},
+      cgb_type_{other.cgb_type_},
+      mbc_type_{other.mbc_type_},
+      rom_type_{other.rom_type_},
+      ram_type_{other.ram_type_},
+      name_{other.name_},
+      rom_{other.rom_},
+      ram_{other.ram_},
+      mbc_{other.mbc_}
+{
+    visit_nt(mbc_, [&](auto&& mbc) {
+        mbc.set_cartridge(make_observer(this));
+    });
+}
+
 void cartridge::parse_rom()
 {
+    const auto rom = rom_->view();
+
     constexpr auto cgb_support_addr = make_address(0x0143u);
     constexpr auto mbc_type_addr = make_address(0x0147u);
     constexpr auto rom_size_addr = make_address(0x0148u);
@@ -116,21 +140,21 @@ void cartridge::parse_rom()
         end(rom_header_range),
         static_cast<uint8_t>(0u),
         [&](const uint8_t acc, const uint16_t addr) {
-            return acc - rom_[addr] - 1;
+            return acc - rom[addr] - 1;
         });
 
-    if(const auto expected = read(rom_, header_checksum_addr); checksum != expected) {
+    if(const auto expected = read(rom, header_checksum_addr); checksum != expected) {
         spdlog::critical("rom checksum is not correct. expected: {}, calculated: {}", expected, checksum);
         std::terminate();
     }
 
     name_.clear();
     std::copy(
-        begin(rom_) + *begin(rom_title_range),
-        begin(rom_) + *end(rom_title_range),
+        rom.begin() + *begin(rom_title_range),
+        rom.begin() + *end(rom_title_range),
         std::back_inserter(name_));
 
-    const auto cgb_flag = read<uint8_t>(rom_, cgb_support_addr);
+    const auto cgb_flag = read<uint8_t>(rom, cgb_support_addr);
     cgb_enabled_ = bit::test(cgb_flag, 7u) && !(bit::test(cgb_flag, 2u) || bit::test(cgb_flag, 3u));
     if(cgb_enabled_) {
         if(bit::test(cgb_flag, 6u)) {
@@ -144,7 +168,7 @@ void cartridge::parse_rom()
 
     has_rtc_ = false;
 
-    const auto mbc = read<mbc_type>(rom_, mbc_type_addr);
+    const auto mbc = read<mbc_type>(rom, mbc_type_addr);
     mbc_type_ = magic_enum::enum_name(mbc);
     switch(mbc) {
         case mbc_type::rom_only:
@@ -188,7 +212,7 @@ void cartridge::parse_rom()
         }
     }
 
-    const auto rom_size_type = read<rom_type>(rom_, rom_size_addr);
+    const auto rom_size_type = read<rom_type>(rom, rom_size_addr);
     rom_type_ = magic_enum::enum_name(rom_size_type);
     rom_bank_count_ = [](rom_type type) {
         switch(type) {
@@ -207,7 +231,7 @@ void cartridge::parse_rom()
         }
     }(rom_size_type);
 
-    const auto ram_size_type = read<ram_type>(rom_, ram_size_addr);
+    const auto ram_size_type = read<ram_type>(rom, ram_size_addr);
     ram_type_ = magic_enum::enum_name(ram_size_type);
     ram_bank_count_ = [](ram_type type) {
         switch(type) {
@@ -265,7 +289,7 @@ void cartridge::parse_rom()
 void cartridge::load_rom(const filesystem::path& rom_path)
 {
     rom_path_ = rom_path;
-    rom_ = read_file(rom_path);
+    rom_ = rom_cache::load(rom_path);
     parse_rom();
 }
 
@@ -277,6 +301,38 @@ void cartridge::save_ram_rtc() const
     save_rtc();
 }
 
+void cartridge::save_state(state_writer& writer) const
+{
+    writer.begin_section(state_section);
+    writer.write_bytes(ram_.data(), ram_.size());
+    writer.write(static_cast<uint8_t>(mbc_.index()));
+    visit_nt(mbc_, [&](auto&& mbc) {
+        mbc.save_state(writer);
+    });
+    writer.end_section();
+}
+
+void cartridge::load_state(state_reader& reader) noexcept
+{
+    if(!reader.begin_section(state_section)) {
+        return;
+    }
+
+    reader.read_bytes(ram_.data(), ram_.size());
+
+    uint8_t mbc_index = 0u;
+    reader.read(mbc_index);
+    if(mbc_index != mbc_.index()) {
+        reader.fail();
+        return;
+    }
+
+    visit_nt(mbc_, [&](auto&& mbc) {
+        mbc.load_state(reader);
+    });
+    reader.end_section();
+}
+
 uint8_t cartridge::read_rom(const address16& address) const
 {
     const auto physical_addr = [&]() -> size_t {
@@ -287,7 +343,7 @@ uint8_t cartridge::read_rom(const address16& address) const
         return address.value() + 16_kb * (static_cast<int32_t>(rom_bank(address)) - 1);
     }();
 
-    return rom_[physical_addr];
+    return (*rom_)[physical_addr];
 }
 
 void cartridge::write_rom(const address16& address, uint8_t data)
@@ -300,6 +356,16 @@ void cartridge::write_rom(const address16& address, uint8_t data)
     );
 }
 
+const uint8_t* cartridge::rom_bank_data(const address16& address) const noexcept
+{
+    const size_t bank_start = 16_kb * rom_bank(address);
+    if(bank_start + 16_kb > rom_->size()) {
+        return nullptr;
+    }
+
+    return rom_->data() + bank_start;
+}
+
 uint8_t cartridge::read_ram(const address16& address) const
 {
     if(!ram_enabled()) {
@@ -378,7 +444,8 @@ void cartridge::load_ram()
 {
     const auto save_path = get_save_path(rom_path_);
     if(filesystem::exists(save_path) && filesystem::file_size(save_path) == ram_.size()) {
-        ram_ = read_file(save_path);
+        const auto save = read_file(save_path);
+        std::copy(save.begin(), save.end(), begin(ram_));
     }
 }
 
@@ -394,6 +461,10 @@ std::pair<std::time_t, rtc> cartridge::load_rtc()
     if(const auto rtc_path = get_rtc_path(rom_path_); has_rtc() && filesystem::exists(rtc_path)) {
         // todo use std::bit_cast in c++20
         const auto rtc_data = read_file(rtc_path);
+        if(rtc_data.size() < sizeof(std::time_t) + sizeof(rtc)) {
+            spdlog::warn("rtc data is too short: {}", rtc_path.string());
+            return std::make_pair(0u, rtc{});
+        }
 
         std::time_t rtc_last_time;
         rtc rtc;
@@ -6,9 +6,32 @@
 #include "gameboy/bus.h"
 #include "gameboy/cartridge.h"
 #include "gameboy/cpu/instruction_info.h"
+#include "gameboy/link/link.h"
+#include "gameboy/timer/timer.h"
+#include "gameboy/memory/memory_constants.h"
 #include "gameboy/memory/mmu.h"
 #include "gameboy/util/mathutil.h"
 
+#if WITH_COMPUTED_GOTO && defined(__GNUC__)
+#define GAMEBOY_COMPUTED_GOTO 1
+
+#define GAMEBOY_REPEAT_16(macro, high) \
+    macro(high##0) macro(high##1) macro(high##2) macro(high##3) \
+    macro(high##4) macro(high##5) macro(high##6) macro(high##7) \
+    macro(high##8) macro(high##9) macro(high##A) macro(high##B) \
+    macro(high##C) macro(high##D) macro(high##E) macro(high##F)
+#define GAMEBOY_REPEAT_256(macro) \
+    GAMEBOY_REPEAT_16(macro, 0x0) GAMEBOY_REPEAT_16(macro, 0x1) GAMEBOY_REPEAT_16(macro, 0x2) \
+    GAMEBOY_REPEAT_16(macro, 0x3) GAMEBOY_REPEAT_16(macro, 0x4) GAMEBOY_REPEAT_16(macro, 0x5) \
+    GAMEBOY_REPEAT_16(macro, 0x6) GAMEBOY_REPEAT_16(macro, 0x7) GAMEBOY_REPEAT_16(macro, 0x8) \
+    GAMEBOY_REPEAT_16(macro, 0x9) GAMEBOY_REPEAT_16(macro, 0xA) GAMEBOY_REPEAT_16(macro, 0xB) \
+    GAMEBOY_REPEAT_16(macro, 0xC) GAMEBOY_REPEAT_16(macro, 0xD) GAMEBOY_REPEAT_16(macro, 0xE) \
+    GAMEBOY_REPEAT_16(macro, 0xF)
+#define GAMEBOY_LABEL_ADDRESS(opcode) &&opcode_##opcode,
+#else
+#define GAMEBOY_COMPUTED_GOTO 0
+#endif //WITH_COMPUTED_GOTO && defined(__GNUC__)
+
 namespace gameboy {
     
 using namespace magic_enum::bitwise_operators;
@@ -17,9 +40,40 @@ constexpr address16 ie_addr{0xFFFFu};
 constexpr address16 if_addr{0xFF0Fu};
 constexpr address16 key_1_addr{0xFF4Du};
 
+/** blocks never cross a page of the mmu so that they map to contiguous host memory */
+constexpr uint16_t code_page_size = 0x100u;
+
+constexpr bool ends_block(const uint8_t opcode) noexcept
+{
+    const uint8_t x = opcode >> 6u;
+    const uint8_t y = (opcode >> 3u) & 0x07u;
+    const uint8_t z = opcode & 0x07u;
+    const uint8_t p = y >> 1u;
+    const uint8_t q = y & 0x01u;
+
+    if(x == 0u) {
+        /* STOP, JR, JR cc */
+        return z == 0u && y >= 2u;
+    }
+
+    if(x == 1u) {
+        /* HALT */
+        return y == 6u && z == 6u;
+    }
+
+    if(x == 3u) {
+        /* RET cc, RET, RETI, JP HL, JP cc, JP, CALL cc, CALL, RST */
+        return (z == 0u && y < 4u) || (z == 1u && q == 1u && p < 3u) || (z == 2u && y < 4u) || (z == 3u && y == 0u)
+            || (z == 4u && y < 4u) || (z == 5u && q == 1u && p == 0u) || z == 7u;
+    }
+
+    return false;
+}
+
 cpu::cpu(const observer<bus> bus) noexcept
     : bus_{bus},
-      alu_{make_observer(this)}
+      alu_{make_observer(this)},
+      execution_mode_{execution_mode::interpreter}
 {
     reset();
 }
@@ -52,6 +106,8 @@ void cpu::reset() noexcept
     wait_before_unhalt_cycles_ = 0;
     extra_cycles_ = 0u;
 
+    clear_code_blocks();
+
     auto mmu = bus_->get_mmu();
 
     mmu->add_memory_delegate(ie_addr, {
@@ -110,18 +166,12 @@ uint8_t cpu::tick()
     prev_program_counter_ = program_counter_;
 #endif //WITH_DEBUGGER
 
-    const auto execute_next_op = [&]() -> uint8_t {
-        const auto opcode = read_immediate(imm8);
-        if(opcode != 0xCB) {
-            return decode(opcode, standard_instruction_set);
-        }
-
-        return decode(read_immediate(imm8), extended_instruction_set);
-    };
-
-    auto cycle_count = !is_halted_
-        ? execute_next_op()
-        : static_cast<uint8_t>(4u);
+    auto cycle_count = static_cast<uint8_t>(4u);
+    if(!is_halted_) {
+        cycle_count = execution_mode_ == execution_mode::cached_interpreter
+            ? execute_cached_instruction()
+            : execute_next_instruction();
+    }
 
     if(wait_before_unhalt_cycles_ > 0) {
         wait_before_unhalt_cycles_ -= cycle_count;
@@ -161,6 +211,197 @@ uint8_t cpu::tick()
     return cycle_count;
 }
 
+void cpu::save_state(state_writer& writer) const
+{
+    writer.begin_section(state_section);
+    writer.write(a_f_);
+    writer.write(b_c_);
+    writer.write(d_e_);
+    writer.write(h_l_);
+    writer.write(stack_pointer_);
+    writer.write(program_counter_);
+    writer.write(key_1_);
+    writer.write(total_cycles_);
+    writer.write(interrupt_flags_);
+    writer.write(interrupt_enable_);
+    writer.write(interrupt_master_enable_);
+    writer.write(pending_disable_interrupts_counter_);
+    writer.write(pending_enable_interrupts_counter_);
+    writer.write(is_stopped_);
+    writer.write(is_halted_);
+    writer.write(wait_before_unhalt_cycles_);
+    writer.write(extra_cycles_);
+    writer.end_section();
+}
+
+void cpu::load_state(state_reader& reader) noexcept
+{
+    if(!reader.begin_section(state_section)) {
+        return;
+    }
+
+    reader.read(a_f_);
+    reader.read(b_c_);
+    reader.read(d_e_);
+    reader.read(h_l_);
+    reader.read(stack_pointer_);
+    reader.read(program_counter_);
+    reader.read(key_1_);
+    reader.read(total_cycles_);
+    reader.read(interrupt_flags_);
+    reader.read(interrupt_enable_);
+    reader.read(interrupt_master_enable_);
+    reader.read(pending_disable_interrupts_counter_);
+    reader.read(pending_enable_interrupts_counter_);
+    reader.read(is_stopped_);
+    reader.read(is_halted_);
+    reader.read(wait_before_unhalt_cycles_);
+    reader.read(extra_cycles_);
+    reader.end_section();
+
+    // rom blocks stay valid, wram and hram were overwritten and are no longer write protected
+    ram_blocks_.clear();
+    block_cursor_ = nullptr;
+    block_end_ = nullptr;
+}
+
+void cpu::set_execution_mode(const execution_mode mode) noexcept
+{
+    execution_mode_ = mode;
+    clear_code_blocks();
+}
+
+void cpu::invalidate_code(const uint8_t* code, const size_t size) noexcept
+{
+    for(auto it = ram_blocks_.begin(); it != ram_blocks_.end();) {
+        if(code <= it->first && it->first < code + size) {
+            it = ram_blocks_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    block_cursor_ = nullptr;
+    block_end_ = nullptr;
+}
+
+uint8_t cpu::execute_next_instruction()
+{
+    const auto opcode = read_immediate(imm8);
+    if(opcode != 0xCB) {
+        return decode(opcode, standard_instruction_set);
+    }
+
+    return decode(read_immediate(imm8), extended_instruction_set);
+}
+
+uint8_t cpu::execute_cached_instruction()
+{
+    if(block_cursor_ == block_end_ ||
+       block_cursor_->address != program_counter_.value() ||
+       block_mapping_generation_ != bus_->get_mmu()->mapping_generation()) {
+        if(!enter_block()) {
+            return execute_next_instruction();
+        }
+    }
+
+    // copied, the handler may overwrite the code and invalidate the block
+    const auto instruction = *block_cursor_++;
+    program_counter_ = static_cast<uint16_t>(instruction.address + instruction.length);
+    return (this->*instruction.handler)(instruction.data);
+}
+
+bool cpu::enter_block()
+{
+    auto mmu = bus_->get_mmu();
+    const auto address = make_address(program_counter_);
+
+    block_cursor_ = nullptr;
+    block_end_ = nullptr;
+
+    const auto* code = mmu->code_pointer(address);
+    if(code == nullptr) {
+        return false;
+    }
+
+    const auto in_rom = rom_range.has(address);
+    auto& blocks = in_rom ? rom_blocks_ : ram_blocks_;
+
+    auto it = blocks.find(code);
+    if(it == blocks.end() || it->second.instructions.front().address != address.value()) {
+        const auto size_limit = hram_range.has(address)
+            ? static_cast<uint16_t>(*begin(hram_range) + hram_range.size() - address.value())
+            : static_cast<uint16_t>(code_page_size - address.value() % code_page_size);
+
+        auto block = decode_block(code, address.value(), size_limit);
+        if(block.instructions.empty()) {
+            return false;
+        }
+
+        if(!in_rom) {
+            mmu->protect_code(address);
+        }
+
+        it = blocks.insert_or_assign(code, std::move(block)).first;
+    }
+
+    block_cursor_ = it->second.instructions.data();
+    block_end_ = block_cursor_ + it->second.instructions.size();
+    block_mapping_generation_ = mmu->mapping_generation();
+    return true;
+}
+
+cpu::code_block cpu::decode_block(const uint8_t* code, const uint16_t address, const uint16_t size_limit) const
+{
+    code_block block;
+    block.size = 0u;
+
+    while(block.size < size_limit) {
+        const auto opcode = code[block.size];
+        const auto length = opcode == 0xCB
+            ? static_cast<uint8_t>(2u)
+            : instruction::standard_instruction_set[opcode].length;
+
+        // invalid opcodes and instructions crossing the page are left to the interpreter
+        if(length == 0u || block.size + length > size_limit) {
+            break;
+        }
+
+        decoded_instruction instruction{
+            decoded_standard_handlers_[opcode],
+            static_cast<uint16_t>(address + block.size),
+            0u,
+            length
+        };
+
+        if(opcode == 0xCB) {
+            instruction.handler = decoded_extended_handlers_[code[block.size + 1u]];
+        } else if(length == 3u) {
+            instruction.data = word(code[block.size + 2u], code[block.size + 1u]);
+        } else if(length == 2u) {
+            instruction.data = code[block.size + 1u];
+        }
+
+        block.instructions.push_back(instruction);
+        block.size += length;
+
+        if(opcode != 0xCB && ends_block(opcode)) {
+            break;
+        }
+    }
+
+    return block;
+}
+
+void cpu::clear_code_blocks() noexcept
+{
+    rom_blocks_.clear();
+    ram_blocks_.clear();
+    block_cursor_ = nullptr;
+    block_end_ = nullptr;
+    block_mapping_generation_ = 0u;
+}
+
 void cpu::process_interrupts() noexcept
 {
     const auto pending = interrupt_enable_ & interrupt_flags_;
@@ -202,6 +443,16 @@ void cpu::request_interrupt(const interrupt request) noexcept
     interrupt_flags_ |= request;
 }
 
+bool cpu::is_waiting_for_interrupt() const noexcept
+{
+    return is_halted_ && !is_stopped_ && wait_before_unhalt_cycles_ == 0 && extra_cycles_ == 0 && !has_pending_interrupt();
+}
+
+bool cpu::has_pending_interrupt() const noexcept
+{
+    return (interrupt_enable_ & interrupt_flags_) != interrupt::none;
+}
+
 bool cpu::is_in_double_speed() const noexcept
 {
     return bit::test(key_1_, 7u) && !bit::test(key_1_, 0u);
@@ -228,2275 +479,468 @@ bool cpu::test_flag(const flag flag) noexcept
     return mask::test(a_f_.low(), f);
 }
 
+#if GAMEBOY_COMPUTED_GOTO
+// labels as values are a gnu extension
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#endif //GAMEBOY_COMPUTED_GOTO
+
 uint8_t cpu::decode(const uint8_t inst, standard_instruction_set_t)
 {
-    const auto info = instruction::standard_instruction_set[inst];
+#if GAMEBOY_COMPUTED_GOTO
+    static void* const labels[] = { GAMEBOY_REPEAT_256(GAMEBOY_LABEL_ADDRESS) };
+    goto *labels[inst];
+#define GAMEBOY_LABEL(opcode) opcode_##opcode: return standard_instruction<opcode>();
+    GAMEBOY_REPEAT_256(GAMEBOY_LABEL)
+#undef GAMEBOY_LABEL
+#else
+    return (this->*standard_handlers_[inst])();
+#endif //GAMEBOY_COMPUTED_GOTO
+}
 
-    const auto data = [&]() -> uint16_t {
-        switch(info.length) {
-            case 3u: return read_immediate(imm16);
-            case 2u: return read_immediate(imm8);
-            default: return 0u;
-        }
-    }();
+uint8_t cpu::decode(const uint8_t inst, extended_instruction_set_t)
+{
+#if GAMEBOY_COMPUTED_GOTO
+    static void* const labels[] = { GAMEBOY_REPEAT_256(GAMEBOY_LABEL_ADDRESS) };
+    goto *labels[inst];
+#define GAMEBOY_LABEL(opcode) opcode_##opcode: return extended_instruction<opcode>();
+    GAMEBOY_REPEAT_256(GAMEBOY_LABEL)
+#undef GAMEBOY_LABEL
+#else
+    return (this->*extended_handlers_[inst])();
+#endif //GAMEBOY_COMPUTED_GOTO
+}
 
-    const auto false_branch = [&]() {
-#if WITH_DEBUGGER
-        if(on_instruction_executed_) {
-            on_instruction_executed_(make_address(prev_program_counter_), info, data);
-        }
-#endif //WITH_DEBUGGER
+#if GAMEBOY_COMPUTED_GOTO
+#pragma GCC diagnostic pop
+#endif //GAMEBOY_COMPUTED_GOTO
 
-        return instruction::get_false_branch_cycle_count(inst);
-    };
+template<uint8_t Opcode>
+uint8_t cpu::standard_instruction()
+{
+    constexpr auto length = instruction::standard_instruction_set[Opcode].length;
+    if constexpr(length == 3u) {
+        return execute<Opcode>(read_immediate(imm16));
+    } else if constexpr(length == 2u) {
+        return execute<Opcode>(read_immediate(imm8));
+    } else {
+        return execute<Opcode>(0u);
+    }
+}
 
-    switch(inst) {
-        case 0x00: {
-            nop();
-            break;
-        }
-        case 0x01: {
-            load(b_c_, data);
-            break;
-        }
-        case 0x02: {
-            store(make_address(b_c_), a_f_.high());
-            break;
-        }
-        case 0x03: {
-            alu::increment(b_c_);
-            break;
-        }
-        case 0x04: {
-            alu_.increment(b_c_.high());
-            break;
-        }
-        case 0x05: {
-            alu_.decrement(b_c_.high());
-            break;
-        }
-        case 0x06: {
-            load(b_c_.high(), static_cast<uint8_t>(data));
-            break;
-        }
-        case 0x07: {
-            alu_.rotate_left_c_acc();
-            break;
-        }
-        case 0x08: {
-            store(make_address(data), stack_pointer_);
-            break;
-        }
-        case 0x09: {
-            alu_.add(h_l_, b_c_);
-            break;
-        }
-        case 0x0A: {
-            load(a_f_.high(), read_data(make_address(b_c_)));
-            break;
-        }
-        case 0x0B: {
-            alu::decrement(b_c_);
-            break;
-        }
-        case 0x0C: {
-            alu_.increment(b_c_.low());
-            break;
-        }
-        case 0x0D: {
-            alu_.decrement(b_c_.low());
-            break;
-        }
-        case 0x0E: {
-            load(b_c_.low(), static_cast<uint8_t>(data));
-            break;
-        }
-        case 0x0F: {
-            alu_.rotate_right_c_acc();
-            break;
-        }
-        case 0x10: {
-            stop();
-            break;
-        }
-        case 0x11: {
-            load(d_e_, data);
-            break;
-        }
-        case 0x12: {
-            store(make_address(d_e_), a_f_.high());
-            break;
-        }
-        case 0x13: {
-            alu::increment(d_e_);
-            break;
-        }
-        case 0x14: {
-            alu_.increment(d_e_.high());
-            break;
-        }
-        case 0x15: {
-            alu_.decrement(d_e_.high());
-            break;
-        }
-        case 0x16: {
-            load(d_e_.high(), static_cast<uint8_t>(data));
-            break;
-        }
-        case 0x17: {
-            alu_.rotate_left_acc();
-            break;
-        }
-        case 0x18: {
-            jump_relative(make_address(static_cast<uint8_t>(data)));
-            break;
-        }
-        case 0x19: {
-            alu_.add(h_l_, d_e_);
-            break;
-        }
-        case 0x1A: {
-            load(a_f_.high(), read_data(make_address(d_e_)));
-            break;
-        }
-        case 0x1B: {
-            alu::decrement(d_e_);
-            break;
-        }
-        case 0x1C: {
-            alu_.increment(d_e_.low());
-            break;
-        }
-        case 0x1D: {
-            alu_.decrement(d_e_.low());
-            break;
-        }
-        case 0x1E: {
-            load(d_e_.low(), static_cast<uint8_t>(data));
-            break;
-        }
-        case 0x1F: {
-            alu_.rotate_right_acc();
-            break;
-        }
-        case 0x20: {
-            if(!test_flag(flag::zero)) {
+template<uint8_t Opcode>
+uint8_t cpu::execute(const uint16_t data)
+{
+    constexpr uint8_t x = Opcode >> 6u;
+    constexpr uint8_t y = (Opcode >> 3u) & 0x07u;
+    constexpr uint8_t z = Opcode & 0x07u;
+    constexpr uint8_t p = y >> 1u;
+    constexpr uint8_t q = y & 0x01u;
+
+    if constexpr(x == 0u) {
+        if constexpr(z == 0u) {
+            if constexpr(y == 0u) {
+                nop();
+            } else if constexpr(y == 1u) {
+                store(make_address(data), stack_pointer_);
+            } else if constexpr(y == 2u) {
+                stop();
+            } else if constexpr(y == 3u) {
                 jump_relative(make_address(static_cast<uint8_t>(data)));
             } else {
-                return false_branch();
-            }
-            break;
-        }
-        case 0x21: {
-            load(h_l_, data);
-            break;
-        }
-        case 0x22: {
-            store(make_address(h_l_++), a_f_.high());
-            break;
-        }
-        case 0x23: {
-            alu::increment(h_l_);
-            break;
-        }
-        case 0x24: {
-            alu_.increment(h_l_.high());
-            break;
-        }
-        case 0x25: {
-            alu_.decrement(h_l_.high());
-            break;
-        }
-        case 0x26: {
-            load(h_l_.high(), static_cast<uint8_t>(data));
-            break;
-        }
-        case 0x27: {
-            alu_.decimal_adjust();
-            break;
-        }
-        case 0x28: {
-            if(test_flag(flag::zero)) {
+                if(!condition<y - 4u>()) {
+                    return executed<Opcode>(data, false);
+                }
+
                 jump_relative(make_address(static_cast<uint8_t>(data)));
+            }
+        } else if constexpr(z == 1u) {
+            if constexpr(q == 0u) {
+                load(rp<p>(), data);
             } else {
-                return false_branch();
+                alu_.add(h_l_, rp<p>());
             }
-            break;
-        }
-        case 0x29: {
-            alu_.add(h_l_, h_l_);
-            break;
-        }
-        case 0x2A: {
-            load(a_f_.high(), read_data(make_address(h_l_++)));
-            break;
-        }
-        case 0x2B: {
-            alu::decrement(h_l_);
-            break;
-        }
-        case 0x2C: {
-            alu_.increment(h_l_.low());
-            break;
-        }
-        case 0x2D: {
-            alu_.decrement(h_l_.low());
-            break;
-        }
-        case 0x2E: {
-            load(h_l_.low(), static_cast<uint8_t>(data));
-            break;
-        }
-        case 0x2F: {
-            alu_.complement();
-            break;
-        }
-        case 0x30: {
-            if(!test_flag(flag::carry)) {
-                jump_relative(make_address(static_cast<uint8_t>(data)));
+        } else if constexpr(z == 2u) {
+            const auto indirect_address = [&]() {
+                if constexpr(p == 0u) {
+                    return make_address(b_c_);
+                } else if constexpr(p == 1u) {
+                    return make_address(d_e_);
+                } else if constexpr(p == 2u) {
+                    return make_address(h_l_++);
+                } else {
+                    return make_address(h_l_--);
+                }
+            };
+
+            if constexpr(q == 0u) {
+                store(indirect_address(), a_f_.high());
             } else {
-                return false_branch();
+                load(a_f_.high(), read_data(indirect_address()));
             }
-            break;
-        }
-        case 0x31: {
-            load(stack_pointer_, data);
-            break;
-        }
-        case 0x32: {
-            store(make_address(h_l_--), a_f_.high());
-            break;
-        }
-        case 0x33: {
-            alu::increment(stack_pointer_);
-            break;
-        }
-        case 0x34: {
-            const auto address = make_address(h_l_);
-            auto mem_data = read_data(address);
-            alu_.increment(mem_data);
-            write_data(address, mem_data);
-            break;
-        }
-        case 0x35: {
-            const auto address = make_address(h_l_);
-            auto mem_data = read_data(address);
-            alu_.decrement(mem_data);
-            write_data(address, mem_data);
-            break;
-        }
-        case 0x36: {
-            store(make_address(h_l_), static_cast<uint8_t>(data));
-            break;
-        }
-        case 0x37: { /* SCF */
-            reset_flag(flag::negative | flag::half_carry);
-            set_flag(flag::carry);
-            break;
-        }
-        case 0x38: {
-            if(test_flag(flag::carry)) {
-                jump_relative(make_address(static_cast<uint8_t>(data)));
+        } else if constexpr(z == 3u) {
+            if constexpr(q == 0u) {
+                alu::increment(rp<p>());
             } else {
-                return false_branch();
+                alu::decrement(rp<p>());
+            }
+        } else if constexpr(z == 4u || z == 5u) {
+            const auto step = [&](auto& value) {
+                if constexpr(z == 4u) {
+                    alu_.increment(value);
+                } else {
+                    alu_.decrement(value);
+                }
+            };
+
+            if constexpr(y == hl_indirect) {
+                const auto address = make_address(h_l_);
+                auto mem_data = read_data(address);
+                step(mem_data);
+                write_data(address, mem_data);
+            } else {
+                step(r8<y>());
+            }
+        } else if constexpr(z == 6u) {
+            if constexpr(y == hl_indirect) {
+                store(make_address(h_l_), static_cast<uint8_t>(data));
+            } else {
+                load(r8<y>(), static_cast<uint8_t>(data));
+            }
+        } else {
+            if constexpr(y == 0u) {
+                alu_.rotate_left_c_acc();
+            } else if constexpr(y == 1u) {
+                alu_.rotate_right_c_acc();
+            } else if constexpr(y == 2u) {
+                alu_.rotate_left_acc();
+            } else if constexpr(y == 3u) {
+                alu_.rotate_right_acc();
+            } else if constexpr(y == 4u) {
+                alu_.decimal_adjust();
+            } else if constexpr(y == 5u) {
+                alu_.complement();
+            } else if constexpr(y == 6u) { /* SCF */
+                reset_flag(flag::negative | flag::half_carry);
+                set_flag(flag::carry);
+            } else { /* CCF */
+                reset_flag(flag::negative | flag::half_carry);
+                flip_flag(flag::carry);
             }
-            break;
-        }
-        case 0x39: {
-            alu_.add(h_l_, stack_pointer_);
-            break;
-        }
-        case 0x3A: {
-            load(a_f_.high(), read_data(make_address(h_l_--)));
-            break;
-        }
-        case 0x3B: {
-            alu::decrement(stack_pointer_);
-            break;
-        }
-        case 0x3C: {
-            alu_.increment(a_f_.high());
-            break;
-        }
-        case 0x3D: {
-            alu_.decrement(a_f_.high());
-            break;
-        }
-        case 0x3E: {
-            load(a_f_.high(), static_cast<uint8_t>(data));
-            break;
-        }
-        case 0x3F: {
-            /* CCF */
-            reset_flag(flag::negative | flag::half_carry);
-            flip_flag(flag::carry);
-            break;
         }
-        case 0x40: {
-            /* LD B,B */
+    } else if constexpr(x == 1u) {
+        if constexpr(y == hl_indirect && z == hl_indirect) {
+            halt();
+        } else if constexpr(y == z) {
+            /* LD r,r */
             nop();
-            break;
-        }
-        case 0x41: {
-            load(b_c_.high(), b_c_.low());
-            break;
-        }
-        case 0x42: {
-            load(b_c_.high(), d_e_.high());
-            break;
-        }
-        case 0x43: {
-            load(b_c_.high(), d_e_.low());
-            break;
-        }
-        case 0x44: {
-            load(b_c_.high(), h_l_.high());
-            break;
-        }
-        case 0x45: {
-            load(b_c_.high(), h_l_.low());
-            break;
-        }
-        case 0x46: {
-            load(b_c_.high(), read_data(make_address(h_l_)));
-            break;
+        } else if constexpr(z == hl_indirect) {
+            load(r8<y>(), read_data(make_address(h_l_)));
+        } else if constexpr(y == hl_indirect) {
+            store(make_address(h_l_), r8<z>());
+        } else {
+            load(r8<y>(), r8<z>());
+        }
+    } else if constexpr(x == 2u) {
+        if constexpr(z == hl_indirect) {
+            arithmetic<y>(read_data(make_address(h_l_)));
+        } else {
+            arithmetic<y>(static_cast<const register8&>(r8<z>()));
         }
-        case 0x47: {
-            load(b_c_.high(), a_f_.high());
-            break;
-        }
-        case 0x48: {
-            load(b_c_.low(), b_c_.high());
-            break;
-        }
-        case 0x49: {
-            /* LD C,C */
-            nop();
-            break;
-        }
-        case 0x4A: {
-            load(b_c_.low(), d_e_.high());
-            break;
-        }
-        case 0x4B: {
-            load(b_c_.low(), d_e_.low());
-            break;
-        }
-        case 0x4C: {
-            load(b_c_.low(), h_l_.high());
-            break;
-        }
-        case 0x4D: {
-            load(b_c_.low(), h_l_.low());
-            break;
-        }
-        case 0x4E: {
-            load(b_c_.low(), read_data(make_address(h_l_)));
-            break;
-        }
-        case 0x4F: {
-            load(b_c_.low(), a_f_.high());
-            break;
-        }
-        case 0x50: {
-            load(d_e_.high(), b_c_.high());
-            break;
-        }
-        case 0x51: {
-            load(d_e_.high(), b_c_.low());
-            break;
-        }
-        case 0x52: {
-            /* LD D,D */
-            nop();
-            break;
-        }
-        case 0x53: {
-            load(d_e_.high(), d_e_.low());
-            break;
-        }
-        case 0x54: {
-            load(d_e_.high(), h_l_.high());
-            break;
-        }
-        case 0x55: {
-            load(d_e_.high(), h_l_.low());
-            break;
-        }
-        case 0x56: {
-            load(d_e_.high(), read_data(make_address(h_l_)));
-            break;
-        }
-        case 0x57: {
-            load(d_e_.high(), a_f_.high());
-            break;
-        }
-        case 0x58: {
-            load(d_e_.low(), b_c_.high());
-            break;
-        }
-        case 0x59: {
-            load(d_e_.low(), b_c_.low());
-            break;
-        }
-        case 0x5A: {
-            load(d_e_.low(), d_e_.high());
-            break;
-        }
-        case 0x5B: {
-            /* LD E,E */
-            nop();
-            break;
-        }
-        case 0x5C: {
-            load(d_e_.low(), h_l_.high());
-            break;
-        }
-        case 0x5D: {
-            load(d_e_.low(), h_l_.low());
-            break;
-        }
-        case 0x5E: {
-            load(d_e_.low(), read_data(make_address(h_l_)));
-            break;
-        }
-        case 0x5F: {
-            load(d_e_.low(), a_f_.high());
-            break;
-        }
-        case 0x60: {
-            load(h_l_.high(), b_c_.high());
-            break;
-        }
-        case 0x61: {
-            load(h_l_.high(), b_c_.low());
-            break;
-        }
-        case 0x62: {
-            load(h_l_.high(), d_e_.high());
-            break;
-        }
-        case 0x63: {
-            load(h_l_.high(), d_e_.low());
-            break;
-        }
-        case 0x64: {
-            /* LD H, H */
-            nop();
-            break;
-        }
-        case 0x65: {
-            load(h_l_.high(), h_l_.low());
-            break;
-        }
-        case 0x66: {
-            load(h_l_.high(), read_data(make_address(h_l_)));
-            break;
-        }
-        case 0x67: {
-            load(h_l_.high(), a_f_.high());
-            break;
-        }
-        case 0x68: {
-            load(h_l_.low(), b_c_.high());
-            break;
-        }
-        case 0x69: {
-            load(h_l_.low(), b_c_.low());
-            break;
-        }
-        case 0x6A: {
-            load(h_l_.low(), d_e_.high());
-            break;
-        }
-        case 0x6B: {
-            load(h_l_.low(), d_e_.low());
-            break;
-        }
-        case 0x6C: {
-            load(h_l_.low(), h_l_.high());
-            break;
-        }
-        case 0x6D: {
-            /* LD L, L */
-            nop();
-            break;
-        }
-        case 0x6E: {
-            load(h_l_.low(), read_data(make_address(h_l_)));
-            break;
-        }
-        case 0x6F: {
-            load(h_l_.low(), a_f_.high());
-            break;
-        }
-        case 0x70: {
-            store(make_address(h_l_), b_c_.high());
-            break;
-        }
-        case 0x71: {
-            store(make_address(h_l_), b_c_.low());
-            break;
-        }
-        case 0x72: {
-            store(make_address(h_l_), d_e_.high());
-            break;
-        }
-        case 0x73: {
-            store(make_address(h_l_), d_e_.low());
-            break;
-        }
-        case 0x74: {
-            store(make_address(h_l_), h_l_.high());
-            break;
-        }
-        case 0x75: {
-            store(make_address(h_l_), h_l_.low());
-            break;
-        }
-        case 0x76: {
-            halt();
-            break;
-        }
-        case 0x77: {
-            store(make_address(h_l_), a_f_.high());
-            break;
-        }
-        case 0x78: {
-            load(a_f_.high(), b_c_.high());
-            break;
-        }
-        case 0x79: {
-            load(a_f_.high(), b_c_.low());
-            break;
-        }
-        case 0x7A: {
-            load(a_f_.high(), d_e_.high());
-            break;
-        }
-        case 0x7B: {
-            load(a_f_.high(), d_e_.low());
-            break;
-        }
-        case 0x7C: {
-            load(a_f_.high(), h_l_.high());
-            break;
-        }
-        case 0x7D: {
-            load(a_f_.high(), h_l_.low());
-            break;
-        }
-        case 0x7E: {
-            load(a_f_.high(), read_data(make_address(h_l_)));
-            break;
-        }
-        case 0x7F: {
-            /* LD A,A */
-            nop();
-            break;
-        }
-        case 0x80: {
-            alu_.add(b_c_.high());
-            break;
-        }
-        case 0x81: {
-            alu_.add(b_c_.low());
-            break;
-        }
-        case 0x82: {
-            alu_.add(d_e_.high());
-            break;
-        }
-        case 0x83: {
-            alu_.add(d_e_.low());
-            break;
-        }
-        case 0x84: {
-            alu_.add(h_l_.high());
-            break;
-        }
-        case 0x85: {
-            alu_.add(h_l_.low());
-            break;
-        }
-        case 0x86: {
-            alu_.add(read_data(make_address(h_l_)));
-            break;
-        }
-        case 0x87: {
-            alu_.add(a_f_.high());
-            break;
-        }
-        case 0x88: {
-            alu_.add_c(b_c_.high());
-            break;
-        }
-        case 0x89: {
-            alu_.add_c(b_c_.low());
-            break;
-        }
-        case 0x8A: {
-            alu_.add_c(d_e_.high());
-            break;
-        }
-        case 0x8B: {
-            alu_.add_c(d_e_.low());
-            break;
-        }
-        case 0x8C: {
-            alu_.add_c(h_l_.high());
-            break;
-        }
-        case 0x8D: {
-            alu_.add_c(h_l_.low());
-            break;
-        }
-        case 0x8E: {
-            alu_.add_c(read_data(make_address(h_l_)));
-            break;
-        }
-        case 0x8F: {
-            alu_.add_c(a_f_.high());
-            break;
-        }
-        case 0x90: {
-            alu_.subtract(b_c_.high());
-            break;
-        }
-        case 0x91: {
-            alu_.subtract(b_c_.low());
-            break;
-        }
-        case 0x92: {
-            alu_.subtract(d_e_.high());
-            break;
-        }
-        case 0x93: {
-            alu_.subtract(d_e_.low());
-            break;
-        }
-        case 0x94: {
-            alu_.subtract(h_l_.high());
-            break;
-        }
-        case 0x95: {
-            alu_.subtract(h_l_.low());
-            break;
-        }
-        case 0x96: {
-            alu_.subtract(read_data(make_address(h_l_)));
-            break;
-        }
-        case 0x97: {
-            alu_.subtract(a_f_.high());
-            break;
-        }
-        case 0x98: {
-            alu_.subtract_c(b_c_.high());
-            break;
-        }
-        case 0x99: {
-            alu_.subtract_c(b_c_.low());
-            break;
-        }
-        case 0x9A: {
-            alu_.subtract_c(d_e_.high());
-            break;
-        }
-        case 0x9B: {
-            alu_.subtract_c(d_e_.low());
-            break;
-        }
-        case 0x9C: {
-            alu_.subtract_c(h_l_.high());
-            break;
-        }
-        case 0x9D: {
-            alu_.subtract_c(h_l_.low());
-            break;
-        }
-        case 0x9E: {
-            alu_.subtract_c(read_data(make_address(h_l_)));
-            break;
-        }
-        case 0x9F: {
-            alu_.subtract_c(a_f_.high());
-            break;
-        }
-        case 0xA0: {
-            alu_.logical_and(b_c_.high());
-            break;
-        }
-        case 0xA1: {
-            alu_.logical_and(b_c_.low());
-            break;
-        }
-        case 0xA2: {
-            alu_.logical_and(d_e_.high());
-            break;
-        }
-        case 0xA3: {
-            alu_.logical_and(d_e_.low());
-            break;
-        }
-        case 0xA4: {
-            alu_.logical_and(h_l_.high());
-            break;
-        }
-        case 0xA5: {
-            alu_.logical_and(h_l_.low());
-            break;
-        }
-        case 0xA6: {
-            alu_.logical_and(read_data(make_address(h_l_)));
-            break;
-        }
-        case 0xA7: {
-            alu_.logical_and(a_f_.high());
-            break;
-        }
-        case 0xA8: {
-            alu_.logical_xor(b_c_.high());
-            break;
-        }
-        case 0xA9: {
-            alu_.logical_xor(b_c_.low());
-            break;
-        }
-        case 0xAA: {
-            alu_.logical_xor(d_e_.high());
-            break;
-        }
-        case 0xAB: {
-            alu_.logical_xor(d_e_.low());
-            break;
-        }
-        case 0xAC: {
-            alu_.logical_xor(h_l_.high());
-            break;
-        }
-        case 0xAD: {
-            alu_.logical_xor(h_l_.low());
-            break;
-        }
-        case 0xAE: {
-            alu_.logical_xor(read_data(make_address(h_l_)));
-            break;
-        }
-        case 0xAF: {
-            alu_.logical_xor(a_f_.high());
-            break;
-        }
-        case 0xB0: {
-            alu_.logical_or(b_c_.high());
-            break;
-        }
-        case 0xB1: {
-            alu_.logical_or(b_c_.low());
-            break;
-        }
-        case 0xB2: {
-            alu_.logical_or(d_e_.high());
-            break;
-        }
-        case 0xB3: {
-            alu_.logical_or(d_e_.low());
-            break;
-        }
-        case 0xB4: {
-            alu_.logical_or(h_l_.high());
-            break;
-        }
-        case 0xB5: {
-            alu_.logical_or(h_l_.low());
-            break;
-        }
-        case 0xB6: {
-            alu_.logical_or(read_data(make_address(h_l_)));
-            break;
-        }
-        case 0xB7: {
-            alu_.logical_or(a_f_.high());
-            break;
-        }
-        case 0xB8: {
-            alu_.logical_compare(b_c_.high());
-            break;
-        }
-        case 0xB9: {
-            alu_.logical_compare(b_c_.low());
-            break;
-        }
-        case 0xBA: {
-            alu_.logical_compare(d_e_.high());
-            break;
-        }
-        case 0xBB: {
-            alu_.logical_compare(d_e_.low());
-            break;
-        }
-        case 0xBC: {
-            alu_.logical_compare(h_l_.high());
-            break;
-        }
-        case 0xBD: {
-            alu_.logical_compare(h_l_.low());
-            break;
-        }
-        case 0xBE: {
-            alu_.logical_compare(read_data(make_address(h_l_)));
-            break;
-        }
-        case 0xBF: {
-            alu_.logical_compare(a_f_.high());
-            break;
-        }
-        case 0xC0: {
-            if(!test_flag(flag::zero)) {
+    } else {
+        if constexpr(z == 0u) {
+            if constexpr(y < 4u) {
+                if(!condition<y>()) {
+                    return executed<Opcode>(data, false);
+                }
+
                 ret();
+            } else if constexpr(y == 4u) {
+                const uint16_t address = 0xFF00 + static_cast<uint8_t>(data);
+                store(make_address(address), a_f_.high());
+            } else if constexpr(y == 5u) {
+                alu_.add_to_stack_pointer(static_cast<int8_t>(data));
+            } else if constexpr(y == 6u) {
+                const uint16_t address = 0xFF00 + static_cast<uint8_t>(data);
+                load(a_f_.high(), read_data(make_address(address)));
             } else {
-                return false_branch();
+                load_hlsp(static_cast<int8_t>(data));
             }
-            break;
-        }
-        case 0xC1: {
-            pop(b_c_);
-            break;
-        }
-        case 0xC2: {
-            if(!test_flag(flag::zero)) {
-                jump(make_address(data));
+        } else if constexpr(z == 1u) {
+            if constexpr(q == 0u) {
+                pop(rp2<p>());
+                if constexpr(p == 3u) {
+                    a_f_.low() &= 0xF0;
+                }
+            } else if constexpr(p == 0u) {
+                ret();
+            } else if constexpr(p == 1u) {
+                reti();
+            } else if constexpr(p == 2u) {
+                jump(h_l_);
             } else {
-                return false_branch();
+                load(stack_pointer_, h_l_);
             }
-            break;
-        }
-        case 0xC3: {
-            jump(make_address(data));
-            break;
-        }
-        case 0xC4: {
-            if(!test_flag(flag::zero)) {
-                call(make_address(data));
-            } else {
-                return false_branch();
-            }
-            break;
-        }
-        case 0xC5: {
-            push(b_c_);
-            break;
-        }
-        case 0xC6: {
-            alu_.add(static_cast<uint8_t>(data));
-            break;
-        }
-        case 0xC7: {
-            rst(address8(0x00));
-            break;
-        }
-        case 0xC8: {
-            if(test_flag(flag::zero)) {
-                ret();
-            } else {
-                return false_branch();
-            }
-            break;
-        }
-        case 0xC9: {
-            ret();
-            break;
-        }
-        case 0xCA: {
-            if(test_flag(flag::zero)) {
-                jump(make_address(data));
-            } else {
-                return false_branch();
-            }
-            break;
-        }
-        case 0xCC: {
-            if(test_flag(flag::zero)) {
-                call(make_address(data));
-            } else {
-                return false_branch();
-            }
-            break;
-        }
-        case 0xCD: {
-            call(make_address(data));
-            break;
-        }
-        case 0xCE: {
-            alu_.add_c(static_cast<uint8_t>(data));
-            break;
-        }
-        case 0xCF: {
-            rst(address8(0x08));
-            break;
-        }
-        case 0xD0: {
-            if(!test_flag(flag::carry)) {
-                ret();
-            } else {
-                return false_branch();
-            }
-            break;
-        }
-        case 0xD1: {
-            pop(d_e_);
-            break;
-        }
-        case 0xD2: {
-            if(!test_flag(flag::carry)) {
-                jump(make_address(data));
-            } else {
-                return false_branch();
-            }
-            break;
-        }
-        case 0xD4: {
-            if(!test_flag(flag::carry)) {
-                call(make_address(data));
-            } else {
-                return false_branch();
-            }
-            break;
-        }
-        case 0xD5: {
-            push(d_e_);
-            break;
-        }
-        case 0xD6: {
-            alu_.subtract(static_cast<uint8_t>(data));
-            break;
-        }
-        case 0xD7: {
-            rst(address8(0x10));
-            break;
-        }
-        case 0xD8: {
-            if(test_flag(flag::carry)) {
-                ret();
-            } else {
-                return false_branch();
-            }
-            break;
-        }
-        case 0xD9: {
-            reti();
-            break;
-        }
-        case 0xDA: {
-            if(test_flag(flag::carry)) {
-                jump(make_address(data));
-            } else {
-                return false_branch();
-            }
-            break;
-        }
-        case 0xDC: {
-            if(test_flag(flag::carry)) {
-                call(make_address(data));
-            } else {
-                return false_branch();
-            }
-            break;
-        }
-        case 0xDE: {
-            alu_.subtract_c(static_cast<uint8_t>(data));
-            break;
-        }
-        case 0xDF: {
-            rst(address8(0x18));
-            break;
-        }
-        case 0xE0: {
-            const uint16_t address = 0xFF00 + static_cast<uint8_t>(data);
-            store(make_address(address), a_f_.high());
-            break;
-        }
-        case 0xE1: {
-            pop(h_l_);
-            break;
-        }
-        case 0xE2: {
-            const auto address = make_address(b_c_.low() + 0xFF00);
-            store(address, a_f_.high());
-            break;
-        }
-        case 0xE5: {
-            push(h_l_);
-            break;
-        }
-        case 0xE6: {
-            alu_.logical_and(static_cast<uint8_t>(data));
-            break;
-        }
-        case 0xE7: {
-            rst(address8(0x20));
-            break;
-        }
-        case 0xE8: {
-            alu_.add_to_stack_pointer(static_cast<int8_t>(data));
-            break;
-        }
-        case 0xE9: {
-            jump(h_l_);
-            break;
-        }
-        case 0xEA: {
-            store(make_address(data), a_f_.high());
-            break;
-        }
-        case 0xEE: {
-            alu_.logical_xor(static_cast<uint8_t>(data));
-            break;
-        }
-        case 0xEF: {
-            rst(address8(0x28));
-            break;
-        }
-        case 0xF0: {
-            const uint16_t address = 0xFF00 + static_cast<uint8_t>(data);
-            load(a_f_.high(), read_data(make_address(address)));
-            break;
-        }
-        case 0xF1: {
-            pop(a_f_);
-            a_f_.low() &= 0xF0;
-            break;
-        }
-        case 0xF2: {
-            load(a_f_.high(), read_data(make_address(b_c_.low() + 0xFF00)));
-            break;
-        }
-        case 0xF3: {
-            pending_enable_interrupts_counter_ = -1;
-            if(pending_disable_interrupts_counter_ == -1) {
-                pending_disable_interrupts_counter_ = 1;
-            }
-            break;
-        }
-        case 0xF5: {
-            push(a_f_);
-            break;
-        }
-        case 0xF6: {
-            alu_.logical_or(static_cast<uint8_t>(data));
-            break;
-        }
-        case 0xF7: {
-            rst(address8(0x30));
-            break;
-        }
-        case 0xF8: {
-            load_hlsp(static_cast<int8_t>(data));
-            break;
-        }
-        case 0xF9: {
-            load(stack_pointer_, h_l_);
-            break;
-        }
-        case 0xFA: {
-            load(a_f_.high(), read_data(make_address(data)));
-            break;
-        }
-        case 0xFB: {
-            pending_disable_interrupts_counter_ = -1;
-            if(pending_enable_interrupts_counter_ == -1) {
-                pending_enable_interrupts_counter_ = 1;
-            }
-            break;
-        }
-        case 0xFE: {
-            alu_.logical_compare(static_cast<uint8_t>(data));
-            break;
-        }
-        case 0xFF: {
-            rst(address8(0x38));
-            break;
-        }
-        default: {
-            spdlog::critical("unknown instruction: {:#x}, address: {:#x}", inst, program_counter_.value() - info.length);
-            std::terminate();
-        }
-    }
-
-#if WITH_DEBUGGER
-    if(on_instruction_executed_) {
-        on_instruction_executed_(make_address(prev_program_counter_), info, data);
-    }
-#endif //WITH_DEBUGGER
-
-    return info.cycle_count;
-}
-
-uint8_t cpu::decode(const uint8_t inst, extended_instruction_set_t)
-{
-    switch(inst) {
-        case 0x00: {
-            alu_.rotate_left_c(b_c_.high());
-            break;
-        }
-        case 0x01: {
-            alu_.rotate_left_c(b_c_.low());
-            break;
-        }
-        case 0x02: {
-            alu_.rotate_left_c(d_e_.high());
-            break;
-        }
-        case 0x03: {
-            alu_.rotate_left_c(d_e_.low());
-            break;
-        }
-        case 0x04: {
-            alu_.rotate_left_c(h_l_.high());
-            break;
-        }
-        case 0x05: {
-            alu_.rotate_left_c(h_l_.low());
-            break;
-        }
-        case 0x06: {
-            const auto address = make_address(h_l_);
-            auto data = read_data(address);
-            alu_.rotate_left_c(data);
-            write_data(address, data);
-            break;
-        }
-        case 0x07: {
-            alu_.rotate_left_c(a_f_.high());
-            break;
-        }
-        case 0x08: {
-            alu_.rotate_right_c(b_c_.high());
-            break;
-        }
-        case 0x09: {
-            alu_.rotate_right_c(b_c_.low());
-            break;
-        }
-        case 0x0A: {
-            alu_.rotate_right_c(d_e_.high());
-            break;
-        }
-        case 0x0B: {
-            alu_.rotate_right_c(d_e_.low());
-            break;
-        }
-        case 0x0C: {
-            alu_.rotate_right_c(h_l_.high());
-            break;
-        }
-        case 0x0D: {
-            alu_.rotate_right_c(h_l_.low());
-            break;
-        }
-        case 0x0E: {
-            const auto address = make_address(h_l_);
-            auto data = read_data(address);
-            alu_.rotate_right_c(data);
-            write_data(address, data);
-            break;
-        }
-        case 0x0F: {
-            alu_.rotate_right_c(a_f_.high());
-            break;
-        }
-        case 0x10: {
-            alu_.rotate_left(b_c_.high());
-            break;
-        }
-        case 0x11: {
-            alu_.rotate_left(b_c_.low());
-            break;
-        }
-        case 0x12: {
-            alu_.rotate_left(d_e_.high());
-            break;
-        }
-        case 0x13: {
-            alu_.rotate_left(d_e_.low());
-            break;
-        }
-        case 0x14: {
-            alu_.rotate_left(h_l_.high());
-            break;
-        }
-        case 0x15: {
-            alu_.rotate_left(h_l_.low());
-            break;
-        }
-        case 0x16: {
-            const auto address = make_address(h_l_);
-            auto data = read_data(address);
-            alu_.rotate_left(data);
-            write_data(address, data);
-            break;
-        }
-        case 0x17: {
-            alu_.rotate_left(a_f_.high());
-            break;
-        }
-        case 0x18: {
-            alu_.rotate_right(b_c_.high());
-            break;
-        }
-        case 0x19: {
-            alu_.rotate_right(b_c_.low());
-            break;
-        }
-        case 0x1A: {
-            alu_.rotate_right(d_e_.high());
-            break;
-        }
-        case 0x1B: {
-            alu_.rotate_right(d_e_.low());
-            break;
-        }
-        case 0x1C: {
-            alu_.rotate_right(h_l_.high());
-            break;
-        }
-        case 0x1D: {
-            alu_.rotate_right(h_l_.low());
-            break;
-        }
-        case 0x1E: {
-            const auto address = make_address(h_l_);
-            auto data = read_data(address);
-            alu_.rotate_right(data);
-            write_data(address, data);
-            break;
-        }
-        case 0x1F: {
-            alu_.rotate_right(a_f_.high());
-            break;
-        }
-        case 0x20: {
-            alu_.shift_left(b_c_.high());
-            break;
-        }
-        case 0x21: {
-            alu_.shift_left(b_c_.low());
-            break;
-        }
-        case 0x22: {
-            alu_.shift_left(d_e_.high());
-            break;
-        }
-        case 0x23: {
-            alu_.shift_left(d_e_.low());
-            break;
-        }
-        case 0x24: {
-            alu_.shift_left(h_l_.high());
-            break;
-        }
-        case 0x25: {
-            alu_.shift_left(h_l_.low());
-            break;
-        }
-        case 0x26: {
-            const auto address = make_address(h_l_);
-            auto data = read_data(address);
-            alu_.shift_left(data);
-            write_data(address, data);
-            break;
-        }
-        case 0x27: {
-            alu_.shift_left(a_f_.high());
-            break;
-        }
-        case 0x28: {
-            alu_.shift_right(b_c_.high(), alu::preserve_last_bit);
-            break;
-        }
-        case 0x29: {
-            alu_.shift_right(b_c_.low(), alu::preserve_last_bit);
-            break;
-        }
-        case 0x2A: {
-            alu_.shift_right(d_e_.high(), alu::preserve_last_bit);
-            break;
-        }
-        case 0x2B: {
-            alu_.shift_right(d_e_.low(), alu::preserve_last_bit);
-            break;
-        }
-        case 0x2C: {
-            alu_.shift_right(h_l_.high(), alu::preserve_last_bit);
-            break;
-        }
-        case 0x2D: {
-            alu_.shift_right(h_l_.low(), alu::preserve_last_bit);
-            break;
-        }
-        case 0x2E: {
-            const auto address = make_address(h_l_);
-            auto data = read_data(address);
-            alu_.shift_right(data, alu::preserve_last_bit);
-            write_data(address, data);
-            break;
-        }
-        case 0x2F: {
-            alu_.shift_right(a_f_.high(), alu::preserve_last_bit);
-            break;
-        }
-        case 0x30: {
-            alu_.swap(b_c_.high());
-            break;
-        }
-        case 0x31: {
-            alu_.swap(b_c_.low());
-            break;
-        }
-        case 0x32: {
-            alu_.swap(d_e_.high());
-            break;
-        }
-        case 0x33: {
-            alu_.swap(d_e_.low());
-            break;
-        }
-        case 0x34: {
-            alu_.swap(h_l_.high());
-            break;
-        }
-        case 0x35: {
-            alu_.swap(h_l_.low());
-            break;
-        }
-        case 0x36: {
-            const auto address = make_address(h_l_);
-            auto data = read_data(address);
-            alu_.swap(data);
-            write_data(address, data);
-            break;
-        }
-        case 0x37: {
-            alu_.swap(a_f_.high());
-            break;
-        }
-        case 0x38: {
-            alu_.shift_right(b_c_.high(), alu::reset_last_bit);
-            break;
-        }
-        case 0x39: {
-            alu_.shift_right(b_c_.low(), alu::reset_last_bit);
-            break;
-        }
-        case 0x3A: {
-            alu_.shift_right(d_e_.high(), alu::reset_last_bit);
-            break;
-        }
-        case 0x3B: {
-            alu_.shift_right(d_e_.low(), alu::reset_last_bit);
-            break;
-        }
-        case 0x3C: {
-            alu_.shift_right(h_l_.high(), alu::reset_last_bit);
-            break;
-        }
-        case 0x3D: {
-            alu_.shift_right(h_l_.low(), alu::reset_last_bit);
-            break;
-        }
-        case 0x3E: {
-            const auto address = make_address(h_l_);
-            auto data = read_data(address);
-            alu_.shift_right(data, alu::reset_last_bit);
-            write_data(address, data);
-            break;
-        }
-        case 0x3F: {
-            alu_.shift_right(a_f_.high(), alu::reset_last_bit);
-            break;
-        }
-
-        case 0x40: {
-            alu_.test(b_c_.high(), 0);
-            break;
-        }
-        case 0x41: {
-            alu_.test(b_c_.low(), 0);
-            break;
-        }
-        case 0x42: {
-            alu_.test(d_e_.high(), 0);
-            break;
-        }
-        case 0x43: {
-            alu_.test(d_e_.low(), 0);
-            break;
-        }
-        case 0x44: {
-            alu_.test(h_l_.high(), 0);
-            break;
-        }
-        case 0x45: {
-            alu_.test(h_l_.low(), 0);
-            break;
-        }
-        case 0x46: {
-            const auto addr = make_address(h_l_);
-            auto data = read_data(addr);
-            alu_.test(data, 0);
-            write_data(addr, data);
-            break;
-        }
-        case 0x47: {
-            alu_.test(a_f_.high(), 0);
-            break;
-        }
-
-        case 0x48: {
-            alu_.test(b_c_.high(), 1);
-            break;
-        }
-        case 0x49: {
-            alu_.test(b_c_.low(), 1);
-            break;
-        }
-        case 0x4A: {
-            alu_.test(d_e_.high(), 1);
-            break;
-        }
-        case 0x4B: {
-            alu_.test(d_e_.low(), 1);
-            break;
-        }
-        case 0x4C: {
-            alu_.test(h_l_.high(), 1);
-            break;
-        }
-        case 0x4D: {
-            alu_.test(h_l_.low(), 1);
-            break;
-        }
-        case 0x4E: {
-            const auto addr = make_address(h_l_);
-            auto data = read_data(addr);
-            alu_.test(data, 1);
-            write_data(addr, data);
-            break;
-        }
-        case 0x4F: {
-            alu_.test(a_f_.high(), 1);
-            break;
-        }
+        } else if constexpr(z == 2u) {
+            if constexpr(y < 4u) {
+                if(!condition<y>()) {
+                    return executed<Opcode>(data, false);
+                }
 
-        case 0x50: {
-            alu_.test(b_c_.high(), 2);
-            break;
-        }
-        case 0x51: {
-            alu_.test(b_c_.low(), 2);
-            break;
-        }
-        case 0x52: {
-            alu_.test(d_e_.high(), 2);
-            break;
-        }
-        case 0x53: {
-            alu_.test(d_e_.low(), 2);
-            break;
-        }
-        case 0x54: {
-            alu_.test(h_l_.high(), 2);
-            break;
-        }
-        case 0x55: {
-            alu_.test(h_l_.low(), 2);
-            break;
-        }
-        case 0x56: {
-            const auto addr = make_address(h_l_);
-            auto data = read_data(addr);
-            alu_.test(data, 2);
-            write_data(addr, data);
-            break;
-        }
-        case 0x57: {
-            alu_.test(a_f_.high(), 2);
-            break;
-        }
-
-        case 0x58: {
-            alu_.test(b_c_.high(), 3);
-            break;
-        }
-        case 0x59: {
-            alu_.test(b_c_.low(), 3);
-            break;
-        }
-        case 0x5A: {
-            alu_.test(d_e_.high(), 3);
-            break;
-        }
-        case 0x5B: {
-            alu_.test(d_e_.low(), 3);
-            break;
-        }
-        case 0x5C: {
-            alu_.test(h_l_.high(), 3);
-            break;
-        }
-        case 0x5D: {
-            alu_.test(h_l_.low(), 3);
-            break;
-        }
-        case 0x5E: {
-            const auto addr = make_address(h_l_);
-            auto data = read_data(addr);
-            alu_.test(data, 3);
-            write_data(addr, data);
-            break;
-        }
-        case 0x5F: {
-            alu_.test(a_f_.high(), 3);
-            break;
-        }
-
-        case 0x60: {
-            alu_.test(b_c_.high(), 4);
-            break;
-        }
-        case 0x61: {
-            alu_.test(b_c_.low(), 4);
-            break;
-        }
-        case 0x62: {
-            alu_.test(d_e_.high(), 4);
-            break;
-        }
-        case 0x63: {
-            alu_.test(d_e_.low(), 4);
-            break;
-        }
-        case 0x64: {
-            alu_.test(h_l_.high(), 4);
-            break;
-        }
-        case 0x65: {
-            alu_.test(h_l_.low(), 4);
-            break;
-        }
-        case 0x66: {
-            const auto addr = make_address(h_l_);
-            auto data = read_data(addr);
-            alu_.test(data, 4);
-            write_data(addr, data);
-            break;
-        }
-        case 0x67: {
-            alu_.test(a_f_.high(), 4);
-            break;
-        }
-
-        case 0x68: {
-            alu_.test(b_c_.high(), 5);
-            break;
-        }
-        case 0x69: {
-            alu_.test(b_c_.low(), 5);
-            break;
-        }
-        case 0x6A: {
-            alu_.test(d_e_.high(), 5);
-            break;
-        }
-        case 0x6B: {
-            alu_.test(d_e_.low(), 5);
-            break;
-        }
-        case 0x6C: {
-            alu_.test(h_l_.high(), 5);
-            break;
-        }
-        case 0x6D: {
-            alu_.test(h_l_.low(), 5);
-            break;
-        }
-        case 0x6E: {
-            const auto addr = make_address(h_l_);
-            auto data = read_data(addr);
-            alu_.test(data, 5);
-            write_data(addr, data);
-            break;
-        }
-        case 0x6F: {
-            alu_.test(a_f_.high(), 5);
-            break;
-        }
-
-        case 0x70: {
-            alu_.test(b_c_.high(), 6);
-            break;
-        }
-        case 0x71: {
-            alu_.test(b_c_.low(), 6);
-            break;
-        }
-        case 0x72: {
-            alu_.test(d_e_.high(), 6);
-            break;
-        }
-        case 0x73: {
-            alu_.test(d_e_.low(), 6);
-            break;
-        }
-        case 0x74: {
-            alu_.test(h_l_.high(), 6);
-            break;
-        }
-        case 0x75: {
-            alu_.test(h_l_.low(), 6);
-            break;
-        }
-        case 0x76: {
-            const auto addr = make_address(h_l_);
-            auto data = read_data(addr);
-            alu_.test(data, 6);
-            write_data(addr, data);
-            break;
-        }
-        case 0x77: {
-            alu_.test(a_f_.high(), 6);
-            break;
-        }
-
-        case 0x78: {
-            alu_.test(b_c_.high(), 7);
-            break;
-        }
-        case 0x79: {
-            alu_.test(b_c_.low(), 7);
-            break;
-        }
-        case 0x7A: {
-            alu_.test(d_e_.high(), 7);
-            break;
-        }
-        case 0x7B: {
-            alu_.test(d_e_.low(), 7);
-            break;
-        }
-        case 0x7C: {
-            alu_.test(h_l_.high(), 7);
-            break;
-        }
-        case 0x7D: {
-            alu_.test(h_l_.low(), 7);
-            break;
-        }
-        case 0x7E: {
-            const auto addr = make_address(h_l_);
-            auto data = read_data(addr);
-            alu_.test(data, 7);
-            write_data(addr, data);
-            break;
-        }
-        case 0x7F: {
-            alu_.test(a_f_.high(), 7);
-            break;
-        }
-
-        case 0x80: {
-            alu_.reset(b_c_.high(), 0);
-            break;
-        }
-        case 0x81: {
-            alu_.reset(b_c_.low(), 0);
-            break;
-        }
-        case 0x82: {
-            alu_.reset(d_e_.high(), 0);
-            break;
-        }
-        case 0x83: {
-            alu_.reset(d_e_.low(), 0);
-            break;
-        }
-        case 0x84: {
-            alu_.reset(h_l_.high(), 0);
-            break;
-        }
-        case 0x85: {
-            alu_.reset(h_l_.low(), 0);
-            break;
-        }
-        case 0x86: {
-            const auto addr = make_address(h_l_);
-            auto data = read_data(addr);
-            alu::reset(data, 0);
-            write_data(addr, data);
-            break;
-        }
-        case 0x87: {
-            alu_.reset(a_f_.high(), 0);
-            break;
-        }
-
-        case 0x88: {
-            alu_.reset(b_c_.high(), 1);
-            break;
-        }
-        case 0x89: {
-            alu_.reset(b_c_.low(), 1);
-            break;
-        }
-        case 0x8A: {
-            alu_.reset(d_e_.high(), 1);
-            break;
-        }
-        case 0x8B: {
-            alu_.reset(d_e_.low(), 1);
-            break;
-        }
-        case 0x8C: {
-            alu_.reset(h_l_.high(), 1);
-            break;
-        }
-        case 0x8D: {
-            alu_.reset(h_l_.low(), 1);
-            break;
-        }
-        case 0x8E: {
-            const auto addr = make_address(h_l_);
-            auto data = read_data(addr);
-            alu::reset(data, 1);
-            write_data(addr, data);
-            break;
-        }
-        case 0x8F: {
-            alu_.reset(a_f_.high(), 1);
-            break;
-        }
-
-        case 0x90: {
-            alu_.reset(b_c_.high(), 2);
-            break;
-        }
-        case 0x91: {
-            alu_.reset(b_c_.low(), 2);
-            break;
-        }
-        case 0x92: {
-            alu_.reset(d_e_.high(), 2);
-            break;
-        }
-        case 0x93: {
-            alu_.reset(d_e_.low(), 2);
-            break;
-        }
-        case 0x94: {
-            alu_.reset(h_l_.high(), 2);
-            break;
-        }
-        case 0x95: {
-            alu_.reset(h_l_.low(), 2);
-            break;
-        }
-        case 0x96: {
-            const auto addr = make_address(h_l_);
-            auto data = read_data(addr);
-            alu::reset(data, 2);
-            write_data(addr, data);
-            break;
-        }
-        case 0x97: {
-            alu_.reset(a_f_.high(), 2);
-            break;
-        }
-
-        case 0x98: {
-            alu_.reset(b_c_.high(), 3);
-            break;
-        }
-        case 0x99: {
-            alu_.reset(b_c_.low(), 3);
-            break;
-        }
-        case 0x9A: {
-            alu_.reset(d_e_.high(), 3);
-            break;
-        }
-        case 0x9B: {
-            alu_.reset(d_e_.low(), 3);
-            break;
-        }
-        case 0x9C: {
-            alu_.reset(h_l_.high(), 3);
-            break;
-        }
-        case 0x9D: {
-            alu_.reset(h_l_.low(), 3);
-            break;
-        }
-        case 0x9E: {
-            const auto addr = make_address(h_l_);
-            auto data = read_data(addr);
-            alu::reset(data, 3);
-            write_data(addr, data);
-            break;
-        }
-        case 0x9F: {
-            alu_.reset(a_f_.high(), 3);
-            break;
-        }
-
-        case 0xA0: {
-            alu_.reset(b_c_.high(), 4);
-            break;
-        }
-        case 0xA1: {
-            alu_.reset(b_c_.low(), 4);
-            break;
-        }
-        case 0xA2: {
-            alu_.reset(d_e_.high(), 4);
-            break;
-        }
-        case 0xA3: {
-            alu_.reset(d_e_.low(), 4);
-            break;
-        }
-        case 0xA4: {
-            alu_.reset(h_l_.high(), 4);
-            break;
-        }
-        case 0xA5: {
-            alu_.reset(h_l_.low(), 4);
-            break;
-        }
-        case 0xA6: {
-            const auto addr = make_address(h_l_);
-            auto data = read_data(addr);
-            alu::reset(data, 4);
-            write_data(addr, data);
-            break;
-        }
-        case 0xA7: {
-            alu_.reset(a_f_.high(), 4);
-            break;
-        }
+                jump(make_address(data));
+            } else if constexpr(y == 4u) {
+                const auto address = make_address(b_c_.low() + 0xFF00);
+                store(address, a_f_.high());
+            } else if constexpr(y == 5u) {
+                store(make_address(data), a_f_.high());
+            } else if constexpr(y == 6u) {
+                load(a_f_.high(), read_data(make_address(b_c_.low() + 0xFF00)));
+            } else {
+                load(a_f_.high(), read_data(make_address(data)));
+            }
+        } else if constexpr(z == 3u && y == 0u) {
+            jump(make_address(data));
+        } else if constexpr(z == 3u && y == 6u) {
+            pending_enable_interrupts_counter_ = -1;
+            if(pending_disable_interrupts_counter_ == -1) {
+                pending_disable_interrupts_counter_ = 1;
+            }
+        } else if constexpr(z == 3u && y == 7u) {
+            pending_disable_interrupts_counter_ = -1;
+            if(pending_enable_interrupts_counter_ == -1) {
+                pending_enable_interrupts_counter_ = 1;
+            }
+        } else if constexpr(z == 4u && y < 4u) {
+            if(!condition<y>()) {
+                return executed<Opcode>(data, false);
+            }
 
-        case 0xA8: {
-            alu_.reset(b_c_.high(), 5);
-            break;
-        }
-        case 0xA9: {
-            alu_.reset(b_c_.low(), 5);
-            break;
-        }
-        case 0xAA: {
-            alu_.reset(d_e_.high(), 5);
-            break;
-        }
-        case 0xAB: {
-            alu_.reset(d_e_.low(), 5);
-            break;
-        }
-        case 0xAC: {
-            alu_.reset(h_l_.high(), 5);
-            break;
-        }
-        case 0xAD: {
-            alu_.reset(h_l_.low(), 5);
-            break;
-        }
-        case 0xAE: {
-            const auto addr = make_address(h_l_);
-            auto data = read_data(addr);
-            alu::reset(data, 5);
-            write_data(addr, data);
-            break;
-        }
-        case 0xAF: {
-            alu_.reset(a_f_.high(), 5);
-            break;
+            call(make_address(data));
+        } else if constexpr(z == 5u && q == 0u) {
+            push(rp2<p>());
+        } else if constexpr(z == 5u && p == 0u) {
+            call(make_address(data));
+        } else if constexpr(z == 6u) {
+            arithmetic<y>(static_cast<uint8_t>(data));
+        } else if constexpr(z == 7u) {
+            rst(address8(static_cast<uint8_t>(y * 8u)));
+        } else {
+            constexpr auto length = instruction::standard_instruction_set[Opcode].length;
+            spdlog::critical("unknown instruction: {:#x}, address: {:#x}", Opcode, program_counter_.value() - length);
+            std::terminate();
         }
+    }
 
-        case 0xB0: {
-            alu_.reset(b_c_.high(), 6);
-            break;
-        }
-        case 0xB1: {
-            alu_.reset(b_c_.low(), 6);
-            break;
-        }
-        case 0xB2: {
-            alu_.reset(d_e_.high(), 6);
-            break;
-        }
-        case 0xB3: {
-            alu_.reset(d_e_.low(), 6);
-            break;
-        }
-        case 0xB4: {
-            alu_.reset(h_l_.high(), 6);
-            break;
-        }
-        case 0xB5: {
-            alu_.reset(h_l_.low(), 6);
-            break;
-        }
-        case 0xB6: {
-            const auto addr = make_address(h_l_);
-            auto data = read_data(addr);
-            alu::reset(data, 6);
-            write_data(addr, data);
-            break;
-        }
-        case 0xB7: {
-            alu_.reset(a_f_.high(), 6);
-            break;
-        }
+    return executed<Opcode>(data, true);
+}
 
-        case 0xB8: {
-            alu_.reset(b_c_.high(), 7);
-            break;
-        }
-        case 0xB9: {
-            alu_.reset(b_c_.low(), 7);
-            break;
-        }
-        case 0xBA: {
-            alu_.reset(d_e_.high(), 7);
-            break;
-        }
-        case 0xBB: {
-            alu_.reset(d_e_.low(), 7);
-            break;
-        }
-        case 0xBC: {
-            alu_.reset(h_l_.high(), 7);
-            break;
-        }
-        case 0xBD: {
-            alu_.reset(h_l_.low(), 7);
-            break;
-        }
-        case 0xBE: {
-            const auto addr = make_address(h_l_);
-            auto data = read_data(addr);
-            alu::reset(data, 7);
-            write_data(addr, data);
-            break;
-        }
-        case 0xBF: {
-            alu_.reset(a_f_.high(), 7);
-            break;
+template<uint8_t Opcode>
+uint8_t cpu::extended_instruction()
+{
+    constexpr uint8_t x = Opcode >> 6u;
+    constexpr uint8_t y = (Opcode >> 3u) & 0x07u;
+    constexpr uint8_t z = Opcode & 0x07u;
+
+    const auto operation = [&](auto& value) {
+        if constexpr(x == 0u) {
+            if constexpr(y == 0u) {
+                alu_.rotate_left_c(value);
+            } else if constexpr(y == 1u) {
+                alu_.rotate_right_c(value);
+            } else if constexpr(y == 2u) {
+                alu_.rotate_left(value);
+            } else if constexpr(y == 3u) {
+                alu_.rotate_right(value);
+            } else if constexpr(y == 4u) {
+                alu_.shift_left(value);
+            } else if constexpr(y == 5u) {
+                alu_.shift_right(value, alu::preserve_last_bit);
+            } else if constexpr(y == 6u) {
+                alu_.swap(value);
+            } else {
+                alu_.shift_right(value, alu::reset_last_bit);
+            }
+        } else if constexpr(x == 1u) {
+            alu_.test(value, y);
+        } else if constexpr(x == 2u) {
+            if constexpr(std::is_same_v<std::decay_t<decltype(value)>, uint8_t>) {
+                alu::reset(value, y);
+            } else {
+                alu_.reset(value, y);
+            }
+        } else {
+            if constexpr(std::is_same_v<std::decay_t<decltype(value)>, uint8_t>) {
+                alu::set(value, y);
+            } else {
+                alu_.set(value, y);
+            }
         }
+    };
 
-        case 0xC0: {
-            alu_.set(b_c_.high(), 0);
-            break;
-        }
-        case 0xC1: {
-            alu_.set(b_c_.low(), 0);
-            break;
-        }
-        case 0xC2: {
-            alu_.set(d_e_.high(), 0);
-            break;
-        }
-        case 0xC3: {
-            alu_.set(d_e_.low(), 0);
-            break;
-        }
-        case 0xC4: {
-            alu_.set(h_l_.high(), 0);
-            break;
-        }
-        case 0xC5: {
-            alu_.set(h_l_.low(), 0);
-            break;
-        }
-        case 0xC6: {
-            const auto addr = make_address(h_l_);
-            auto data = read_data(addr);
-            alu::set(data, 0);
-            write_data(addr, data);
-            break;
-        }
-        case 0xC7: {
-            alu_.set(a_f_.high(), 0);
-            break;
-        }
+    if constexpr(z == hl_indirect) {
+        // BIT n,(HL) writes the value back as well
+        const auto address = make_address(h_l_);
+        auto data = read_data(address);
+        operation(data);
+        write_data(address, data);
+    } else {
+        operation(r8<z>());
+    }
 
-        case 0xC8: {
-            alu_.set(b_c_.high(), 1);
-            break;
-        }
-        case 0xC9: {
-            alu_.set(b_c_.low(), 1);
-            break;
-        }
-        case 0xCA: {
-            alu_.set(d_e_.high(), 1);
-            break;
-        }
-        case 0xCB: {
-            alu_.set(d_e_.low(), 1);
-            break;
-        }
-        case 0xCC: {
-            alu_.set(h_l_.high(), 1);
-            break;
-        }
-        case 0xCD: {
-            alu_.set(h_l_.low(), 1);
-            break;
-        }
-        case 0xCE: {
-            const auto addr = make_address(h_l_);
-            auto data = read_data(addr);
-            alu::set(data, 1);
-            write_data(addr, data);
-            break;
-        }
-        case 0xCF: {
-            alu_.set(a_f_.high(), 1);
-            break;
-        }
+    const auto& info = instruction::extended_instruction_set[Opcode];
 
-        case 0xD0: {
-            alu_.set(b_c_.high(), 2);
-            break;
-        }
-        case 0xD1: {
-            alu_.set(b_c_.low(), 2);
-            break;
-        }
-        case 0xD2: {
-            alu_.set(d_e_.high(), 2);
-            break;
-        }
-        case 0xD3: {
-            alu_.set(d_e_.low(), 2);
-            break;
-        }
-        case 0xD4: {
-            alu_.set(h_l_.high(), 2);
-            break;
-        }
-        case 0xD5: {
-            alu_.set(h_l_.low(), 2);
-            break;
-        }
-        case 0xD6: {
-            const auto addr = make_address(h_l_);
-            auto data = read_data(addr);
-            alu::set(data, 2);
-            write_data(addr, data);
-            break;
-        }
-        case 0xD7: {
-            alu_.set(a_f_.high(), 2);
-            break;
-        }
+#if WITH_DEBUGGER
+    if(on_instruction_executed_) {
+        on_instruction_executed_(make_address(prev_program_counter_), info, 0u);
+    }
+#endif //WITH_DEBUGGER
 
-        case 0xD8: {
-            alu_.set(b_c_.high(), 3);
-            break;
-        }
-        case 0xD9: {
-            alu_.set(b_c_.low(), 3);
-            break;
-        }
-        case 0xDA: {
-            alu_.set(d_e_.high(), 3);
-            break;
-        }
-        case 0xDB: {
-            alu_.set(d_e_.low(), 3);
-            break;
-        }
-        case 0xDC: {
-            alu_.set(h_l_.high(), 3);
-            break;
-        }
-        case 0xDD: {
-            alu_.set(h_l_.low(), 3);
-            break;
-        }
-        case 0xDE: {
-            const auto addr = make_address(h_l_);
-            auto data = read_data(addr);
-            alu::set(data, 3);
-            write_data(addr, data);
-            break;
-        }
-        case 0xDF: {
-            alu_.set(a_f_.high(), 3);
-            break;
-        }
+    return info.cycle_count;
+}
 
-        case 0xE0: {
-            alu_.set(b_c_.high(), 4);
-            break;
-        }
-        case 0xE1: {
-            alu_.set(b_c_.low(), 4);
-            break;
-        }
-        case 0xE2: {
-            alu_.set(d_e_.high(), 4);
-            break;
-        }
-        case 0xE3: {
-            alu_.set(d_e_.low(), 4);
-            break;
-        }
-        case 0xE4: {
-            alu_.set(h_l_.high(), 4);
-            break;
-        }
-        case 0xE5: {
-            alu_.set(h_l_.low(), 4);
-            break;
-        }
-        case 0xE6: {
-            const auto addr = make_address(h_l_);
-            auto data = read_data(addr);
-            alu::set(data, 4);
-            write_data(addr, data);
-            break;
-        }
-        case 0xE7: {
-            alu_.set(a_f_.high(), 4);
-            break;
-        }
+template<uint8_t Opcode>
+uint8_t cpu::execute_extended(uint16_t)
+{
+    return extended_instruction<Opcode>();
+}
 
-        case 0xE8: {
-            alu_.set(b_c_.high(), 5);
-            break;
-        }
-        case 0xE9: {
-            alu_.set(b_c_.low(), 5);
-            break;
-        }
-        case 0xEA: {
-            alu_.set(d_e_.high(), 5);
-            break;
-        }
-        case 0xEB: {
-            alu_.set(d_e_.low(), 5);
-            break;
-        }
-        case 0xEC: {
-            alu_.set(h_l_.high(), 5);
-            break;
-        }
-        case 0xED: {
-            alu_.set(h_l_.low(), 5);
-            break;
-        }
-        case 0xEE: {
-            const auto addr = make_address(h_l_);
-            auto data = read_data(addr);
-            alu::set(data, 5);
-            write_data(addr, data);
-            break;
-        }
-        case 0xEF: {
-            alu_.set(a_f_.high(), 5);
-            break;
-        }
+template<uint8_t Opcode>
+uint8_t cpu::executed([[maybe_unused]] const uint16_t data, const bool branch_taken)
+{
+#if WITH_DEBUGGER
+    if(on_instruction_executed_) {
+        on_instruction_executed_(make_address(prev_program_counter_), instruction::standard_instruction_set[Opcode], data);
+    }
+#endif //WITH_DEBUGGER
 
-        case 0xF0: {
-            alu_.set(b_c_.high(), 6);
-            break;
-        }
-        case 0xF1: {
-            alu_.set(b_c_.low(), 6);
-            break;
-        }
-        case 0xF2: {
-            alu_.set(d_e_.high(), 6);
-            break;
-        }
-        case 0xF3: {
-            alu_.set(d_e_.low(), 6);
-            break;
-        }
-        case 0xF4: {
-            alu_.set(h_l_.high(), 6);
-            break;
-        }
-        case 0xF5: {
-            alu_.set(h_l_.low(), 6);
-            break;
-        }
-        case 0xF6: {
-            const auto addr = make_address(h_l_);
-            auto data = read_data(addr);
-            alu::set(data, 6);
-            write_data(addr, data);
-            break;
-        }
-        case 0xF7: {
-            alu_.set(a_f_.high(), 6);
-            break;
-        }
+    return branch_taken
+        ? instruction::standard_instruction_set[Opcode].cycle_count
+        : instruction::get_false_branch_cycle_count(Opcode);
+}
 
-        case 0xF8: {
-            alu_.set(b_c_.high(), 7);
-            break;
-        }
-        case 0xF9: {
-            alu_.set(b_c_.low(), 7);
-            break;
-        }
-        case 0xFA: {
-            alu_.set(d_e_.high(), 7);
-            break;
-        }
-        case 0xFB: {
-            alu_.set(d_e_.low(), 7);
-            break;
-        }
-        case 0xFC: {
-            alu_.set(h_l_.high(), 7);
-            break;
-        }
-        case 0xFD: {
-            alu_.set(h_l_.low(), 7);
-            break;
-        }
-        case 0xFE: {
-            const auto addr = make_address(h_l_);
-            auto data = read_data(addr);
-            alu::set(data, 7);
-            write_data(addr, data);
-            break;
-        }
-        case 0xFF: {
-            alu_.set(a_f_.high(), 7);
-            break;
-        }
+template<uint8_t Operation, typename Operand>
+void cpu::arithmetic(const Operand& operand)
+{
+    if constexpr(Operation == 0u) {
+        alu_.add(operand);
+    } else if constexpr(Operation == 1u) {
+        alu_.add_c(operand);
+    } else if constexpr(Operation == 2u) {
+        alu_.subtract(operand);
+    } else if constexpr(Operation == 3u) {
+        alu_.subtract_c(operand);
+    } else if constexpr(Operation == 4u) {
+        alu_.logical_and(operand);
+    } else if constexpr(Operation == 5u) {
+        alu_.logical_xor(operand);
+    } else if constexpr(Operation == 6u) {
+        alu_.logical_or(operand);
+    } else {
+        alu_.logical_compare(operand);
+    }
+}
 
-        default: {
-            spdlog::critical("unknown instruction: {:#x}, address: {:#x}", inst, program_counter_.value() - 1);
-            std::terminate();
-        }
+template<uint8_t Condition>
+bool cpu::condition() noexcept
+{
+    if constexpr(Condition == 0u) {
+        return !test_flag(flag::zero);
+    } else if constexpr(Condition == 1u) {
+        return test_flag(flag::zero);
+    } else if constexpr(Condition == 2u) {
+        return !test_flag(flag::carry);
+    } else {
+        return test_flag(flag::carry);
     }
+}
 
-    const auto& info = instruction::extended_instruction_set[inst];
+template<uint8_t Index>
+register8& cpu::r8() noexcept
+{
+    static_assert(Index != hl_indirect, "(HL) is not a register");
+
+    if constexpr(Index == 0u) {
+        return b_c_.high();
+    } else if constexpr(Index == 1u) {
+        return b_c_.low();
+    } else if constexpr(Index == 2u) {
+        return d_e_.high();
+    } else if constexpr(Index == 3u) {
+        return d_e_.low();
+    } else if constexpr(Index == 4u) {
+        return h_l_.high();
+    } else if constexpr(Index == 5u) {
+        return h_l_.low();
+    } else {
+        return a_f_.high();
+    }
+}
 
-#if WITH_DEBUGGER
-    if(on_instruction_executed_) {
-        on_instruction_executed_(make_address(prev_program_counter_), info, 0u);
+template<uint8_t Index>
+register16& cpu::rp() noexcept
+{
+    if constexpr(Index == 0u) {
+        return b_c_;
+    } else if constexpr(Index == 1u) {
+        return d_e_;
+    } else if constexpr(Index == 2u) {
+        return h_l_;
+    } else {
+        return stack_pointer_;
     }
-#endif //WITH_DEBUGGER
+}
 
-    return info.cycle_count;
+template<uint8_t Index>
+register16& cpu::rp2() noexcept
+{
+    if constexpr(Index == 0u) {
+        return b_c_;
+    } else if constexpr(Index == 1u) {
+        return d_e_;
+    } else if constexpr(Index == 2u) {
+        return h_l_;
+    } else {
+        return a_f_;
+    }
+}
+
+template<size_t... Opcodes>
+constexpr std::array<cpu::instruction_handler, sizeof...(Opcodes)> cpu::make_handlers(
+    std::index_sequence<Opcodes...>, standard_instruction_set_t) noexcept
+{
+    return {&cpu::standard_instruction<static_cast<uint8_t>(Opcodes)>...};
+}
+
+template<size_t... Opcodes>
+constexpr std::array<cpu::instruction_handler, sizeof...(Opcodes)> cpu::make_handlers(
+    std::index_sequence<Opcodes...>, extended_instruction_set_t) noexcept
+{
+    return {&cpu::extended_instruction<static_cast<uint8_t>(Opcodes)>...};
+}
+
+template<size_t... Opcodes>
+constexpr std::array<cpu::decoded_instruction_handler, sizeof...(Opcodes)> cpu::make_decoded_handlers(
+    std::index_sequence<Opcodes...>, standard_instruction_set_t) noexcept
+{
+    return {&cpu::execute<static_cast<uint8_t>(Opcodes)>...};
+}
+
+template<size_t... Opcodes>
+constexpr std::array<cpu::decoded_instruction_handler, sizeof...(Opcodes)> cpu::make_decoded_handlers(
+    std::index_sequence<Opcodes...>, extended_instruction_set_t) noexcept
+{
+    return {&cpu::execute_extended<static_cast<uint8_t>(Opcodes)>...};
 }
 
+const std::array<cpu::instruction_handler, 256> cpu::standard_handlers_ =
+    make_handlers(std::make_index_sequence<256>{}, standard_instruction_set);
+const std::array<cpu::instruction_handler, 256> cpu::extended_handlers_ =
+    make_handlers(std::make_index_sequence<256>{}, extended_instruction_set);
+const std::array<cpu::decoded_instruction_handler, 256> cpu::decoded_standard_handlers_ =
+    make_decoded_handlers(std::make_index_sequence<256>{}, standard_instruction_set);
+const std::array<cpu::decoded_instruction_handler, 256> cpu::decoded_extended_handlers_ =
+    make_decoded_handlers(std::make_index_sequence<256>{}, extended_instruction_set);
+
 void cpu::write_data(const address16& address, const uint8_t data)
 {
     bus_->get_mmu()->write(address, data);
@@ -2540,8 +984,17 @@ void cpu::halt() noexcept
 void cpu::stop() noexcept
 {
     if(bit::test(key_1_, 0u)) {
+        // components clocked by the cpu catch up with the old speed first
+        auto link = bus_->get_link();
+        auto timer = bus_->get_timer();
+        link->sync();
+        timer->sync();
+
         key_1_ = bit::reset(key_1_, 0u);
         key_1_ = bit::flip(key_1_, 7u);
+
+        link->schedule_transfer_end();
+        timer->schedule_overflow();
         return;
     }
 
@@ -1,14 +1,57 @@
 #include "gameboy/gameboy.h"
 
+#include <algorithm>
+#include <array>
+
 #include <spdlog/spdlog.h>
 
 #include "gameboy/version.h"
 
 namespace gameboy {
 
+constexpr auto state_header_section = make_state_tag("GBST");
+/** bumped whenever a component changes what it saves */
+constexpr uint32_t state_version = 2u;
+
+constexpr std::array state_sections{
+    scheduler::state_section,
+    cartridge::state_section,
+    mmu::state_section,
+    cpu::state_section,
+    ppu::state_section,
+    apu::state_section,
+    timer::state_section,
+    link::state_section,
+    joypad::state_section
+};
+
+struct state_header {
+    uint32_t version;
+    uint32_t rom_size;
+    uint16_t global_checksum;
+    uint8_t header_checksum;
+    bool cgb_enabled;
+};
+
+state_header make_state_header(const cartridge& cartridge) noexcept
+{
+    constexpr auto header_checksum_addr = 0x014Du;
+    constexpr auto global_checksum_addr = 0x014Eu;
+
+    const auto rom = cartridge.rom();
+    state_header header{state_version, static_cast<uint32_t>(rom.size()), 0u, 0u, cartridge.cgb_enabled()};
+    if(rom.size() > global_checksum_addr + 1u) {
+        header.header_checksum = rom[header_checksum_addr];
+        header.global_checksum = static_cast<uint16_t>(rom[global_checksum_addr] << 8u | rom[global_checksum_addr + 1u]);
+    }
+
+    return header;
+}
+
 gameboy::gameboy()
     : cartridge_{},
       bus_{make_observer(this)},
+      scheduler_{},
       mmu_{make_observer(bus_)},
       cpu_{make_observer(bus_)},
       ppu_{make_observer(bus_)},
@@ -23,6 +66,7 @@ gameboy::gameboy()
 gameboy::gameboy(const filesystem::path& rom_path)
     : cartridge_{rom_path},
       bus_{make_observer(this)},
+      scheduler_{},
       mmu_{make_observer(bus_)},
       cpu_{make_observer(bus_)},
       ppu_{make_observer(bus_)},
@@ -34,20 +78,68 @@ gameboy::gameboy(const filesystem::path& rom_path)
     spdlog::info("gameboy v{}", version::version);
 }
 
+gameboy::gameboy(const cartridge& cart)
+    : cartridge_{cart},
+      bus_{make_observer(this)},
+      scheduler_{},
+      mmu_{make_observer(bus_)},
+      cpu_{make_observer(bus_)},
+      ppu_{make_observer(bus_)},
+      apu_{make_observer(bus_)},
+      link_{make_observer(bus_)},
+      joypad_{make_observer(bus_)},
+      timer_{make_observer(bus_)} {}
+
+std::unique_ptr<gameboy> gameboy::clone() const
+{
+    // the constructor binds the components of the copy to each other, the emulation itself comes from the state
+    std::unique_ptr<gameboy> copy{new gameboy{cartridge_}};
+#if WITH_DEBUGGER
+    copy->tick_enabled = tick_enabled;
+#endif //WITH_DEBUGGER
+    copy->cpu_.set_execution_mode(cpu_.get_execution_mode());
+    copy->ppu_.copy_settings(ppu_);
+    copy->apu_.copy_settings(apu_);
+
+    std::vector<uint8_t> state;
+    save_state(state);
+    if(!copy->load_state(state)) {
+        spdlog::error("gameboy: could not clone the emulation");
+        return nullptr;
+    }
+
+    return copy;
+}
+
 void gameboy::tick()
 {
+    if(cpu_.is_waiting_for_interrupt()) {
+        skip_halt();
+        return;
+    }
+
     const auto cycles = cpu_.tick();
 
     if(!cpu_.is_stopped()) {
-        timer_.tick(cpu_.is_in_double_speed() ? (cycles << 1u) : cycles);
-        apu_.tick(cycles);
-        ppu_.tick(cycles);
-        link_.tick(cycles);
+        scheduler_.advance(cycles);
     }
 
     cpu_.process_interrupts();
 }
 
+void gameboy::skip_halt()
+{
+    // a halted cpu idles 4 clocks per tick, no interrupt can be requested before the next deadline
+    const uint64_t cycles = cpu_.is_in_double_speed() ? 2u : 4u;
+    const auto cycles_until_deadline = scheduler_.next_deadline() - scheduler_.now();
+    const auto skipped_cycles = std::max<uint64_t>(
+        (cycles_until_deadline / cycles + (cycles_until_deadline % cycles != 0u ? 1u : 0u)) * cycles, cycles);
+
+    cpu_.skip_halted_cycles(skipped_cycles);
+    scheduler_.advance(skipped_cycles);
+    cpu_.process_interrupts();
+}
+
 void gameboy::tick_one_frame()
 {
     while(mmu_.read(ppu::ly_addr) != 0x00u) {
@@ -58,6 +150,11 @@ void gameboy::tick_one_frame()
 #endif //WITH_DEBUGGER
 
         tick();
+
+        // only joypad input, which arrives between frames, can wake up a stopped cpu
+        if(cpu_.is_stopped()) {
+            return;
+        }
     }
 
     while(mmu_.read(ppu::ly_addr) < 144) {
@@ -68,12 +165,97 @@ void gameboy::tick_one_frame()
 #endif //WITH_DEBUGGER
 
         tick();
+
+        // only joypad input, which arrives between frames, can wake up a stopped cpu
+        if(cpu_.is_stopped()) {
+            return;
+        }
     }
 }
 
 void gameboy::load_rom(const filesystem::path& rom_path)
 {
     cartridge_.load_rom(rom_path);
+    reset();
+}
+
+void gameboy::save_state(std::vector<uint8_t>& buffer) const
+{
+    state_writer writer{buffer};
+
+    writer.begin_section(state_header_section);
+    writer.write(make_state_header(cartridge_));
+    writer.end_section();
+
+    scheduler_.save_state(writer);
+    cartridge_.save_state(writer);
+    mmu_.save_state(writer);
+    cpu_.save_state(writer);
+    ppu_.save_state(writer);
+    apu_.save_state(writer);
+    timer_.save_state(writer);
+    link_.save_state(writer);
+    joypad_.save_state(writer);
+}
+
+bool gameboy::load_state(const std::vector<uint8_t>& buffer)
+{
+    state_reader reader{buffer};
+
+    state_header header{};
+    if(reader.begin_section(state_header_section)) {
+        reader.read(header);
+        reader.end_section();
+    }
+
+    if(!reader.ok() || header.version != state_version) {
+        spdlog::error("gameboy: unsupported save state");
+        return false;
+    }
+
+    if(const auto expected = make_state_header(cartridge_);
+       header.rom_size != expected.rom_size ||
+       header.global_checksum != expected.global_checksum ||
+       header.header_checksum != expected.header_checksum ||
+       header.cgb_enabled != expected.cgb_enabled) {
+        spdlog::error("gameboy: save state belongs to another rom");
+        return false;
+    }
+
+    // the layout is checked before anything gets overwritten
+    auto layout_reader = reader;
+    for(const auto section : state_sections) {
+        layout_reader.skip_section(section);
+    }
+
+    if(!layout_reader.ok() || !layout_reader.at_end()) {
+        spdlog::error("gameboy: save state is corrupted");
+        return false;
+    }
+
+    scheduler_.load_state(reader);
+    cartridge_.load_state(reader);
+    mmu_.load_state(reader);
+    cpu_.load_state(reader);
+    ppu_.load_state(reader);
+    apu_.load_state(reader);
+    timer_.load_state(reader);
+    link_.load_state(reader);
+    joypad_.load_state(reader);
+
+    if(!reader.ok()) {
+        // a section did not match this build, whatever was read so far cannot be trusted
+        spdlog::error("gameboy: save state is corrupted, resetting");
+        reset();
+        return false;
+    }
+
+    return true;
+}
+
+void gameboy::reset()
+{
+    scheduler_.reset();
     mmu_.reset();
     cpu_.reset();
     ppu_.reset();
@@ -30,6 +30,23 @@ void joypad::reset() noexcept
     });
 }
 
+void joypad::save_state(state_writer& writer) const
+{
+    writer.begin_section(state_section);
+    writer.write(joyp_);
+    writer.end_section();
+}
+
+void joypad::load_state(state_reader& reader) noexcept
+{
+    if(!reader.begin_section(state_section)) {
+        return;
+    }
+
+    reader.read(joyp_);
+    reader.end_section();
+}
+
 void joypad::press(const key key) noexcept
 {
     keys_ &= ~key;
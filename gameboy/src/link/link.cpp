@@ -6,6 +6,7 @@
 #include "gameboy/cartridge.h"
 #include "gameboy/cpu/cpu.h"
 #include "gameboy/memory/mmu.h"
+#include "gameboy/scheduler.h"
 #include "gameboy/util/mathutil.h"
 
 namespace gameboy {
@@ -22,9 +23,12 @@ link::link(const observer<bus> bus) noexcept
 void link::reset() noexcept
 {
     sc_ = bus_->get_cartridge()->cgb_enabled() ? 0x7Cu : 0x7Eu;
+    last_sync_cycle_ = 0u;
     shift_clock_ = 0u;
     shift_counter_ = 0u;
 
+    bus_->get_scheduler()->add_event_delegate(scheduler::event::link, {connect_arg<&link::on_transfer_end>, this});
+
     auto mmu = bus_->get_mmu();
     mmu->add_memory_delegate(sb_addr, {
       {connect_arg<&link::on_sb_read>, this},
@@ -36,31 +40,81 @@ void link::reset() noexcept
     });
 }
 
-void link::tick(const uint8_t cycles) noexcept
+void link::save_state(state_writer& writer) const
+{
+    writer.begin_section(state_section);
+    writer.write(sb_);
+    writer.write(sc_);
+    writer.write(last_sync_cycle_);
+    writer.write(shift_clock_);
+    writer.write(shift_counter_);
+    writer.end_section();
+}
+
+void link::load_state(state_reader& reader) noexcept
 {
-    if(!is_transferring()) {
+    if(!reader.begin_section(state_section)) {
+        return;
+    }
+
+    reader.read(sb_);
+    reader.read(sc_);
+    reader.read(last_sync_cycle_);
+    reader.read(shift_clock_);
+    reader.read(shift_counter_);
+    reader.end_section();
+}
+
+void link::sync() noexcept
+{
+    const auto now = bus_->get_scheduler()->now();
+    const auto cycles = now - last_sync_cycle_;
+    last_sync_cycle_ = now;
+
+    if(!is_transferring() || clock_mode() != mode::internal) {
         return;
     }
 
-    if(clock_mode() == mode::internal) {
-        shift_clock_ += cycles;
-        if(const auto rate = clock_rate(); shift_clock_ >= rate) {
-            shift_clock_ -= rate;
+    auto shift_clock = shift_clock_ + cycles;
+    for(const auto rate = clock_rate(); is_transferring() && shift_clock >= rate;) {
+        shift_clock -= rate;
 
-            shift_counter_++;
-            if(shift_counter_ == 8u) {
-                shift_counter_ = 0;
+        shift_counter_++;
+        if(shift_counter_ == 8u) {
+            shift_counter_ = 0;
 
-                sb_ = on_transfer_ ? on_transfer_(sb_.value()) : 0xFFu;
-                sc_ = bit::reset(sc_, 7u);
-                bus_->get_cpu()->request_interrupt(interrupt::serial);
-            }
+            sb_ = on_transfer_ ? on_transfer_(sb_.value()) : 0xFFu;
+            sc_ = bit::reset(sc_, 7u);
+            bus_->get_cpu()->request_interrupt(interrupt::serial);
         }
     }
+
+    shift_clock_ = static_cast<uint16_t>(shift_clock);
+    schedule_transfer_end();
+}
+
+void link::schedule_transfer_end() noexcept
+{
+    auto scheduler = bus_->get_scheduler();
+    if(!is_transferring() || clock_mode() != mode::internal) {
+        scheduler->cancel(scheduler::event::link);
+        return;
+    }
+
+    const auto rate = clock_rate();
+    const auto first_shift = shift_clock_ < rate ? rate - shift_clock_ : 0u;
+    scheduler->schedule(scheduler::event::link,
+        scheduler->now() + first_shift + (7u - shift_counter_) * rate);
+}
+
+void link::on_transfer_end() noexcept
+{
+    sync();
 }
 
 uint8_t link::on_transfer_slave(const uint8_t data) noexcept
 {
+    sync();
     const auto to_send = sb_.value();
     sb_ = data;
     return to_send;
@@ -68,21 +122,26 @@ uint8_t link::on_transfer_slave(const uint8_t data) noexcept
 
 void link::on_sb_write(const address16&, const uint8_t data) noexcept
 {
+    sync();
     sb_ = data;
 }
 
-uint8_t link::on_sb_read(const address16&) const noexcept
+uint8_t link::on_sb_read(const address16&) noexcept
 {
+    sync();
     return sb_.value();
 }
 
 void link::on_sc_write(const address16&, const uint8_t data) noexcept
 {
+    sync();
     sc_ = data | (bus_->get_cartridge()->cgb_enabled() ? 0x7Cu : 0x7Eu);
+    schedule_transfer_end();
 }
 
-uint8_t link::on_sc_read(const address16&) const noexcept
+uint8_t link::on_sc_read(const address16&) noexcept
 {
+    sync();
     return sc_.value();
 }
 
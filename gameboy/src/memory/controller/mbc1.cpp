@@ -29,6 +29,18 @@ void mbc1::control(const address16& address, const uint8_t data) noexcept
     }
 }
 
+void mbc1::save_state(state_writer& writer) const
+{
+    mbc::save_state(writer);
+    writer.write(rom_banking_active_);
+}
+
+void mbc1::load_state(state_reader& reader) noexcept
+{
+    mbc::load_state(reader);
+    reader.read(rom_banking_active_);
+}
+
 uint8_t mbc1::read_ram(const physical_address& address) const
 {
     return cartridge_->ram()[address.value()];
@@ -61,6 +61,28 @@ void mbc3::control(const address16& address, const uint8_t data) noexcept
     }
 }
 
+void mbc3::save_state(state_writer& writer) const
+{
+    mbc::save_state(writer);
+    writer.write(rtc_);
+    writer.write(rtc_latch_);
+    writer.write(rtc_last_time_);
+    writer.write(rtc_enabled_);
+    writer.write(rtc_latch_data_);
+    writer.write(rtc_selected_register_idx_);
+}
+
+void mbc3::load_state(state_reader& reader) noexcept
+{
+    mbc::load_state(reader);
+    reader.read(rtc_);
+    reader.read(rtc_latch_);
+    reader.read(rtc_last_time_);
+    reader.read(rtc_enabled_);
+    reader.read(rtc_latch_data_);
+    reader.read(rtc_selected_register_idx_);
+}
+
 uint8_t mbc3::read_ram(const physical_address& address) const
 {
     if(rtc_enabled_) {
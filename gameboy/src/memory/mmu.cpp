@@ -4,6 +4,7 @@
 
 #include "gameboy/bus.h"
 #include "gameboy/cartridge.h"
+#include "gameboy/cpu/cpu.h"
 #include "gameboy/memory/address_range.h"
 #include "gameboy/memory/memory_constants.h"
 #include "gameboy/ppu/ppu.h"
@@ -11,6 +12,8 @@
 namespace gameboy {
 
 constexpr address16 svbk_addr{0xFF70u};
+constexpr address16 ie_addr{0xFFFFu};
+constexpr uint16_t io_page_start = 0xFF00u;
 
 constexpr std::array<uint8_t, hram_range.size()> hram_gb{
     0x2B, 0x0B, 0x64, 0x2F, 0xAF, 0x15, 0x60, 0x6D, 0x61, 0x4E, 0xAC, 0x45, 0x0F, 0xDA, 0x92, 0xF3,
@@ -42,7 +45,8 @@ mmu::mmu(const observer<bus> bus)
 
 void mmu::reset() noexcept
 {
-    delegates_.clear();
+    std::fill(begin(io_delegates_), end(io_delegates_), memory_delegate{});
+    ie_delegate_ = memory_delegate{};
 
     wram_bank_ = 1u;
 
@@ -55,6 +59,48 @@ void mmu::reset() noexcept
     } else {
         std::copy(begin(hram_gb), end(hram_gb), std::back_inserter(high_ram_));
     }
+
+    if(bus_->get_cartridge()->cgb_enabled()) {
+        add_memory_delegate(svbk_addr, {
+            {connect_arg<&mmu::svbk_read>, this},
+            {connect_arg<&mmu::svbk_write>, this}
+        });
+    }
+
+    wram_code_pages_.assign(work_ram_.size() / page_size, false);
+    hram_has_code_ = false;
+
+    read_pages_.fill(nullptr);
+    write_pages_.fill(nullptr);
+    map_rom_pages();
+    map_wram_pages();
+}
+
+void mmu::save_state(state_writer& writer) const
+{
+    writer.begin_section(state_section);
+    writer.write(wram_bank_);
+    writer.write_bytes(work_ram_.data(), work_ram_.size());
+    writer.write_bytes(high_ram_.data(), high_ram_.size());
+    writer.end_section();
+}
+
+void mmu::load_state(state_reader& reader) noexcept
+{
+    if(!reader.begin_section(state_section)) {
+        return;
+    }
+
+    reader.read(wram_bank_);
+    reader.read_bytes(work_ram_.data(), work_ram_.size());
+    reader.read_bytes(high_ram_.data(), high_ram_.size());
+    reader.end_section();
+
+    std::fill(begin(wram_code_pages_), end(wram_code_pages_), false);
+    hram_has_code_ = false;
+
+    map_rom_pages();
+    map_wram_pages();
 }
 
 void mmu::write(const address16& address, const uint8_t data)
@@ -63,42 +109,149 @@ void mmu::write(const address16& address, const uint8_t data)
     if(on_write_access_) { on_write_access_(address, data); }
 #endif //WITH_DEBUGGER
 
+    if(auto* page = write_pages_[address.value() / page_size]; page != nullptr) {
+        page[address.value() % page_size] = data;
+        return;
+    }
+
+    write_slow(address, data);
+}
+
+uint8_t mmu::read(const address16& address) const
+{
+#if WITH_DEBUGGER
+    if(on_read_access_) { on_read_access_(address); }
+#endif //WITH_DEBUGGER
+
+    if(const auto* page = read_pages_[address.value() / page_size]; page != nullptr) {
+        return page[address.value() % page_size];
+    }
+
+    return read_slow(address);
+}
+
+void mmu::add_memory_delegate(const address16& address, const memory_delegate& callback) noexcept
+{
+    if(address == ie_addr) {
+        ie_delegate_ = callback;
+    } else {
+        io_delegates_[address.value() % io_register_count] = callback;
+    }
+}
+
+void mmu::map_rom_pages() noexcept
+{
+    constexpr address_range first_rom_bank_range{0x3FFFu};
+    constexpr address_range second_rom_bank_range{0x4000u, 0x7FFFu};
+
+    const auto cartridge = bus_->get_cartridge();
+    for(const auto& range : {first_rom_bank_range, second_rom_bank_range}) {
+        map_pages(range, cartridge->rom_bank_data(make_address(*begin(range))), nullptr);
+    }
+
+    ++mapping_generation_;
+}
+
+void mmu::map_vram_pages(const uint8_t* vram_bank) noexcept
+{
+    // writes are always delegated to the ppu
+    map_pages(vram_range, vram_bank, nullptr);
+}
+
+void mmu::map_wram_pages() noexcept
+{
+    constexpr address_range wram_first_bank_range{0xC000u, 0xCFFFu};
+    constexpr address_range wram_second_bank_range{0xD000u, 0xDFFFu};
+    constexpr address_range echo_first_bank_range{0xE000u, 0xEFFFu};
+    constexpr address_range echo_second_bank_range{0xF000u, 0xFDFFu};
+
+    auto* first_bank = work_ram_.data();
+    auto* second_bank = work_ram_.data() + physical_wram_addr(make_address(*begin(wram_second_bank_range))).value();
+    map_pages(wram_first_bank_range, first_bank, first_bank);
+    map_pages(wram_second_bank_range, second_bank, second_bank);
+    map_pages(echo_first_bank_range, first_bank, first_bank);
+    map_pages(echo_second_bank_range, second_bank, second_bank);
+
+    // pages holding cached code are written through write_wram
+    const auto last_page = (*begin(echo_range) + echo_range.size() - 1u) / page_size;
+    for(auto page = *begin(wram_range) / page_size; page <= last_page; ++page) {
+        if(write_pages_[page] == nullptr) {
+            continue;
+        }
+
+        const auto physical_page = static_cast<size_t>(write_pages_[page] - work_ram_.data()) / page_size;
+        if(wram_code_pages_[physical_page]) {
+            write_pages_[page] = nullptr;
+        }
+    }
+
+    ++mapping_generation_;
+}
+
+const uint8_t* mmu::code_pointer(const address16& address) const noexcept
+{
+    if(rom_range.has(address) || wram_range.has(address) || echo_range.has(address)) {
+        const auto* page = read_pages_[address.value() / page_size];
+        return page == nullptr ? nullptr : page + address.value() % page_size;
+    }
+
+    if(hram_range.has(address)) {
+        return high_ram_.data() + (address.value() - *begin(hram_range));
+    }
+
+    return nullptr;
+}
+
+void mmu::protect_code(const address16& address) noexcept
+{
+    if(hram_range.has(address)) {
+        hram_has_code_ = true;
+    } else if(wram_range.has(address) || echo_range.has(address)) {
+        const auto physical_page = static_cast<size_t>(read_pages_[address.value() / page_size] - work_ram_.data()) / page_size;
+        if(!wram_code_pages_[physical_page]) {
+            wram_code_pages_[physical_page] = true;
+            map_wram_pages();
+        }
+    }
+}
+
+void mmu::map_pages(const address_range& range, const uint8_t* read_data, uint8_t* write_data) noexcept
+{
+    const auto first_page = *begin(range) / page_size;
+    const auto last_page = (*begin(range) + range.size() - 1u) / page_size;
+    for(auto page = first_page; page <= last_page; ++page) {
+        const auto offset = (page - first_page) * page_size;
+        read_pages_[page] = read_data == nullptr ? nullptr : read_data + offset;
+        write_pages_[page] = write_data == nullptr ? nullptr : write_data + offset;
+    }
+}
+
+void mmu::write_slow(const address16& address, const uint8_t data)
+{
     if(rom_range.has(address)) {
         bus_->get_cartridge()->write_rom(address, data);
+        map_rom_pages();
     } else if(vram_range.has(address)) {
         bus_->get_ppu()->write_ram(address, data);
     } else if(oam_range.has(address)) {
         bus_->get_ppu()->write_oam(address, data);
     } else if(xram_range.has(address)) {
         bus_->get_cartridge()->write_ram(address, data);
-    } else if(wram_range.has(address)) {
+    } else if(wram_range.has(address) || echo_range.has(address)) {
         write_wram(address, data);
     } else if(hram_range.has(address)) {
         write_hram(address, data);
-    } else if(const auto it = delegates_.find(address); it != end(delegates_)) {
-        const auto& [delegated_addr, delegate] = *it;
-        delegate.on_write(delegated_addr, data);
-    } else if(echo_range.has(address)) {
-        constexpr auto echo_diff = *begin(echo_range) - *begin(wram_range);
-        write_wram(address - echo_diff, data);
-    } else if(address == svbk_addr) {
-        if(bus_->get_cartridge()->cgb_enabled()) {
-            wram_bank_ = data & 0x7u;
-            if(wram_bank_ == 0u) {
-                wram_bank_ = 1u;
-            }
-        }
+    } else if(address == ie_addr) {
+        ie_delegate_.on_write(address, data);
+    } else if(address.value() >= io_page_start) {
+        io_delegates_[address.value() % io_register_count].on_write(address, data);
     } else {
         spdlog::warn("out of bounds write: {:#x}", address.value());
     }
 }
 
-uint8_t mmu::read(const address16& address) const
+uint8_t mmu::read_slow(const address16& address) const
 {
-#if WITH_DEBUGGER
-    if(on_read_access_) { on_read_access_(address); }
-#endif //WITH_DEBUGGER
-
     if(rom_range.has(address)) {
         return bus_->get_cartridge()->read_rom(address);
     }
@@ -115,30 +268,16 @@ uint8_t mmu::read(const address16& address) const
         return bus_->get_cartridge()->read_ram(address);
     }
 
-    if(wram_range.has(address)) {
-        return read_wram(address);
-    }
-
     if(hram_range.has(address)) {
         return read_hram(address);
     }
 
-    if(const auto it = delegates_.find(address); it != end(delegates_)) {
-        const auto& [delegated_addr, delegate] = *it;
-        return delegate.on_read(delegated_addr);
+    if(address == ie_addr) {
+        return ie_delegate_.on_read(address);
     }
 
-    if(echo_range.has(address)) {
-        constexpr auto echo_diff = *begin(echo_range) - *begin(wram_range);
-        return read_wram(address - echo_diff);
-    }
-
-    if(address == svbk_addr) {
-        if(!bus_->get_cartridge()->cgb_enabled()) {
-            return 0xFFu;
-        }
-
-        return wram_bank_ | 0xF8u;
+    if(address.value() >= io_page_start) {
+        return io_delegates_[address.value() % io_register_count].on_read(address);
     }
 
     spdlog::warn("out of bounds read: {:#x}", address.value());
@@ -147,17 +286,27 @@ uint8_t mmu::read(const address16& address) const
 
 void mmu::write_wram(const address16& address, const uint8_t data)
 {
-    work_ram_[physical_wram_addr(address).value()] = data;
-}
-
-uint8_t mmu::read_wram(const address16& address) const
-{
-    return work_ram_[physical_wram_addr(address).value()];
+    const auto wram_address = echo_range.has(address)
+        ? address - static_cast<uint16_t>(*begin(echo_range) - *begin(wram_range))
+        : address;
+    const auto physical_addr = physical_wram_addr(wram_address).value();
+    work_ram_[physical_addr] = data;
+
+    if(const auto physical_page = physical_addr / page_size; wram_code_pages_[physical_page]) {
+        wram_code_pages_[physical_page] = false;
+        map_wram_pages();
+        bus_->get_cpu()->invalidate_code(work_ram_.data() + physical_page * page_size, page_size);
+    }
 }
 
 void mmu::write_hram(const address16& address, const uint8_t data)
 {
     high_ram_[address.value() - *begin(hram_range)] = data;
+
+    if(hram_has_code_) {
+        hram_has_code_ = false;
+        bus_->get_cpu()->invalidate_code(high_ram_.data(), high_ram_.size());
+    }
 }
 
 uint8_t mmu::read_hram(const address16& address) const
@@ -175,6 +324,21 @@ physical_address mmu::physical_wram_addr(const address16& address) const noexcep
     return physical_address{address.value() - *begin(wram_range) + 4_kb * (wram_bank_ - 1u)};
 }
 
+uint8_t mmu::svbk_read(const address16&) const noexcept
+{
+    return wram_bank_ | 0xF8u;
+}
+
+void mmu::svbk_write(const address16&, const uint8_t data) noexcept
+{
+    wram_bank_ = data & 0x7u;
+    if(wram_bank_ == 0u) {
+        wram_bank_ = 1u;
+    }
+
+    map_wram_pages();
+}
+
 void mmu::dma(const address16& source, const address16& destination, const uint16_t length)
 {
     for(uint16_t i = 0; i < length; ++i) {
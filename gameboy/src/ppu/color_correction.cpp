@@ -0,0 +1,45 @@
+#include "gameboy/ppu/color_correction.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace gameboy {
+
+namespace {
+
+/**
+ * covers every byte, palette memory resets to 0xFF which is out of the 5 bit range
+ * and converts with the same wrap around as any other value
+ */
+constexpr auto channel_lut_size = 256u;
+
+constexpr std::array<uint8_t, channel_lut_size> make_channel_lut() noexcept
+{
+    std::array<uint8_t, channel_lut_size> lut{};
+    for(auto i = 0u; i < lut.size(); ++i) {
+        lut[i] = static_cast<uint8_t>(i * 0xFFu / 0x1Fu);
+    }
+    return lut;
+}
+
+constexpr auto channel_lut = make_channel_lut();
+
+} // namespace
+
+color color_correction::apply(const color& cgb_color) const noexcept
+{
+    const std::array channels{
+        static_cast<float>(channel_lut[cgb_color.red]),
+        static_cast<float>(channel_lut[cgb_color.green]),
+        static_cast<float>(channel_lut[cgb_color.blue])
+    };
+
+    const auto mix = [&](const std::array<float, 3>& row) {
+        const auto value = row[0] * channels[0] + row[1] * channels[1] + row[2] * channels[2];
+        return static_cast<uint8_t>(std::clamp(std::lround(value), 0l, 255l));
+    };
+
+    return {mix(matrix[0]), mix(matrix[1]), mix(matrix[2])};
+}
+
+} // namespace gameboy
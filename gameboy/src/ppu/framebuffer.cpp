@@ -0,0 +1,63 @@
+#include "gameboy/ppu/framebuffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace gameboy {
+
+framebuffer::framebuffer(const pixel_format format)
+    : format_{format}
+{
+    for(auto i = 0u; i < indices_.size(); ++i) {
+        indices_[i] = static_cast<uint8_t>(i);
+    }
+
+    set_format(format);
+}
+
+void framebuffer::set_format(const pixel_format format)
+{
+    format_ = format;
+    back_frame_ = 0u;
+    frames_.resize(2 * frame_size());
+    std::fill(begin(frames_), end(frames_), 0u);
+}
+
+void framebuffer::set_color(const uint8_t color_table_index, const color& c) noexcept
+{
+    rgba8888_colors_[color_table_index] = {c.red, c.green, c.blue, 0xFFu};
+    rgb565_colors_[color_table_index] = static_cast<uint16_t>(
+        ((c.red >> 3u) << 11u) | ((c.green >> 2u) << 5u) | (c.blue >> 3u));
+}
+
+void framebuffer::write_line(const uint8_t line_number, const std::array<uint8_t, width>& color_table_indices,
+  const size_t first_x, const size_t last_x) noexcept
+{
+    const auto pitch = width * bytes_per_pixel(format_);
+    auto* line = frames_.data() + back_frame_ * frame_size() + line_number * pitch;
+
+    switch(format_) {
+        case pixel_format::rgba8888:
+            for(auto x = first_x; x < last_x; ++x) {
+                std::memcpy(line + x * 4u, rgba8888_colors_[color_table_indices[x]].data(), 4u);
+            }
+            break;
+        case pixel_format::rgb565:
+            for(auto x = first_x; x < last_x; ++x) {
+                std::memcpy(line + x * 2u, &rgb565_colors_[color_table_indices[x]], 2u);
+            }
+            break;
+        case pixel_format::index:
+            for(auto x = first_x; x < last_x; ++x) {
+                line[x] = indices_[color_table_indices[x]];
+            }
+            break;
+    }
+}
+
+frame_view framebuffer::front() const noexcept
+{
+    return frame_view{frames_.data() + (back_frame_ ^ 1u) * frame_size(), format_};
+}
+
+} // namespace gameboy
@@ -0,0 +1,260 @@
+#include "gameboy/ppu/line_compositor.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define GAMEBOY_X86 1
+    #include <immintrin.h>
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+        #define GAMEBOY_TARGET_AVX2
+    #else
+        #define GAMEBOY_TARGET_AVX2 __attribute__((target("avx2")))
+    #endif
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+    #define GAMEBOY_NEON 1
+    #include <arm_neon.h>
+#endif
+
+namespace gameboy {
+
+void line_buffer::clear() noexcept
+{
+    bg_color_indices.fill(0u);
+    bg_palettes.fill(0u);
+    bg_flags.fill(0u);
+    obj_color_indices.fill(0u);
+    obj_palettes.fill(0u);
+    obj_flags.fill(0u);
+}
+
+namespace line_compositor {
+
+namespace {
+
+// an opaque object pixel hides the background if any of the objects on it could be drawn on its own,
+// once an object is drawn the ones above it are drawn regardless of the background
+void composite_scalar(const line_buffer& buffer, const bool master_priority, uint8_t* color_table_indices) noexcept
+{
+    for(auto x = 0u; x < line_buffer::width; ++x) {
+        const auto bg_color = buffer.bg_color_indices[x];
+        const auto bg_flags = buffer.bg_flags[x];
+        const auto obj_color = buffer.obj_color_indices[x];
+        const auto bg_present = (bg_flags & line_buffer::bg_flag_present) != 0u;
+
+        const auto obj_visible = obj_color != 0u && (!bg_present || bg_color == 0u || master_priority ||
+            ((buffer.obj_flags[x] & line_buffer::obj_flag_prioritized) != 0u &&
+              (bg_flags & line_buffer::bg_flag_prioritized) == 0u));
+
+        if(obj_visible) {
+            color_table_indices[x] = static_cast<uint8_t>(obj_color_offset + buffer.obj_palettes[x] * 4u + obj_color);
+        } else if(bg_present) {
+            color_table_indices[x] = static_cast<uint8_t>(buffer.bg_palettes[x] * 4u + bg_color);
+        } else {
+            color_table_indices[x] = blank_color_index;
+        }
+    }
+}
+
+#if GAMEBOY_X86
+template<typename T>
+const __m128i* as_m128i(const T& data) noexcept { return reinterpret_cast<const __m128i*>(data.data()); }
+
+void composite_sse2(const line_buffer& buffer, const bool master_priority, uint8_t* color_table_indices) noexcept
+{
+    const auto zero = _mm_setzero_si128();
+    const auto ones = _mm_cmpeq_epi8(zero, zero);
+    const auto master = master_priority ? ones : zero;
+    const auto present_bit = _mm_set1_epi8(line_buffer::bg_flag_present);
+    const auto bg_priority_bit = _mm_set1_epi8(line_buffer::bg_flag_prioritized);
+    const auto obj_priority_bit = _mm_set1_epi8(line_buffer::obj_flag_prioritized);
+    const auto obj_offset = _mm_set1_epi8(obj_color_offset);
+    const auto blank = _mm_set1_epi8(blank_color_index);
+
+    for(auto i = 0u; i < line_buffer::width / 16u; ++i) {
+        const auto bg_color = _mm_load_si128(as_m128i(buffer.bg_color_indices) + i);
+        const auto bg_palette = _mm_load_si128(as_m128i(buffer.bg_palettes) + i);
+        const auto bg_flags = _mm_load_si128(as_m128i(buffer.bg_flags) + i);
+        const auto obj_color = _mm_load_si128(as_m128i(buffer.obj_color_indices) + i);
+        const auto obj_palette = _mm_load_si128(as_m128i(buffer.obj_palettes) + i);
+        const auto obj_flags = _mm_load_si128(as_m128i(buffer.obj_flags) + i);
+
+        const auto bg_present = _mm_cmpeq_epi8(_mm_and_si128(bg_flags, present_bit), present_bit);
+        const auto bg_prioritized = _mm_cmpeq_epi8(_mm_and_si128(bg_flags, bg_priority_bit), bg_priority_bit);
+        const auto obj_prioritized = _mm_cmpeq_epi8(_mm_and_si128(obj_flags, obj_priority_bit), obj_priority_bit);
+
+        const auto obj_passes = _mm_or_si128(
+            _mm_or_si128(_mm_andnot_si128(bg_present, ones), _mm_cmpeq_epi8(bg_color, zero)),
+            _mm_or_si128(master, _mm_andnot_si128(bg_prioritized, obj_prioritized)));
+        const auto obj_visible = _mm_andnot_si128(_mm_cmpeq_epi8(obj_color, zero), obj_passes);
+
+        const auto bg_palette_2x = _mm_add_epi8(bg_palette, bg_palette);
+        const auto bg_index = _mm_add_epi8(_mm_add_epi8(bg_palette_2x, bg_palette_2x), bg_color);
+        const auto obj_palette_2x = _mm_add_epi8(obj_palette, obj_palette);
+        const auto obj_index = _mm_add_epi8(_mm_add_epi8(obj_palette_2x, obj_palette_2x), _mm_add_epi8(obj_color, obj_offset));
+
+        const auto bg_or_blank = _mm_or_si128(_mm_and_si128(bg_present, bg_index), _mm_andnot_si128(bg_present, blank));
+        const auto result = _mm_or_si128(_mm_and_si128(obj_visible, obj_index), _mm_andnot_si128(obj_visible, bg_or_blank));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(color_table_indices) + i, result);
+    }
+}
+
+template<typename T>
+const __m256i* as_m256i(const T& data) noexcept { return reinterpret_cast<const __m256i*>(data.data()); }
+
+GAMEBOY_TARGET_AVX2
+void composite_avx2(const line_buffer& buffer, const bool master_priority, uint8_t* color_table_indices) noexcept
+{
+    const auto zero = _mm256_setzero_si256();
+    const auto ones = _mm256_cmpeq_epi8(zero, zero);
+    const auto master = master_priority ? ones : zero;
+    const auto present_bit = _mm256_set1_epi8(line_buffer::bg_flag_present);
+    const auto bg_priority_bit = _mm256_set1_epi8(line_buffer::bg_flag_prioritized);
+    const auto obj_priority_bit = _mm256_set1_epi8(line_buffer::obj_flag_prioritized);
+    const auto obj_offset = _mm256_set1_epi8(obj_color_offset);
+    const auto blank = _mm256_set1_epi8(blank_color_index);
+
+    for(auto i = 0u; i < line_buffer::width / 32u; ++i) {
+        const auto bg_color = _mm256_load_si256(as_m256i(buffer.bg_color_indices) + i);
+        const auto bg_palette = _mm256_load_si256(as_m256i(buffer.bg_palettes) + i);
+        const auto bg_flags = _mm256_load_si256(as_m256i(buffer.bg_flags) + i);
+        const auto obj_color = _mm256_load_si256(as_m256i(buffer.obj_color_indices) + i);
+        const auto obj_palette = _mm256_load_si256(as_m256i(buffer.obj_palettes) + i);
+        const auto obj_flags = _mm256_load_si256(as_m256i(buffer.obj_flags) + i);
+
+        const auto bg_present = _mm256_cmpeq_epi8(_mm256_and_si256(bg_flags, present_bit), present_bit);
+        const auto bg_prioritized = _mm256_cmpeq_epi8(_mm256_and_si256(bg_flags, bg_priority_bit), bg_priority_bit);
+        const auto obj_prioritized = _mm256_cmpeq_epi8(_mm256_and_si256(obj_flags, obj_priority_bit), obj_priority_bit);
+
+        const auto obj_passes = _mm256_or_si256(
+            _mm256_or_si256(_mm256_andnot_si256(bg_present, ones), _mm256_cmpeq_epi8(bg_color, zero)),
+            _mm256_or_si256(master, _mm256_andnot_si256(bg_prioritized, obj_prioritized)));
+        const auto obj_visible = _mm256_andnot_si256(_mm256_cmpeq_epi8(obj_color, zero), obj_passes);
+
+        const auto bg_palette_2x = _mm256_add_epi8(bg_palette, bg_palette);
+        const auto bg_index = _mm256_add_epi8(_mm256_add_epi8(bg_palette_2x, bg_palette_2x), bg_color);
+        const auto obj_palette_2x = _mm256_add_epi8(obj_palette, obj_palette);
+        const auto obj_index = _mm256_add_epi8(_mm256_add_epi8(obj_palette_2x, obj_palette_2x), _mm256_add_epi8(obj_color, obj_offset));
+
+        const auto bg_or_blank = _mm256_blendv_epi8(blank, bg_index, bg_present);
+        const auto result = _mm256_blendv_epi8(bg_or_blank, obj_index, obj_visible);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(color_table_indices) + i, result);
+    }
+}
+
+bool cpu_supports_sse2() noexcept
+{
+#if defined(__x86_64__) || defined(_M_X64)
+    return true; // part of the x86-64 baseline
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+#else
+    return __builtin_cpu_supports("sse2");
+#endif
+}
+
+bool cpu_supports_avx2() noexcept
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    const auto os_saves_ymm = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 0x6u) == 0x6u;
+    if(!os_saves_ymm) {
+        return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif //GAMEBOY_X86
+
+#if GAMEBOY_NEON
+void composite_neon(const line_buffer& buffer, const bool master_priority, uint8_t* color_table_indices) noexcept
+{
+    const auto zero = vdupq_n_u8(0u);
+    const auto master = vdupq_n_u8(master_priority ? uint8_t{0xFFu} : uint8_t{0x00u});
+    const auto present_bit = vdupq_n_u8(line_buffer::bg_flag_present);
+    const auto bg_priority_bit = vdupq_n_u8(line_buffer::bg_flag_prioritized);
+    const auto obj_priority_bit = vdupq_n_u8(line_buffer::obj_flag_prioritized);
+    const auto obj_offset = vdupq_n_u8(obj_color_offset);
+    const auto blank = vdupq_n_u8(blank_color_index);
+
+    for(auto x = 0u; x < line_buffer::width; x += 16u) {
+        const auto bg_color = vld1q_u8(buffer.bg_color_indices.data() + x);
+        const auto bg_palette = vld1q_u8(buffer.bg_palettes.data() + x);
+        const auto bg_flags = vld1q_u8(buffer.bg_flags.data() + x);
+        const auto obj_color = vld1q_u8(buffer.obj_color_indices.data() + x);
+        const auto obj_palette = vld1q_u8(buffer.obj_palettes.data() + x);
+        const auto obj_flags = vld1q_u8(buffer.obj_flags.data() + x);
+
+        const auto bg_present = vtstq_u8(bg_flags, present_bit);
+        const auto bg_prioritized = vtstq_u8(bg_flags, bg_priority_bit);
+        const auto obj_prioritized = vtstq_u8(obj_flags, obj_priority_bit);
+
+        const auto obj_passes = vorrq_u8(
+            vorrq_u8(vmvnq_u8(bg_present), vceqq_u8(bg_color, zero)),
+            vorrq_u8(master, vbicq_u8(obj_prioritized, bg_prioritized)));
+        const auto obj_visible = vbicq_u8(obj_passes, vceqq_u8(obj_color, zero));
+
+        const auto bg_index = vaddq_u8(vshlq_n_u8(bg_palette, 2), bg_color);
+        const auto obj_index = vaddq_u8(vshlq_n_u8(obj_palette, 2), vaddq_u8(obj_color, obj_offset));
+
+        const auto bg_or_blank = vbslq_u8(bg_present, bg_index, blank);
+        vst1q_u8(color_table_indices + x, vbslq_u8(obj_visible, obj_index, bg_or_blank));
+    }
+}
+#endif //GAMEBOY_NEON
+
+instruction_set detect_instruction_set() noexcept
+{
+#if GAMEBOY_X86
+    if(cpu_supports_avx2()) {
+        return instruction_set::avx2;
+    }
+
+    if(cpu_supports_sse2()) {
+        return instruction_set::sse2;
+    }
+#elif GAMEBOY_NEON
+    return instruction_set::neon;
+#endif
+
+    return instruction_set::scalar;
+}
+
+} // namespace
+
+static_assert(line_buffer::width % 32u == 0u, "kernels process the line in whole vectors");
+
+kernel get_kernel(const instruction_set set) noexcept
+{
+    switch(set) {
+        case instruction_set::scalar:
+            return composite_scalar;
+#if GAMEBOY_X86
+        case instruction_set::sse2:
+            return cpu_supports_sse2() ? composite_sse2 : nullptr;
+        case instruction_set::avx2:
+            return cpu_supports_avx2() ? composite_avx2 : nullptr;
+#endif //GAMEBOY_X86
+#if GAMEBOY_NEON
+        case instruction_set::neon:
+            return composite_neon;
+#endif //GAMEBOY_NEON
+        default:
+            return nullptr;
+    }
+}
+
+instruction_set best_instruction_set() noexcept
+{
+    static const auto set = detect_instruction_set();
+    return set;
+}
+
+} // namespace line_compositor
+
+} // namespace gameboy
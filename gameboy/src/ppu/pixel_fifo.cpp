@@ -0,0 +1,351 @@
+#include "gameboy/ppu/pixel_fifo.h"
+
+#include <cstring>
+
+#include "gameboy/ppu/ppu.h"
+
+namespace gameboy {
+
+/** the discarded first fetch of a line, tuned so that a plain line takes 172 dots */
+constexpr uint8_t line_start_dots = 7u;
+/** reading the tile number, the low and the high byte of the row take 2 dots each */
+constexpr uint8_t fetch_steps = 6u;
+constexpr uint8_t obj_fetch_dots = 6u;
+
+pixel_fifo::pixel_fifo(const observer<ppu> ppu) noexcept
+    : ppu_{ppu} {}
+
+void pixel_fifo::start_line() noexcept
+{
+    dot_ = 0u;
+    start_delay_ = line_start_dots;
+    discard_count_ = ppu_->registers_.scx.value() % ppu::tile_pixel_count;
+    x_ = 0u;
+    flushed_x_ = 0u;
+    render_ = ppu_->render_frame_;
+
+    fetcher_step_ = 0u;
+    fetcher_x_ = 0u;
+    fetching_window_ = false;
+    window_drawn_ = false;
+
+    bg_fifo_head_ = fifo_size;
+    obj_fifo_.fill(obj_pixel{});
+    obj_fifo_head_ = 0u;
+
+    // oam is locked during mode 3, so the objects of the line are read once
+    if(ppu_->obj_lines_dirty_) {
+        ppu_->update_obj_lines();
+    }
+
+    const auto& line = ppu_->obj_lines_[ppu_->registers_.ly.value()];
+    obj_count_ = line.count;
+    for(auto i = 0u; i < obj_count_; ++i) {
+        obj_indices_[i] = line.indices[i];
+        std::memcpy(&objs_[i], ppu_->oam_.data() + line.indices[i] * sizeof(attributes::obj), sizeof(attributes::obj));
+    }
+    fetched_objs_.reset();
+    obj_fetch_dots_ = 0u;
+
+    if(render_) {
+        buffer_.clear();
+    }
+}
+
+bool pixel_fifo::advance_to(const uint32_t dot) noexcept
+{
+    while(dot_ < dot) {
+        tick();
+
+        if(x_ == width) {
+            finish_line();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+uint32_t pixel_fifo::dots_until_finished() const noexcept
+{
+    return start_delay_ + static_cast<uint32_t>(width - x_);
+}
+
+void pixel_fifo::flush() noexcept
+{
+    if(!render_ || flushed_x_ == x_) {
+        return;
+    }
+
+    std::array<uint8_t, width> color_indices;
+    ppu_->compositor_(buffer_, ppu_->cgb_enabled_ && !ppu_->registers_.lcdc.bg_enabled(), color_indices.data());
+    ppu_->framebuffer_.write_line(ppu_->registers_.ly.value(), color_indices, flushed_x_, x_);
+
+    if(ppu_->on_render_line_) {
+        for(auto x = flushed_x_; x < x_; ++x) {
+            line_colors_[x] = ppu_->color_table_[color_indices[x]];
+        }
+    }
+
+    flushed_x_ = x_;
+}
+
+void pixel_fifo::save_state(state_writer& writer) const
+{
+    writer.write(dot_);
+    writer.write(start_delay_);
+    writer.write(discard_count_);
+    writer.write(x_);
+    writer.write(flushed_x_);
+    writer.write(render_);
+    writer.write(fetcher_step_);
+    writer.write(fetcher_x_);
+    writer.write(fetching_window_);
+    writer.write(window_drawn_);
+    writer.write(fetched_pixels_);
+    writer.write(bg_fifo_);
+    writer.write(bg_fifo_head_);
+    writer.write(obj_fifo_);
+    writer.write(obj_fifo_head_);
+    writer.write(objs_);
+    writer.write(obj_indices_);
+    writer.write(obj_count_);
+    writer.write(fetched_objs_);
+    writer.write(obj_fetch_dots_);
+    writer.write(obj_fetch_idx_);
+    writer.write(buffer_);
+    writer.write(line_colors_);
+}
+
+void pixel_fifo::load_state(state_reader& reader) noexcept
+{
+    reader.read(dot_);
+    reader.read(start_delay_);
+    reader.read(discard_count_);
+    reader.read(x_);
+    reader.read(flushed_x_);
+    reader.read(render_);
+    reader.read(fetcher_step_);
+    reader.read(fetcher_x_);
+    reader.read(fetching_window_);
+    reader.read(window_drawn_);
+    reader.read(fetched_pixels_);
+    reader.read(bg_fifo_);
+    reader.read(bg_fifo_head_);
+    reader.read(obj_fifo_);
+    reader.read(obj_fifo_head_);
+    reader.read(objs_);
+    reader.read(obj_indices_);
+    reader.read(obj_count_);
+    reader.read(fetched_objs_);
+    reader.read(obj_fetch_dots_);
+    reader.read(obj_fetch_idx_);
+    reader.read(buffer_);
+    reader.read(line_colors_);
+}
+
+void pixel_fifo::tick() noexcept
+{
+    ++dot_;
+
+    if(start_delay_ != 0u) {
+        --start_delay_;
+        return;
+    }
+
+    if(obj_fetch_dots_ != 0u) {
+        if(--obj_fetch_dots_ == 0u) {
+            fetch_obj(obj_fetch_idx_);
+        }
+        return;
+    }
+
+    if(uint8_t obj_idx; find_obj(obj_idx)) {
+        // the background fetcher finishes the tile it is working on before the object is fetched
+        if(bg_fifo_head_ == fifo_size || (fetcher_step_ != 0u && fetcher_step_ != fetch_steps)) {
+            step_fetcher();
+        } else {
+            obj_fetch_idx_ = obj_idx;
+            obj_fetch_dots_ = obj_fetch_dots - 1u;
+        }
+        return;
+    }
+
+    step_fetcher();
+    output_pixel();
+}
+
+void pixel_fifo::step_fetcher() noexcept
+{
+    if(fetcher_step_ != fetch_steps) {
+        if(fetcher_step_ == 0u) {
+            fetch_tile();
+        }
+        ++fetcher_step_;
+    }
+
+    if(fetcher_step_ == fetch_steps && bg_fifo_head_ == fifo_size) {
+        bg_fifo_ = fetched_pixels_;
+        bg_fifo_head_ = 0u;
+        fetcher_step_ = 0u;
+        ++fetcher_x_;
+    }
+}
+
+void pixel_fifo::fetch_tile() noexcept
+{
+    const auto& lcdc = ppu_->registers_.lcdc;
+    const auto map_idx = (fetching_window_ ? lcdc.window_map_secondary() : lcdc.bg_map_secondary()) ? 1u : 0u;
+    const auto map_y = fetching_window_
+        ? ppu_->window_line_
+        : (ppu_->registers_.scy.value() + ppu_->registers_.ly.value()) % ppu::map_pixel_count;
+    const auto map_x = fetching_window_
+        ? fetcher_x_ % ppu::map_tile_count
+        : (ppu_->registers_.scx.value() / ppu::tile_pixel_count + fetcher_x_) % ppu::map_tile_count;
+
+    const auto map_offset = ppu::map_tiles_offset + map_idx * ppu::map_tiles_size
+        + map_y / ppu::tile_pixel_count * ppu::map_tile_count + map_x;
+    const auto tile_no = ppu_->ram_[map_offset];
+    const attributes::bg tile_attr{ppu_->cgb_enabled_ ? ppu_->ram_[8_kb + map_offset] : uint8_t{0u}};
+
+    const auto tile_y = map_y % ppu::tile_pixel_count;
+    const auto& tile_row = ppu_->get_tile_row(
+        static_cast<uint8_t>(tile_attr.v_flipped() ? ppu::tile_pixel_count - tile_y - 1u : tile_y),
+        tile_no, tile_attr.vram_bank(), tile_attr.h_flipped());
+
+    // lcdc bit 0 blanks the background and the window on dmg
+    const auto present = ppu_->cgb_enabled_ || lcdc.bg_enabled();
+    const auto flags = static_cast<uint8_t>(present
+        ? line_buffer::bg_flag_present | (tile_attr.prioritized() ? line_buffer::bg_flag_prioritized : 0u)
+        : 0u);
+
+    for(auto i = 0u; i < fifo_size; ++i) {
+        fetched_pixels_[i] = bg_pixel{present ? tile_row[i] : uint8_t{0u}, tile_attr.palette_index(), flags};
+    }
+}
+
+void pixel_fifo::output_pixel() noexcept
+{
+    if(window_triggered()) {
+        // the window restarts the fetcher from its first tile with an empty fifo
+        fetching_window_ = true;
+        window_drawn_ = true;
+        bg_fifo_head_ = fifo_size;
+        fetcher_step_ = 0u;
+        fetcher_x_ = 0u;
+
+        const auto wx = ppu_->registers_.wx.value();
+        if(wx < 7u) {
+            discard_count_ = static_cast<uint8_t>(7u - wx);
+        }
+        return;
+    }
+
+    if(bg_fifo_head_ == fifo_size) {
+        return;
+    }
+
+    const auto bg = bg_fifo_[bg_fifo_head_++];
+    if(discard_count_ != 0u) {
+        --discard_count_;
+        return;
+    }
+
+    const auto obj = obj_fifo_[obj_fifo_head_];
+    obj_fifo_[obj_fifo_head_] = obj_pixel{};
+    obj_fifo_head_ = (obj_fifo_head_ + 1u) % fifo_size;
+
+    if(render_) {
+        buffer_.bg_color_indices[x_] = bg.color_index;
+        buffer_.bg_palettes[x_] = bg.palette;
+        buffer_.bg_flags[x_] = bg.flags;
+
+        if(ppu_->registers_.lcdc.obj_enabled()) {
+            buffer_.obj_color_indices[x_] = obj.color_index;
+            buffer_.obj_palettes[x_] = obj.palette;
+            buffer_.obj_flags[x_] = obj.flags;
+        }
+    }
+
+    ++x_;
+}
+
+void pixel_fifo::finish_line() noexcept
+{
+    flush();
+
+    if(render_ && ppu_->on_render_line_) {
+        ppu_->on_render_line_(ppu_->registers_.ly.value(), line_colors_);
+    }
+
+    if(window_drawn_) {
+        ++ppu_->window_line_;
+    }
+}
+
+bool pixel_fifo::find_obj(uint8_t& obj_idx) const noexcept
+{
+    if(!ppu_->registers_.lcdc.obj_enabled()) {
+        return false;
+    }
+
+    for(auto i = 0u; i < obj_count_; ++i) {
+        // objects hanging over the left edge are fetched on the first pixel
+        const auto fetch_x = objs_[i].x < ppu::tile_pixel_count ? 0u : objs_[i].x - ppu::tile_pixel_count;
+        if(!fetched_objs_.test(i) && fetch_x == x_) {
+            obj_idx = static_cast<uint8_t>(i);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void pixel_fifo::fetch_obj(const uint8_t obj_idx) noexcept
+{
+    fetched_objs_.set(obj_idx);
+
+    const auto& obj = objs_[obj_idx];
+    const auto obj_size = ppu_->registers_.lcdc.large_obj() ? 16 : 8;
+    const auto row = ppu_->registers_.ly.value() - (obj.y - 16);
+    if(row < 0 || row >= obj_size) {
+        return;
+    }
+
+    const auto& tile_row = ppu_->get_tile_row(
+        static_cast<uint8_t>(obj.v_flipped() ? obj_size - row - 1 : row),
+        ppu::tile_address<uint8_t>(0x8000u, ppu_->registers_.lcdc.large_obj()
+            ? obj.tile_number & 0xFEu
+            : obj.tile_number),
+        obj.vram_bank(),
+        obj.h_flipped());
+
+    const auto first_pixel = obj.x < ppu::tile_pixel_count ? ppu::tile_pixel_count - obj.x : 0u;
+    const auto oam_index = obj_indices_[obj_idx];
+    for(auto tile_x = first_pixel; tile_x < ppu::tile_pixel_count; ++tile_x) {
+        const auto dot_color = tile_row[tile_x];
+        if(dot_color == 0u) { // obj color0 is transparent
+            continue;
+        }
+
+        // dmg keeps the pixel of the object fetched first, which has the smaller x, cgb the one earlier in oam
+        auto& pixel = obj_fifo_[(obj_fifo_head_ + tile_x - first_pixel) % fifo_size];
+        if(pixel.color_index == 0u || (ppu_->cgb_enabled_ && oam_index < pixel.oam_index)) {
+            pixel = obj_pixel{
+                dot_color,
+                ppu_->cgb_enabled_ ? obj.cgb_palette_index() : obj.gb_palette_index(),
+                obj.prioritized() ? line_buffer::obj_flag_prioritized : uint8_t{0u},
+                oam_index
+            };
+        }
+    }
+}
+
+bool pixel_fifo::window_triggered() const noexcept
+{
+    return !fetching_window_
+        && ppu_->window_visible()
+        && x_ + 7u >= ppu_->registers_.wx.value();
+}
+
+} // namespace gameboy
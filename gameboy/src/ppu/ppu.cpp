@@ -1,5 +1,6 @@
 #include "gameboy/ppu/ppu.h"
 
+#include <algorithm>
 #include <cstring>
 
 #include "gameboy/bus.h"
@@ -7,7 +8,7 @@
 #include "gameboy/cpu/cpu.h"
 #include "gameboy/memory/memory_constants.h"
 #include "gameboy/memory/mmu.h"
-#include "gameboy/util/variantutil.h"
+#include "gameboy/scheduler.h"
 
 namespace gameboy {
 
@@ -15,13 +16,16 @@ constexpr auto ly_max = 153u;
 
 constexpr auto lcd_enable_delay_frames = 3;
 constexpr auto lcd_enable_delay_cycles = 244;
-constexpr auto hblank_cycles = 204u;
 constexpr auto reading_oam_cycles = 80u;
 constexpr auto reading_oam_vram_render_cycles = 160u;
 constexpr auto reading_oam_vram_cycles = 172u;
 constexpr auto total_line_cycles = 456u;
 constexpr auto total_vblank_cycles = total_line_cycles * 10u;
 constexpr auto total_frame_cycles = total_line_cycles * (ly_max + 1);
+constexpr auto last_line_ly_reset_cycles = total_line_cycles * (ly_max - screen_height);
+constexpr auto last_line_ly_reset_delay = 4u;
+
+static_assert(sizeof(attributes::obj) * 40u == oam_range.size());
 
 constexpr address16 lcdc_addr{0xFF40u};
 constexpr address16 stat_addr{0xFF41u};
@@ -65,7 +69,12 @@ void add_delegate(observer<bus> bus, ppu* p, Registers... registers)
 
 ppu::ppu(const observer<bus> bus)
     : bus_{bus},
-      oam_(oam_range.size(), 0u)
+      compositor_{line_compositor::get_kernel(line_compositor::best_instruction_set())},
+      render_mode_{render_mode::full},
+      render_frame_interval_{1u},
+      renderer_{renderer::scanline},
+      pixel_fifo_{make_observer(this)},
+      color_correction_{color_correction_none}
 {
     reset();
 }
@@ -75,21 +84,26 @@ void ppu::reset() noexcept
     cgb_enabled_ = bus_->get_cartridge()->cgb_enabled();
     lcd_enabled_ = true;
     line_rendered_ = false;
+    fifo_line_ = false;
+    mode3_cycles_ = reading_oam_vram_cycles;
     vblank_line_ = 0;
     window_line_ = 0u;
+    frame_count_ = 0u;
+    render_frame_ = render_mode_ != render_mode::timing_only;
     lcd_enable_delay_frame_count_ = 0;
     lcd_enable_delay_cycle_count_ = 0;
+    last_sync_cycle_ = 0u;
     cycle_count_ = 0u;
     secondary_cycle_count_ = 0u;
     vram_bank_ = 0u;
-    lcdc_.reg = 0x91u;
-    stat_.reg = cgb_enabled_ ? 0x01u : 0x06u;
-    ly_ = cgb_enabled_ ? 0x90u : 0x00u;
-    lyc_ = 0x00u;
-    scx_ = 0x00u;
-    scy_ = 0x00u;
-    wx_ = 0x00u;
-    wy_ = 0x00u;
+    registers_.lcdc.reg = 0x91u;
+    registers_.stat.reg = cgb_enabled_ ? 0x01u : 0x06u;
+    registers_.ly = cgb_enabled_ ? 0x90u : 0x00u;
+    registers_.lyc = 0x00u;
+    registers_.scx = 0x00u;
+    registers_.scy = 0x00u;
+    registers_.wx = 0x00u;
+    registers_.wy = 0x00u;
     gb_palette_ = palette_zelda;
     bgp_ = 0xFCu;
     bgpi_ = 0x00u;
@@ -99,15 +113,30 @@ void ppu::reset() noexcept
 
     interrupt_request_.reset_all();
 
-    ram_.resize((cgb_enabled_ ? 2 : 1) * 8_kb);
-    std::fill(begin(ram_), end(ram_), 0u);
-    std::fill(begin(oam_), end(oam_), 0u);
+    ram_.fill(0u);
+    oam_.fill(0u);
+    obj_lines_dirty_ = true;
+
+    // both banks are kept so that dmg objects pointing to bank 1 read transparent rows
+    tile_cache_.resize(2 * tile_count * tile_pixel_count);
+    std::fill(begin(tile_cache_), end(tile_cache_), decoded_tile_row{});
+
+    for(auto& layer : map_layers_) {
+        layer.color_indices.resize(map_pixel_count * map_pixel_count);
+        layer.palettes.resize(map_pixel_count * map_pixel_count);
+        layer.flags.resize(map_pixel_count * map_pixel_count);
+    }
+    invalidate_map_layers();
 
     const auto fill_palettes = [](auto& p, const auto& palette) { std::fill(begin(p), end(p), palette); };
     fill_palettes(obp_, register8{0xFFu});
     fill_palettes(cgb_bg_palettes_, palette{color{0xFFu}});
     fill_palettes(cgb_obj_palettes_, palette{color{0xFFu}});
 
+    set_table_color(line_compositor::blank_color_index, color{0xFFu});
+    update_gb_colors();
+    update_cgb_colors();
+
     add_delegate<&ppu::dma_read, &ppu::dma_write>(bus_, this,
       oam_dma_addr);
     add_delegate<&ppu::general_purpose_register_read, &ppu::general_purpose_register_write>(bus_, this,
@@ -127,30 +156,214 @@ void ppu::reset() noexcept
 
         dma_transfer_.oam_dma = 0x00u;
     }
+
+    map_vram();
+
+    bus_->get_scheduler()->add_event_delegate(scheduler::event::ppu, {connect_arg<&ppu::on_event>, this});
+    schedule_next_event();
+}
+
+void ppu::save_state(state_writer& writer) const
+{
+    writer.begin_section(state_section);
+    writer.write(registers_.lcdc);
+    writer.write(registers_.stat);
+    writer.write(registers_.ly);
+    writer.write(registers_.lyc);
+    writer.write(registers_.scx);
+    writer.write(registers_.scy);
+    writer.write(registers_.wx);
+    writer.write(registers_.wy);
+    writer.write(ram_);
+    writer.write(oam_);
+    writer.write(lcd_enabled_);
+    writer.write(line_rendered_);
+    writer.write(vblank_line_);
+    writer.write(window_line_);
+    writer.write(lcd_enable_delay_frame_count_);
+    writer.write(lcd_enable_delay_cycle_count_);
+    writer.write(last_sync_cycle_);
+    writer.write(cycle_count_);
+    writer.write(secondary_cycle_count_);
+    writer.write(vram_bank_);
+    writer.write(interrupt_request_);
+    writer.write(bgp_);
+    writer.write(obp_);
+    writer.write(cgb_bg_palettes_);
+    writer.write(cgb_obj_palettes_);
+    writer.write(bgpi_);
+    writer.write(bgpd_);
+    writer.write(obpi_);
+    writer.write(obpd_);
+    writer.write(dma_transfer_);
+    writer.write(fifo_line_);
+    writer.write(mode3_cycles_);
+    pixel_fifo_.save_state(writer);
+    writer.end_section();
+}
+
+void ppu::load_state(state_reader& reader) noexcept
+{
+    if(!reader.begin_section(state_section)) {
+        return;
+    }
+
+    reader.read(registers_.lcdc);
+    reader.read(registers_.stat);
+    reader.read(registers_.ly);
+    reader.read(registers_.lyc);
+    reader.read(registers_.scx);
+    reader.read(registers_.scy);
+    reader.read(registers_.wx);
+    reader.read(registers_.wy);
+    reader.read(ram_);
+    reader.read(oam_);
+    reader.read(lcd_enabled_);
+    reader.read(line_rendered_);
+    reader.read(vblank_line_);
+    reader.read(window_line_);
+    reader.read(lcd_enable_delay_frame_count_);
+    reader.read(lcd_enable_delay_cycle_count_);
+    reader.read(last_sync_cycle_);
+    reader.read(cycle_count_);
+    reader.read(secondary_cycle_count_);
+    reader.read(vram_bank_);
+    reader.read(interrupt_request_);
+    reader.read(bgp_);
+    reader.read(obp_);
+    reader.read(cgb_bg_palettes_);
+    reader.read(cgb_obj_palettes_);
+    reader.read(bgpi_);
+    reader.read(bgpd_);
+    reader.read(obpi_);
+    reader.read(obpd_);
+    reader.read(dma_transfer_);
+    reader.read(fifo_line_);
+    reader.read(mode3_cycles_);
+    pixel_fifo_.load_state(reader);
+    reader.end_section();
+
+    // everything derived from vram, oam and the palettes is rebuilt from them
+    for(size_t offset = 0u; offset < ram_.size(); offset += 2u) {
+        if(offset % vram_bank_size < map_tiles_offset) {
+            decode_tile_row(offset);
+        }
+    }
+
+    invalidate_map_layers();
+    obj_lines_dirty_ = true;
+
+    update_gb_colors();
+    update_cgb_colors();
+    map_vram();
+}
+
+void ppu::copy_settings(const ppu& other)
+{
+    render_mode_ = other.render_mode_;
+    render_frame_interval_ = other.render_frame_interval_;
+    frame_count_ = other.frame_count_;
+    render_frame_ = other.render_frame_;
+    renderer_ = other.renderer_;
+    gb_palette_ = other.gb_palette_;
+    color_correction_ = other.color_correction_;
+    framebuffer_ = other.framebuffer_;
+
+    update_gb_colors();
+    update_cgb_colors();
 }
 
-void ppu::tick(const uint8_t cycles)
+void ppu::sync()
+{
+    const auto now = bus_->get_scheduler()->now();
+    if(now == last_sync_cycle_) {
+        return;
+    }
+
+    advance(static_cast<uint32_t>(now - last_sync_cycle_));
+    last_sync_cycle_ = now;
+}
+
+void ppu::schedule_next_event() noexcept
+{
+    // conditions are only evaluated when time passes, so an already due event is handled at the next instruction
+    auto scheduler = bus_->get_scheduler();
+    scheduler->schedule(scheduler::event::ppu, last_sync_cycle_ + std::max(cycles_until_next_event(), 1u));
+}
+
+uint32_t ppu::cycles_until_next_event() const noexcept
+{
+    const auto until = [&](const uint32_t cycle_count, const uint32_t target) {
+        return cycle_count < target ? target - cycle_count : 0u;
+    };
+
+    if(!lcd_enabled_) {
+        if(lcd_enable_delay_cycle_count_ > 0) {
+            return static_cast<uint32_t>(lcd_enable_delay_cycle_count_);
+        }
+
+        return until(cycle_count_, total_frame_cycles);
+    }
+
+    switch(registers_.stat.get_mode()) {
+        case stat_mode::h_blank:
+            return until(cycle_count_, total_line_cycles - reading_oam_cycles - mode3_cycles_);
+        case stat_mode::reading_oam:
+            return until(cycle_count_, reading_oam_cycles);
+        case stat_mode::reading_oam_vram:
+            if(fifo_line_) {
+                return until(cycle_count_, pixel_fifo_.dot() + pixel_fifo_.dots_until_finished());
+            }
+            return until(cycle_count_, line_rendered_ ? reading_oam_vram_cycles : reading_oam_vram_render_cycles);
+        case stat_mode::v_blank: {
+            auto cycles = std::min(
+                until(secondary_cycle_count_, total_line_cycles),
+                until(cycle_count_, total_vblank_cycles));
+
+            if(registers_.ly == ly_max) {
+                cycles = std::min(cycles, std::max(
+                    until(cycle_count_, last_line_ly_reset_cycles),
+                    until(secondary_cycle_count_, last_line_ly_reset_delay)));
+            }
+
+            return cycles;
+        }
+    }
+
+    return 0u;
+}
+
+void ppu::on_event()
+{
+    sync();
+    schedule_next_event();
+}
+
+void ppu::advance(const uint32_t cycles)
 {
     cycle_count_ += cycles;
 
     if(!lcd_enabled_) {
         if(lcd_enable_delay_cycle_count_ > 0) {
-            lcd_enable_delay_cycle_count_ -= cycles;
+            // a sync can span far more cycles than the delay, it ends within it then
+            lcd_enable_delay_cycle_count_ = cycles < static_cast<uint32_t>(lcd_enable_delay_cycle_count_)
+                ? static_cast<int16_t>(lcd_enable_delay_cycle_count_ - static_cast<int16_t>(cycles))
+                : int16_t{0};
 
             if(lcd_enable_delay_cycle_count_ <= 0) {
                 lcd_enable_delay_cycle_count_ = 0;
                 lcd_enable_delay_frame_count_ = lcd_enable_delay_frames;
                 vblank_line_ = 0;
                 window_line_ = 0;
-                ly_ = 0u;
+                registers_.ly = 0u;
 
                 cycle_count_ = 0u;
                 secondary_cycle_count_ = 0u;
                 lcd_enabled_ = true;
-                stat_.set_mode(stat_mode::h_blank);
+                registers_.stat.set_mode(stat_mode::h_blank);
 
                 interrupt_request_.reset_all();
-                if(stat_.mode_interrupt_enabled(stat_mode::reading_oam)) {
+                if(registers_.stat.mode_interrupt_enabled(stat_mode::reading_oam)) {
                     bus_->get_cpu()->request_interrupt(interrupt::lcd_stat);
                     interrupt_request_.set(interrupt_request::oam);
                 }
@@ -173,11 +386,26 @@ void ppu::tick(const uint8_t cycles)
         return false;
     };
 
-    switch(stat_.get_mode()) {
+    const auto start_h_blank = [&]() {
+        registers_.stat.set_mode(stat_mode::h_blank);
+        map_vram();
+
+        reset_interrupt_requests({
+            interrupt_request::h_blank,
+            interrupt_request::v_blank,
+            interrupt_request::oam
+        });
+
+        if(registers_.stat.mode_interrupt_enabled()) {
+            request_interrupt(interrupt_request::h_blank);
+        }
+    };
+
+    switch(registers_.stat.get_mode()) {
         case stat_mode::h_blank: {
-            if(has_elapsed(hblank_cycles)) {
-                set_ly(register8(ly_ + 1));
-                stat_.set_mode(stat_mode::reading_oam);
+            if(has_elapsed(total_line_cycles - reading_oam_cycles - mode3_cycles_)) {
+                set_ly(register8(static_cast<uint8_t>(registers_.ly + 1u)));
+                registers_.stat.set_mode(stat_mode::reading_oam);
 
                 if(cgb_enabled_ && !dma_transfer_.disabled()) {
                     hdma();
@@ -185,25 +413,30 @@ void ppu::tick(const uint8_t cycles)
 
                 reset_interrupt_requests({interrupt_request::v_blank, interrupt_request::oam});
 
-                if(ly_ == screen_height) {
-                    stat_.set_mode(stat_mode::v_blank);
+                if(registers_.ly == screen_height) {
+                    registers_.stat.set_mode(stat_mode::v_blank);
                     secondary_cycle_count_ = cycle_count_;
                     vblank_line_ = 0;
                     window_line_ = 0;
 
                     bus_->get_cpu()->request_interrupt(interrupt::lcd_vblank);
 
-                    if(stat_.mode_interrupt_enabled()) {
+                    if(registers_.stat.mode_interrupt_enabled()) {
                         request_interrupt(interrupt_request::v_blank);
                     }
 
                     if(lcd_enable_delay_frame_count_ > 0) {
                         --lcd_enable_delay_frame_count_;
                     } else {
+                        if(render_frame_) {
+                            framebuffer_.swap();
+                        }
                         on_vblank_();
                     }
+
+                    update_render_frame();
                 } else {
-                    if(stat_.mode_interrupt_enabled()) {
+                    if(registers_.stat.mode_interrupt_enabled()) {
                         request_interrupt(interrupt_request::oam);
                     }
                 }
@@ -220,19 +453,19 @@ void ppu::tick(const uint8_t cycles)
 
                 ++vblank_line_;
                 if(vblank_line_ < 10) {
-                    set_ly(register8(ly_ + 1u));
+                    set_ly(register8(static_cast<uint8_t>(registers_.ly + 1u)));
                 }
             }
 
-            if(cycle_count_ >= 4104u && secondary_cycle_count_ >= 4u && ly_ == ly_max) {
+            if(cycle_count_ >= last_line_ly_reset_cycles && secondary_cycle_count_ >= last_line_ly_reset_delay && registers_.ly == ly_max) {
                 set_ly(register8{0u});
             }
 
             if(has_elapsed(total_vblank_cycles)) {
-                stat_.set_mode(stat_mode::reading_oam);
+                registers_.stat.set_mode(stat_mode::reading_oam);
 
                 reset_interrupt_requests({interrupt_request::h_blank, interrupt_request::oam});
-                if(stat_.mode_interrupt_enabled()) {
+                if(registers_.stat.mode_interrupt_enabled()) {
                     request_interrupt(interrupt_request::oam);
                 }
 
@@ -242,9 +475,15 @@ void ppu::tick(const uint8_t cycles)
         }
         case stat_mode::reading_oam: {
             if(has_elapsed(reading_oam_cycles)) {
-                stat_.set_mode(stat_mode::reading_oam_vram);
+                registers_.stat.set_mode(stat_mode::reading_oam_vram);
+                map_vram();
                 line_rendered_ = false;
 
+                fifo_line_ = renderer_ == renderer::pixel_fifo;
+                if(fifo_line_) {
+                    pixel_fifo_.start_line();
+                }
+
                 reset_interrupt_requests({
                     interrupt_request::h_blank,
                     interrupt_request::v_blank,
@@ -254,32 +493,67 @@ void ppu::tick(const uint8_t cycles)
             break;
         }
         case stat_mode::reading_oam_vram: {
+            if(fifo_line_) {
+                if(pixel_fifo_.advance_to(cycle_count_)) {
+                    mode3_cycles_ = pixel_fifo_.dot();
+                    cycle_count_ -= mode3_cycles_;
+                    start_h_blank();
+                }
+                break;
+            }
+
             if(cycle_count_ >= reading_oam_vram_render_cycles && !line_rendered_) {
                 line_rendered_ = true;
-                render();
+                if(render_frame_) {
+                    render();
+                } else {
+                    skip_render();
+                }
             }
 
             if(has_elapsed(reading_oam_vram_cycles)) {
-                stat_.set_mode(stat_mode::h_blank);
-
-                reset_interrupt_requests({
-                    interrupt_request::h_blank,
-                    interrupt_request::v_blank,
-                    interrupt_request::oam
-                });
-
-                if(stat_.mode_interrupt_enabled()) {
-                    request_interrupt(interrupt_request::h_blank);
-                }
+                mode3_cycles_ = reading_oam_vram_cycles;
+                start_h_blank();
             }
             break;
         }
     }
 }
 
+void ppu::set_render_mode(const render_mode mode, const uint32_t frame_interval) noexcept
+{
+    render_mode_ = mode;
+    render_frame_interval_ = std::max(frame_interval, 1u);
+    frame_count_ = 0u;
+    render_frame_ = render_mode_ != render_mode::timing_only;
+}
+
+ppu::palette_table ppu::get_palette_table() const noexcept
+{
+    if(cgb_enabled_) {
+        return color_table_;
+    }
+
+    palette_table table{};
+    std::copy(begin(gb_palette_.colors), end(gb_palette_.colors), begin(table));
+    return table;
+}
+
+void ppu::set_gb_palette(const palette& palette) noexcept
+{
+    gb_palette_ = palette;
+    update_gb_colors();
+}
+
+void ppu::set_color_correction(const color_correction& correction) noexcept
+{
+    color_correction_ = correction;
+    update_cgb_colors();
+}
+
 uint8_t ppu::read_ram(const address16& address) const
 {
-    if(stat_.get_mode() == stat_mode::reading_oam_vram) {
+    if(registers_.stat.get_mode() == stat_mode::reading_oam_vram) {
         return 0xFFu;
     }
 
@@ -288,7 +562,7 @@ uint8_t ppu::read_ram(const address16& address) const
 
 void ppu::write_ram(const address16& address, const uint8_t data)
 {
-    if(stat_.get_mode() == stat_mode::reading_oam_vram) {
+    if(registers_.stat.get_mode() == stat_mode::reading_oam_vram) {
         return;
     }
 
@@ -297,7 +571,7 @@ void ppu::write_ram(const address16& address, const uint8_t data)
 
 uint8_t ppu::read_oam(const address16& address) const
 {
-    if(stat_.get_mode() == stat_mode::reading_oam || stat_.get_mode() == stat_mode::reading_oam_vram) {
+    if(registers_.stat.get_mode() == stat_mode::reading_oam || registers_.stat.get_mode() == stat_mode::reading_oam_vram) {
         return 0xFFu;
     }
 
@@ -306,11 +580,16 @@ uint8_t ppu::read_oam(const address16& address) const
 
 void ppu::write_oam(const address16& address, const uint8_t data)
 {
-    if(stat_.get_mode() == stat_mode::reading_oam || stat_.get_mode() == stat_mode::reading_oam_vram) {
+    if(registers_.stat.get_mode() == stat_mode::reading_oam || registers_.stat.get_mode() == stat_mode::reading_oam_vram) {
         return;
     }
 
-    oam_[address.value() - *begin(oam_range)] = data;
+    const auto oam_offset = static_cast<size_t>(address.value() - *begin(oam_range));
+    if(oam_offset % sizeof(attributes::obj) == 0u && oam_[oam_offset] != data) {
+        obj_lines_dirty_ = true;
+    }
+
+    oam_[oam_offset] = data;
 }
 
 uint8_t ppu::read_ram_by_bank(const address16& address, const uint8_t bank) const
@@ -328,7 +607,17 @@ void ppu::write_ram_by_bank(const address16& address, const uint8_t data, const
         return;
     }
 
-    ram_[address.value() - *begin(vram_range) + bank * 8_kb] = data;
+    const auto ram_offset = address.value() - *begin(vram_range) + bank * 8_kb;
+    ram_[ram_offset] = data;
+
+    if(const auto bank_offset = ram_offset % 8_kb; bank_offset < map_tiles_offset) {
+        decode_tile_row(ram_offset);
+        dirty_tile_data_.set(bank * tile_count + bank_offset / tile_size);
+    } else {
+        // map entries and their cgb attributes share the same offsets in both banks
+        const auto map_offset = bank_offset - map_tiles_offset;
+        map_layers_[map_offset / map_tiles_size].dirty_tiles.set(map_offset % map_tiles_size);
+    }
 }
 
 uint8_t ppu::dma_read(const address16& address) const
@@ -373,7 +662,7 @@ void ppu::dma_write(const address16& address, const uint8_t data)
         } else {
             if(bit::test(data, 7u)) {
                 dma_transfer_.length_mode_start = data & 0x7Fu;
-                if(stat_.get_mode() == stat_mode::h_blank) {
+                if(registers_.stat.get_mode() == stat_mode::h_blank) {
                     hdma();
                 }
             } else {
@@ -387,27 +676,35 @@ void ppu::dma_write(const address16& address, const uint8_t data)
 uint8_t ppu::general_purpose_register_read(const address16& address) const
 {
     if(address == vbk_addr) { return vram_bank_ | 0xFEu; }
-    if(address == lcdc_addr) { return lcdc_.reg.value(); }
-    if(address == stat_addr) { return stat_.reg.value() | 0x80u; }
-    if(address == scy_addr) { return scy_.value(); }
-    if(address == scx_addr) { return scx_.value(); }
-    if(address == ly_addr) { return lcd_enabled_ ? ly_.value() : 0u; }
-    if(address == lyc_addr) { return lyc_.value(); }
-    if(address == wy_addr) { return wy_.value(); }
-    if(address == wx_addr) { return wx_.value(); }
+    if(address == lcdc_addr) { return registers_.lcdc.reg.value(); }
+    if(address == stat_addr) { return registers_.stat.reg.value() | 0x80u; }
+    if(address == scy_addr) { return registers_.scy.value(); }
+    if(address == scx_addr) { return registers_.scx.value(); }
+    if(address == ly_addr) { return lcd_enabled_ ? registers_.ly.value() : 0u; }
+    if(address == lyc_addr) { return registers_.lyc.value(); }
+    if(address == wy_addr) { return registers_.wy.value(); }
+    if(address == wx_addr) { return registers_.wx.value(); }
 
     return 0u;
 }
 
 void ppu::general_purpose_register_write(const address16& address, const uint8_t data)
 {
+    // every mode or line change is a scheduled event, so only writes which alter the timing need to catch up
+    sync();
+
     if(address == vbk_addr) {
         vram_bank_ = data & 0x01u;
+        map_vram();
     } else if(address == lcdc_addr) {
         register_lcdc new_lcdc{data};
 
-        if(!lcdc_.window_enabled() && new_lcdc.window_enabled()) {
-            if(window_line_ == 0u && ly_ < screen_height && ly_ > wy_) {
+        if(fifo_drawing()) {
+            pixel_fifo_.flush();
+        }
+
+        if(!registers_.lcdc.window_enabled() && new_lcdc.window_enabled()) {
+            if(window_line_ == 0u && registers_.ly < screen_height && registers_.ly > registers_.wy) {
                 window_line_ = screen_height;
             }
         }
@@ -420,17 +717,25 @@ void ppu::general_purpose_register_write(const address16& address, const uint8_t
             disable_screen();
         }
 
-        lcdc_.reg = data;
+        if(registers_.lcdc.large_obj() != new_lcdc.large_obj()) {
+            obj_lines_dirty_ = true;
+        }
+
+        if(registers_.lcdc.unsigned_mode() != new_lcdc.unsigned_mode()) {
+            invalidate_map_layers();
+        }
+
+        registers_.lcdc.reg = data;
     } else if(address == stat_addr) {
-        stat_.reg = (stat_.reg & 0x07u) | (data & 0x78u);
+        registers_.stat.reg = (registers_.stat.reg & 0x07u) | (data & 0x78u);
 
         auto irq_copy = interrupt_request_;
-        irq_copy.request &= (stat_.reg.value() >> 3u) & 0x0Fu;
+        irq_copy.request &= static_cast<uint8_t>((registers_.stat.reg.value() >> 3u) & 0x0Fu);
         interrupt_request_ = irq_copy;
 
-        if(lcdc_.lcd_enabled()) {
-            if(stat_.mode_interrupt_enabled()) {
-                switch(stat_.get_mode()) {
+        if(registers_.lcdc.lcd_enabled()) {
+            if(registers_.stat.mode_interrupt_enabled()) {
+                switch(registers_.stat.get_mode()) {
                     case stat_mode::h_blank:
                         request_interrupt(irq_copy, interrupt_request::h_blank);
                         break;
@@ -448,18 +753,20 @@ void ppu::general_purpose_register_write(const address16& address, const uint8_t
             compare_coincidence();
         }
     } else if(address == scy_addr) {
-        scy_ = data;
+        registers_.scy = data;
     } else if(address == scx_addr) {
-        scx_ = data;
+        registers_.scx = data;
     } else if(address == ly_addr) {
         set_ly(register8{0x00u});
     } else if(address == lyc_addr) {
         set_lyc(register8{data});
     } else if(address == wy_addr) {
-        wy_ = data;
+        registers_.wy = data;
     } else if(address == wx_addr) {
-        wx_ = data;
+        registers_.wx = data;
     }
+
+    schedule_next_event();
 }
 
 uint8_t ppu::palette_read(const address16& address) const
@@ -477,6 +784,14 @@ uint8_t ppu::palette_read(const address16& address) const
 
 void ppu::palette_write(const address16& address, const uint8_t data)
 {
+    // the pixel fifo colors the pixels it has drawn before the palette changes
+    if(fifo_line_) {
+        sync();
+        if(fifo_drawing()) {
+            pixel_fifo_.flush();
+        }
+    }
+
     const auto update_palette_data_register = [](auto& index_register, auto& data_register, auto& palettes) {
         const auto is_msb = bit::test(index_register, 0u);
         const auto color_index = (index_register.value() >> 1u) & 0x03u;
@@ -490,7 +805,7 @@ void ppu::palette_write(const address16& address, const uint8_t data)
         }
     };
 
-    const auto set_palette = [&](auto& index_register, auto& data_register, auto& palettes, const uint8_t data) noexcept {
+    const auto set_palette = [&](auto& index_register, auto& data_register, auto& palettes, const uint8_t color_table_offset, const uint8_t value) noexcept {
         const auto auto_increment = bit::test(index_register, 7u);
         const auto is_msb = bit::test(index_register, 0u);
         const auto color_index = (index_register.value() >> 1u) & 0x03u;
@@ -500,13 +815,15 @@ void ppu::palette_write(const address16& address, const uint8_t data)
         // lsb | GGGRRRRR |
         auto& color = palettes[palette_index].colors[color_index];
         if(is_msb) {
-            color.blue = (data >> 2u) & 0x1Fu;
-            color.green |= (data & 0x03u) << 3u;
+            color.blue = (value >> 2u) & 0x1Fu;
+            color.green |= (value & 0x03u) << 3u;
         } else {
-            color.red = data & 0x1Fu;
-            color.green = (data >> 5u) & 0x07u;
+            color.red = value & 0x1Fu;
+            color.green = (value >> 5u) & 0x07u;
         }
 
+        set_table_color(color_table_offset + palette_index * 4u + color_index, correct_color(color));
+
         if(auto_increment) {
             index_register = (index_register & 0x80u) | ((index_register + 1u) & 0x3Fu);
             update_palette_data_register(index_register, data_register, palettes);
@@ -515,10 +832,13 @@ void ppu::palette_write(const address16& address, const uint8_t data)
 
     if(address == bgp_addr) {
         bgp_ = data;
+        update_gb_colors();
     } else if(address == obp_0_addr) {
         obp_[0] = data;
+        update_gb_colors();
     } else if(address == obp_1_addr) {
         obp_[1] = data;
+        update_gb_colors();
     } else if(address == bgpi_addr) {
         bgpi_ = data;
         update_palette_data_register(bgpi_, bgpd_, cgb_bg_palettes_);
@@ -526,37 +846,42 @@ void ppu::palette_write(const address16& address, const uint8_t data)
         obpi_ = data;
         update_palette_data_register(obpi_, obpd_, cgb_obj_palettes_);
     } else if(address == bgpd_addr) {
-        set_palette(bgpi_, bgpd_, cgb_bg_palettes_, data);
+        set_palette(bgpi_, bgpd_, cgb_bg_palettes_, 0u, data);
     } else if(address == obpd_addr) {
-        set_palette(obpi_, obpd_, cgb_obj_palettes_, data);
+        set_palette(obpi_, obpd_, cgb_obj_palettes_, line_compositor::obj_color_offset, data);
     }
 }
 
+bool ppu::fifo_drawing() const noexcept
+{
+    return fifo_line_ && lcd_enabled_ && registers_.stat.get_mode() == stat_mode::reading_oam_vram;
+}
+
 void ppu::compare_coincidence() noexcept
 {
-    if(ly_ == lyc_) {
-        stat_.set_coincidence_flag();
+    if(registers_.ly == registers_.lyc) {
+        registers_.stat.set_coincidence_flag();
 
-        if(stat_.coincidence_interrupt_enabled()) {
+        if(registers_.stat.coincidence_interrupt_enabled()) {
             request_interrupt(interrupt_request::coincidence);
         }
     } else {
-        stat_.reset_coincidence_flag();
+        registers_.stat.reset_coincidence_flag();
         interrupt_request_.reset(interrupt_request::coincidence);
     }
 }
 
 void ppu::set_ly(const register8& ly) noexcept
 {
-    ly_ = ly;
+    registers_.ly = ly;
     compare_coincidence();
 }
 
 void ppu::set_lyc(const register8& lyc) noexcept
 {
-    if(lyc_ != lyc) {
-        lyc_ = lyc;
-        if(lcdc_.lcd_enabled()) {
+    if(registers_.lyc != lyc) {
+        registers_.lyc = lyc;
+        if(registers_.lcdc.lcd_enabled()) {
             compare_coincidence();
         }
     }
@@ -565,12 +890,22 @@ void ppu::set_lyc(const register8& lyc) noexcept
 void ppu::disable_screen() noexcept
 {
     lcd_enabled_ = false;
-    stat_.set_mode(stat_mode::h_blank);
+    fifo_line_ = false;
+    mode3_cycles_ = reading_oam_vram_cycles;
+    registers_.stat.set_mode(stat_mode::h_blank);
+    map_vram();
     interrupt_request_.reset_all();
 
     cycle_count_ = 0;
     secondary_cycle_count_ = 0;
-    ly_ = 0;
+    registers_.ly = 0;
+}
+
+void ppu::map_vram() noexcept
+{
+    // vram is inaccessible to the cpu while the ppu is drawing
+    const auto* bank = registers_.stat.get_mode() == stat_mode::reading_oam_vram ? nullptr : ram_.data() + vram_bank_ * 8_kb;
+    bus_->get_mmu()->map_vram_pages(bank);
 }
 
 void ppu::request_interrupt(interrupt_request::type type) noexcept
@@ -630,168 +965,121 @@ void ppu::gdma()
 
 void ppu::render() noexcept
 {
-    render_line line{};
-    render_buffer buffer{};
-    std::fill(begin(buffer), end(buffer), std::make_pair(0u, attributes::uninitialized{}));
+    line_buffer buffer;
+    buffer.clear();
 
     render_background(buffer);
     render_window(buffer);
     render_obj(buffer);
 
-    for(auto pixel_idx = 0u; pixel_idx < line.size(); ++pixel_idx) {
-        const auto& [color_idx, attr] = buffer[pixel_idx];
-
-        visit_nt(attr,
-            [&](attributes::uninitialized) {
-                line[pixel_idx] = color{0xFFu};
-            },
-            [&, color = color_idx](const attributes::bg& bg_attr) {
-                if(cgb_enabled_) {
-                    const auto palette_color = cgb_bg_palettes_[bg_attr.palette_index()].colors[color];
-                    line[pixel_idx] = correct_color(palette_color);
-                } else {
-                    const auto background_palette = palette::from(gb_palette_, bgp_.value());
-                    line[pixel_idx] = background_palette.colors[color];
-                }
-            },
-            [&, color = color_idx](const attributes::obj& obj_attr) {
-                if(cgb_enabled_) {
-                    const auto palette_color = cgb_obj_palettes_[obj_attr.cgb_palette_index()].colors[color];
-                    line[pixel_idx] = correct_color(palette_color);
-                } else {
-                    const auto background_palette =
-                        palette::from(gb_palette_, obp_[obj_attr.gb_palette_index()].value());
-                    line[pixel_idx] = background_palette.colors[color];
-                }
-            }
-        );
-    }
-
-    on_render_line_(ly_.value(), line);
-}
+    std::array<uint8_t, screen_width> color_indices;
+    compositor_(buffer, cgb_enabled_ && !registers_.lcdc.bg_enabled(), color_indices.data());
 
-void ppu::render_background(render_buffer& buffer) const noexcept
-{
-    if(!cgb_enabled_ && !lcdc_.bg_enabled()) {
-        return;
-    }
+    framebuffer_.write_line(registers_.ly.value(), color_indices);
 
-    const auto scroll_offset = (scx_ + screen_width) % map_pixel_count;
-    const auto tile_start_addr = address16(lcdc_.bg_map_secondary() ? 0x9C00u : 0x9800u);
-    const auto tile_y_to_render = (scy_ + ly_.value()) % tile_pixel_count;
-    const auto tile_map_y = ((scy_ + ly_.value()) / tile_pixel_count) % map_tile_count;
-
-    constexpr auto max_render_tile_count = screen_width / tile_pixel_count + 1;
-    const auto tile_map_x_start = scx_.value() / tile_pixel_count;
-
-    auto rendered_pix_idx = 0u;
-    for(auto tile_render_count = 0u; tile_render_count < max_render_tile_count; ++tile_render_count) {
-        const auto tile_map_x = (tile_map_x_start + tile_render_count) % map_tile_count;
-        const auto tile_map_idx = tile_start_addr + tile_map_y * map_tile_count + tile_map_x;
-
-        const auto tile_no = read_ram_by_bank(tile_map_idx, 0);
-        const attributes::bg tile_attr{read_ram_by_bank(tile_map_idx, 1)};
-
-        const auto tile_y = tile_attr.v_flipped()
-            ? tile_pixel_count - tile_y_to_render - 1u
-            : tile_y_to_render;
-
-        auto tile_row = get_tile_row(tile_y, tile_no, tile_attr.vram_bank());
-        if(tile_attr.h_flipped()) {
-            std::reverse(begin(tile_row), end(tile_row));
+    if(on_render_line_) {
+        render_line line;
+        for(auto pixel_idx = 0u; pixel_idx < line.size(); ++pixel_idx) {
+            line[pixel_idx] = color_table_[color_indices[pixel_idx]];
         }
 
-        for(auto tile_x = 0u; tile_x < tile_pixel_count; ++tile_x) {
-            const auto pix_idx = tile_map_x * tile_pixel_count + tile_x;
+        on_render_line_(registers_.ly.value(), line);
+    }
+}
 
-            if(rendered_pix_idx < screen_width && (scx_ <= pix_idx ||
-                (scx_ > scroll_offset && pix_idx < scroll_offset)) // bg scroll overflow
-            ) {
-                buffer[rendered_pix_idx++] = std::make_pair(tile_row[tile_x], tile_attr);
-            }
-        }
+void ppu::skip_render() noexcept
+{
+    // the window line counter is the only state a drawn line leaves behind
+    if(window_visible()) {
+        ++window_line_;
     }
 }
 
-void ppu::render_window(render_buffer& buffer) noexcept
+void ppu::update_render_frame() noexcept
 {
-    if(window_line_ >= screen_height || !lcdc_.window_enabled()) {
-        return;
+    ++frame_count_;
+
+    switch(render_mode_) {
+        case render_mode::full:
+            render_frame_ = true;
+            break;
+        case render_mode::skip_n:
+            render_frame_ = frame_count_ % render_frame_interval_ == 0u;
+            break;
+        case render_mode::timing_only:
+            render_frame_ = false;
+            break;
     }
+}
 
-    if(wy_ > ly_ || wy_ >= screen_height || wx_ >= screen_width + 7u) {
+void ppu::render_background(line_buffer& buffer) noexcept
+{
+    if(!cgb_enabled_ && !registers_.lcdc.bg_enabled()) {
         return;
     }
 
-    const auto tile_start_addr = address16(lcdc_.window_map_secondary() ? 0x9C00u : 0x9800u);
-    const auto tile_y_to_render = window_line_ % tile_pixel_count;
-
-    const auto tile_map_y_start = tile_start_addr + window_line_ / tile_pixel_count * map_tile_count;
-    const auto tile_map_x_end = screen_width / tile_pixel_count;
+    const auto map_idx = registers_.lcdc.bg_map_secondary() ? 1u : 0u;
+    const auto map_y = (registers_.scy.value() + registers_.ly.value()) % map_pixel_count;
+    update_map_layer_row(map_idx, map_y / tile_pixel_count);
 
-    for(auto tile_map_x = 0; tile_map_x < tile_map_x_end + 1u; ++tile_map_x) {
-        const auto tile_map_idx = tile_map_y_start + tile_map_x;
-        const auto tile_no = read_ram_by_bank(tile_map_idx, 0);
-        const attributes::bg tile_attr{read_ram_by_bank(tile_map_idx, 1)};
+    // the visible part of the map may wrap around to its left edge
+    const auto scx = registers_.scx.value();
+    const auto unwrapped_count = std::min(screen_width, map_pixel_count - scx);
+    copy_map_layer(map_idx, map_y * map_pixel_count + scx, buffer, 0u, unwrapped_count);
+    copy_map_layer(map_idx, map_y * map_pixel_count, buffer, unwrapped_count, screen_width - unwrapped_count);
+}
 
-        const auto tile_y = tile_attr.v_flipped()
-            ? tile_pixel_count - tile_y_to_render - 1u
-            : tile_y_to_render;
+void ppu::render_window(line_buffer& buffer) noexcept
+{
+    if(!window_visible()) {
+        return;
+    }
 
-        auto tile_row = get_tile_row(tile_y, tile_no, tile_attr.vram_bank());
-        if(tile_attr.h_flipped()) {
-            std::reverse(begin(tile_row), end(tile_row));
-        }
+    const auto map_idx = registers_.lcdc.window_map_secondary() ? 1u : 0u;
+    update_map_layer_row(map_idx, window_line_ / tile_pixel_count);
 
-        for(auto tile_x = 0u; tile_x < tile_pixel_count; ++tile_x) {
-            const int16_t pix_idx = tile_map_x * tile_pixel_count + tile_x + wx_.value() - 7;
+    const auto window_x = static_cast<int32_t>(registers_.wx.value()) - 7;
+    const auto x = static_cast<size_t>(std::max(window_x, 0));
+    const auto layer_x = static_cast<size_t>(std::max(-window_x, 0));
+    copy_map_layer(map_idx, window_line_ * map_pixel_count + layer_x, buffer, x, screen_width - x);
 
-            if(pix_idx >= static_cast<int32_t>(screen_width)) {
-                ++window_line_;
-                return;
-            }
+    ++window_line_;
+}
 
-            if(0 <= pix_idx) {
-                buffer[pix_idx] = std::make_pair(tile_row[tile_x], tile_attr);
-            }
-        }
+bool ppu::window_visible() const noexcept
+{
+    if(window_line_ >= screen_height || !registers_.lcdc.window_enabled()) {
+        return false;
     }
+
+    return registers_.wy <= registers_.ly && registers_.wy < screen_height && registers_.wx < screen_width + 7u;
 }
 
-void ppu::render_obj(render_buffer& buffer) const noexcept
+void ppu::render_obj(line_buffer& buffer) noexcept
 {
-    if(!lcdc_.obj_enabled()) {
+    if(!registers_.lcdc.obj_enabled()) {
         return;
     }
 
-    const auto obj_size = lcdc_.large_obj() ? 16 : 8;
-
-    std::array<attributes::obj, 40> objs;
-    std::memcpy(&objs, oam_.data(), oam_.size());
-
-    auto indices = [&]() {
-        const int32_t ly = ly_.value();
-        std::vector<size_t> idxs;
-
-        for(size_t idx = 0; idx < objs.size(); ++idx) {
-            const auto& obj = objs[idx];
-            const auto obj_y = obj.y - 16;
+    if(obj_lines_dirty_) {
+        update_obj_lines();
+    }
 
-            if(ly >= obj_y && ly < obj_y + obj_size) {
-                idxs.push_back(idx);
-                if(idxs.size() == 10) {
-                    break;
-                }
-            }
-        }
+    const auto obj_size = registers_.lcdc.large_obj() ? 16 : 8;
+    const auto read_obj = [&](const size_t index) {
+        attributes::obj obj;
+        std::memcpy(&obj, oam_.data() + index * sizeof(attributes::obj), sizeof(attributes::obj));
+        return obj;
+    };
 
-        return idxs;
-    }();
+    auto line = obj_lines_[registers_.ly.value()];
+    const auto indices_begin = begin(line.indices);
+    const auto indices_end = indices_begin + line.count;
 
     if(!cgb_enabled_) {
-        std::sort(begin(indices), end(indices), [&](const auto l, const auto r) {
-            const auto& obj_l = objs[l];
-            const auto& obj_r = objs[r];
+        std::sort(indices_begin, indices_end, [&](const auto l, const auto r) {
+            const auto obj_l = read_obj(l);
+            const auto obj_r = read_obj(r);
 
             if(obj_l.x == obj_r.x) {
                 return l < r;
@@ -801,10 +1089,10 @@ void ppu::render_obj(render_buffer& buffer) const noexcept
         });
     }
 
-    std::reverse(begin(indices), end(indices));
+    std::reverse(indices_begin, indices_end);
 
-    for(const auto index : indices) {
-        const auto& obj = objs[index];
+    for(auto it = indices_begin; it != indices_end; ++it) {
+        const auto obj = read_obj(*it);
 
         const auto obj_y = obj.y - 16;
         const auto obj_x = obj.x - 8;
@@ -813,18 +1101,14 @@ void ppu::render_obj(render_buffer& buffer) const noexcept
             continue;
         }
 
-        auto tile_row = get_tile_row(
-            obj.v_flipped()
-                ? obj_size - (ly_ - obj_y) - 1u
-                : ly_ - obj_y,
-            tile_address<uint8_t>(0x8000u, lcdc_.large_obj()
+        const auto tile_y = registers_.ly.value() - obj_y;
+        const auto& tile_row = get_tile_row(
+            static_cast<uint8_t>(obj.v_flipped() ? obj_size - tile_y - 1 : tile_y),
+            tile_address<uint8_t>(0x8000u, registers_.lcdc.large_obj()
                 ? obj.tile_number & 0xFEu
                 : obj.tile_number),
-            obj.vram_bank());
-
-        if(obj.h_flipped()) {
-            std::reverse(begin(tile_row), end(tile_row));
-        }
+            obj.vram_bank(),
+            obj.h_flipped());
 
         for(auto tile_x = 0u; tile_x < tile_pixel_count; ++tile_x) {
             const auto x = obj_x + tile_x;
@@ -832,79 +1116,202 @@ void ppu::render_obj(render_buffer& buffer) const noexcept
                 continue;
             }
 
-            const auto& [color_idx, attr] = buffer[x];
-
             const auto dot_color = tile_row[tile_x];
             if(dot_color == 0u) { // obj color0 is transparent
                 continue;
             }
 
-            visit_nt(attr,
-                [&](auto&&) {
-                    buffer[x] = std::make_pair(dot_color, obj);
-                },
-                [&, existing_bg_color = color_idx](const attributes::bg& bg_attr) {
-                    const auto master_priority_enabled = cgb_enabled_ && !lcdc_.bg_enabled();
-                    const auto obj_priority_enabled = obj.prioritized() && !bg_attr.prioritized();
+            // objects are drawn from the lowest priority, whether they show above the bg is resolved by the compositor
+            buffer.obj_color_indices[x] = dot_color;
+            buffer.obj_palettes[x] = cgb_enabled_ ? obj.cgb_palette_index() : obj.gb_palette_index();
+            if(obj.prioritized()) {
+                buffer.obj_flags[x] |= line_buffer::obj_flag_prioritized;
+            }
+        }
+    }
+}
+
+void ppu::update_obj_lines() noexcept
+{
+    const auto obj_size = registers_.lcdc.large_obj() ? 16 : 8;
 
-                    if(existing_bg_color == 0u || master_priority_enabled || obj_priority_enabled) {
-                        buffer[x] = std::make_pair(dot_color, obj);
-                    }
-                }
-            );
+    for(auto& line : obj_lines_) {
+        line.count = 0u;
+    }
+
+    for(auto index = 0u; index < obj_count; ++index) {
+        const auto obj_y = oam_[index * sizeof(attributes::obj)] - 16;
+        const auto first_line = std::max(obj_y, 0);
+        const auto last_line = std::min(obj_y + obj_size, static_cast<int32_t>(screen_height));
+
+        for(auto l = first_line; l < last_line; ++l) {
+            auto& line = obj_lines_[static_cast<size_t>(l)];
+            if(line.count < max_objs_per_line) {
+                line.indices[line.count++] = static_cast<uint8_t>(index);
+            }
+        }
+    }
+
+    obj_lines_dirty_ = false;
+}
+
+void ppu::decode_tile_row(const size_t ram_offset) noexcept
+{
+    const auto row_offset = ram_offset & ~size_t{1u};
+    const auto lsb = ram_[row_offset];
+    const auto msb = ram_[row_offset + 1];
+
+    auto& decoded = tile_cache_[row_offset / 8_kb * tile_count * tile_pixel_count + row_offset % 8_kb / 2];
+    for(auto bit = 0u; bit < tile_pixel_count; ++bit) {
+        const auto pix_color = static_cast<uint8_t>(((msb >> bit) & 0x1u) << 1u | ((lsb >> bit) & 0x1u));
+        decoded.pixels[tile_pixel_count - bit - 1] = pix_color;
+        decoded.flipped_pixels[bit] = pix_color;
+    }
+}
+
+void ppu::invalidate_map_layers() noexcept
+{
+    for(auto& layer : map_layers_) {
+        layer.dirty_tiles.set();
+    }
+
+    dirty_tile_data_.reset();
+}
+
+void ppu::propagate_dirty_tile_data() noexcept
+{
+    if(dirty_tile_data_.none()) {
+        return;
+    }
+
+    for(auto map_idx = 0u; map_idx < map_layers_.size(); ++map_idx) {
+        auto& layer = map_layers_[map_idx];
+        const auto map_offset = map_tiles_offset + map_idx * map_tiles_size;
+
+        for(auto map_tile_idx = 0u; map_tile_idx < map_tiles_size; ++map_tile_idx) {
+            const auto tile_no = ram_[map_offset + map_tile_idx];
+            const attributes::bg tile_attr{cgb_enabled_ ? ram_[8_kb + map_offset + map_tile_idx] : uint8_t{0u}};
+            const auto tile_idx = registers_.lcdc.unsigned_mode() ? tile_no : static_cast<uint32_t>(256 + static_cast<int8_t>(tile_no));
+
+            if(dirty_tile_data_.test(tile_attr.vram_bank() * tile_count + tile_idx)) {
+                layer.dirty_tiles.set(map_tile_idx);
+            }
+        }
+    }
+
+    dirty_tile_data_.reset();
+}
+
+void ppu::update_map_layer_row(const size_t map_idx, const uint32_t tile_row) noexcept
+{
+    propagate_dirty_tile_data();
+
+    const auto& layer = map_layers_[map_idx];
+    for(auto map_tile_idx = tile_row * map_tile_count; map_tile_idx < (tile_row + 1) * map_tile_count; ++map_tile_idx) {
+        if(layer.dirty_tiles.test(map_tile_idx)) {
+            draw_map_tile(map_idx, map_tile_idx);
         }
     }
 }
 
-std::array<uint8_t, ppu::tile_pixel_count> ppu::get_tile_row(
-    const uint8_t row, const uint8_t tile_no, const uint8_t bank) const noexcept
+void ppu::draw_map_tile(const size_t map_idx, const uint32_t map_tile_idx) noexcept
+{
+    auto& layer = map_layers_[map_idx];
+    const auto map_offset = map_tiles_offset + map_idx * map_tiles_size + map_tile_idx;
+    const auto tile_no = ram_[map_offset];
+    const attributes::bg tile_attr{cgb_enabled_ ? ram_[8_kb + map_offset] : uint8_t{0u}};
+    const auto flags = static_cast<uint8_t>(line_buffer::bg_flag_present | (tile_attr.prioritized() ? line_buffer::bg_flag_prioritized : 0u));
+
+    const auto pixel_x = map_tile_idx % map_tile_count * tile_pixel_count;
+    const auto pixel_y = map_tile_idx / map_tile_count * tile_pixel_count;
+
+    for(auto tile_y = 0u; tile_y < tile_pixel_count; ++tile_y) {
+        const auto& tile_row = get_tile_row(
+            static_cast<uint8_t>(tile_attr.v_flipped() ? tile_pixel_count - tile_y - 1u : tile_y),
+            tile_no, tile_attr.vram_bank(), tile_attr.h_flipped());
+
+        const auto pixel_idx = (pixel_y + tile_y) * map_pixel_count + pixel_x;
+        std::copy(begin(tile_row), end(tile_row), begin(layer.color_indices) + pixel_idx);
+        std::fill_n(begin(layer.palettes) + pixel_idx, tile_pixel_count, tile_attr.palette_index());
+        std::fill_n(begin(layer.flags) + pixel_idx, tile_pixel_count, flags);
+    }
+
+    layer.dirty_tiles.reset(map_tile_idx);
+    layer.redrawn_tiles.set(map_tile_idx);
+}
+
+void ppu::copy_map_layer(const size_t map_idx, const size_t map_pixel_idx, line_buffer& buffer, const size_t x, const size_t count) const noexcept
 {
-    const auto tile_base_addr = lcdc_.unsigned_mode()
+    const auto& layer = map_layers_[map_idx];
+    std::memcpy(buffer.bg_color_indices.data() + x, layer.color_indices.data() + map_pixel_idx, count);
+    std::memcpy(buffer.bg_palettes.data() + x, layer.palettes.data() + map_pixel_idx, count);
+    std::memcpy(buffer.bg_flags.data() + x, layer.flags.data() + map_pixel_idx, count);
+}
+
+const std::array<uint8_t, ppu::tile_pixel_count>& ppu::get_tile_row(
+    const uint8_t row, const uint8_t tile_no, const uint8_t bank, const bool h_flipped) const noexcept
+{
+    const auto tile_base_addr = registers_.lcdc.unsigned_mode()
         ? tile_address<uint8_t>(0x8000u, tile_no)
         : tile_address<int8_t>(0x9000u, tile_no);
 
-    return get_tile_row(row, tile_base_addr, bank);
+    return get_tile_row(row, tile_base_addr, bank, h_flipped);
 }
 
-std::array<uint8_t, ppu::tile_pixel_count> ppu::get_tile_row(
+const std::array<uint8_t, ppu::tile_pixel_count>& ppu::get_tile_row(
     const uint8_t row,
     const address16& tile_base_addr,
-    const uint8_t bank) const noexcept
+    const uint8_t bank,
+    const bool h_flipped) const noexcept
 {
-    const auto tile_y_offset = row * 2;
-    const auto lsb = read_ram_by_bank(tile_base_addr + tile_y_offset, bank);
-    const auto msb = read_ram_by_bank(tile_base_addr + tile_y_offset + 1, bank);
+    const auto tile_idx = (tile_base_addr.value() - *begin(vram_range)) / tile_size;
+    const auto& decoded = tile_cache_[(bank * tile_count + tile_idx) * tile_pixel_count + row];
+    return h_flipped ? decoded.flipped_pixels : decoded.pixels;
+}
 
-    struct pixel_generator {
-        uint8_t lsb;
-        uint8_t msb;
-        uint8_t bit = tile_pixel_count - 1;
+void ppu::set_table_color(const size_t color_table_index, const color& c) noexcept
+{
+    color_table_[color_table_index] = c;
+    framebuffer_.set_color(static_cast<uint8_t>(color_table_index), c);
+}
 
-        [[nodiscard]] uint8_t operator()() {
-            const auto mask = static_cast<uint32_t>(1u << bit);
-            const auto pix_color = static_cast<uint8_t>((msb & mask) >> bit << 1u | (lsb & mask) >> bit);
-            --bit;
-            return pix_color;
+void ppu::update_gb_colors() noexcept
+{
+    if(cgb_enabled_) {
+        return;
+    }
+
+    const auto copy_palette = [&](const register8& reg, const size_t offset) {
+        const auto p = palette::from(gb_palette_, reg.value());
+        for(auto color_idx = 0u; color_idx < p.colors.size(); ++color_idx) {
+            set_table_color(offset + color_idx, p.colors[color_idx]);
+            framebuffer_.set_index(static_cast<uint8_t>(offset + color_idx), (reg.value() >> (color_idx * 2u)) & 0x3u);
         }
     };
 
-    std::array<uint8_t, tile_pixel_count> tile_row{};
-    std::generate(begin(tile_row), end(tile_row), pixel_generator{lsb, msb});
-
-    return tile_row;
+    copy_palette(bgp_, 0u);
+    copy_palette(obp_[0], line_compositor::obj_color_offset);
+    copy_palette(obp_[1], line_compositor::obj_color_offset + 4u);
+    framebuffer_.set_index(line_compositor::blank_color_index, 0u);
 }
 
-color ppu::correct_color(const color& c) noexcept
+void ppu::update_cgb_colors() noexcept
 {
-    const auto do_correct = [](const uint8_t color) {
-        return static_cast<uint8_t>(color * 0xFFu / 0x1Fu);
-    };
+    if(!cgb_enabled_) {
+        return;
+    }
 
-    return {
-        do_correct(c.red),
-        do_correct(c.green),
-        do_correct(c.blue)
-    };
+    for(auto color_table_idx = 0u; color_table_idx < color_table_.size(); ++color_table_idx) {
+        framebuffer_.set_index(static_cast<uint8_t>(color_table_idx), static_cast<uint8_t>(color_table_idx));
+    }
+
+    for(auto palette_idx = 0u; palette_idx < cgb_bg_palettes_.size(); ++palette_idx) {
+        for(auto color_idx = 0u; color_idx < 4u; ++color_idx) {
+            set_table_color(palette_idx * 4u + color_idx, correct_color(cgb_bg_palettes_[palette_idx].colors[color_idx]));
+            set_table_color(line_compositor::obj_color_offset + palette_idx * 4u + color_idx,
+                correct_color(cgb_obj_palettes_[palette_idx].colors[color_idx]));
+        }
+    }
 }
 
 } // namespace gameboy
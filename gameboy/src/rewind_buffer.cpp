@@ -0,0 +1,219 @@
+#include "gameboy/rewind_buffer.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+
+#include <spdlog/spdlog.h>
+
+#include "gameboy/gameboy.h"
+
+namespace gameboy {
+
+namespace {
+
+constexpr size_t max_run = std::numeric_limits<uint16_t>::max();
+/** unchanged bytes shorter than a run header are cheaper to store as changed ones */
+constexpr size_t min_gap = sizeof(uint16_t) * 2u;
+
+size_t equal_run(const uint8_t* a, const uint8_t* b, const size_t size) noexcept
+{
+    size_t count = 0u;
+    for(; count + sizeof(uint64_t) <= size; count += sizeof(uint64_t)) {
+        uint64_t word_a;
+        uint64_t word_b;
+        std::memcpy(&word_a, a + count, sizeof(uint64_t));
+        std::memcpy(&word_b, b + count, sizeof(uint64_t));
+        if(word_a != word_b) {
+            break;
+        }
+    }
+
+    while(count < size && a[count] == b[count]) {
+        ++count;
+    }
+
+    return count;
+}
+
+void write_run_header(std::vector<uint8_t>& out, const size_t unchanged, const size_t changed)
+{
+    const std::array<uint16_t, 2> header{static_cast<uint16_t>(unchanged), static_cast<uint16_t>(changed)};
+    const auto offset = out.size();
+    out.resize(offset + sizeof(header));
+    std::memcpy(out.data() + offset, header.data(), sizeof(header));
+}
+
+/** encodes a ^ b as runs of a header with the unchanged and changed byte counts, followed by the changed bytes xored */
+void encode_delta(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b, std::vector<uint8_t>& out)
+{
+    out.clear();
+
+    const auto size = a.size();
+    size_t idx = 0u;
+    while(idx < size) {
+        const auto unchanged = equal_run(a.data() + idx, b.data() + idx, std::min(size - idx, max_run));
+        idx += unchanged;
+
+        size_t changed = 0u;
+        while(idx + changed < size && changed < max_run) {
+            if(a[idx + changed] != b[idx + changed]) {
+                ++changed;
+                continue;
+            }
+
+            const auto remaining = size - idx - changed;
+            const auto gap = equal_run(a.data() + idx + changed, b.data() + idx + changed, std::min(remaining, min_gap));
+            if(gap == min_gap || gap == remaining) {
+                break;
+            }
+
+            changed = std::min(changed + gap, max_run);
+        }
+
+        if(changed == 0u && idx == size) {
+            break;
+        }
+
+        write_run_header(out, unchanged, changed);
+        for(auto i = 0u; i < changed; ++i) {
+            out.push_back(static_cast<uint8_t>(a[idx + i] ^ b[idx + i]));
+        }
+        idx += changed;
+    }
+}
+
+void apply_delta(const uint8_t* delta, const size_t size, std::vector<uint8_t>& target) noexcept
+{
+    size_t in = 0u;
+    size_t out = 0u;
+    while(in < size) {
+        std::array<uint16_t, 2> header{};
+        std::memcpy(header.data(), delta + in, sizeof(header));
+        in += sizeof(header);
+        out += header[0];
+
+        for(auto i = 0u; i < header[1]; ++i) {
+            target[out + i] ^= delta[in + i];
+        }
+        in += header[1];
+        out += header[1];
+    }
+}
+
+} // namespace
+
+rewind_buffer::rewind_buffer(const observer<gameboy> gb)
+    : rewind_buffer{gb, config{}} {}
+
+rewind_buffer::rewind_buffer(const observer<gameboy> gb, const config& cfg)
+    : gb_{gb}
+{
+    set_config(cfg);
+}
+
+void rewind_buffer::set_config(const config& cfg)
+{
+    if(cfg.frame_interval == 0u) {
+        spdlog::critical("rewind: frame interval cannot be zero");
+        std::terminate();
+    }
+
+    config_ = cfg;
+    clear();
+    storage_.assign(config_.memory_budget, 0u);
+}
+
+void rewind_buffer::on_frame()
+{
+    if(++frame_count_ < config_.frame_interval) {
+        return;
+    }
+
+    frame_count_ = 0u;
+    gb_->save_state(state_);
+
+    if(latest_.size() == state_.size()) {
+        encode_delta(state_, latest_, delta_);
+        push(delta_);
+    } else {
+        records_.clear();
+        stored_size_ = 0u;
+    }
+
+    latest_.swap(state_);
+}
+
+bool rewind_buffer::step_back()
+{
+    if(latest_.empty()) {
+        return false;
+    }
+
+    if(!gb_->load_state(latest_)) {
+        clear();
+        return false;
+    }
+
+    frame_count_ = 0u;
+    if(records_.empty()) {
+        latest_.clear();
+        return true;
+    }
+
+    const auto newest = records_.back();
+    apply_delta(storage_.data() + newest.offset, newest.size, latest_);
+    records_.pop_back();
+    stored_size_ -= newest.size;
+    return true;
+}
+
+void rewind_buffer::clear() noexcept
+{
+    frame_count_ = 0u;
+    records_.clear();
+    stored_size_ = 0u;
+    latest_.clear();
+}
+
+size_t rewind_buffer::snapshot_count() const noexcept
+{
+    return records_.size() + (latest_.empty() ? 0u : 1u);
+}
+
+size_t rewind_buffer::memory_used() const noexcept
+{
+    return stored_size_ + latest_.size();
+}
+
+void rewind_buffer::push(const std::vector<uint8_t>& delta)
+{
+    if(delta.size() > storage_.size()) {
+        records_.clear();
+        stored_size_ = 0u;
+        return;
+    }
+
+    const auto head = records_.empty() ? size_t{0u} : records_.back().offset + records_.back().size;
+    const auto wrapped = head + delta.size() > storage_.size();
+    const auto offset = wrapped ? size_t{0u} : head;
+
+    // the oldest records follow the head, they are dropped until the delta fits
+    while(!records_.empty()) {
+        const auto& oldest = records_.front();
+        const auto overlaps = oldest.offset < offset + delta.size() && offset < oldest.offset + oldest.size;
+        if(!overlaps && !(wrapped && oldest.offset >= head)) {
+            break;
+        }
+
+        stored_size_ -= oldest.size;
+        records_.pop_front();
+    }
+
+    std::memcpy(storage_.data() + offset, delta.data(), delta.size());
+    records_.push_back(record{offset, delta.size()});
+    stored_size_ += delta.size();
+}
+
+} // namespace gameboy
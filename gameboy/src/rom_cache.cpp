@@ -0,0 +1,108 @@
+#include "gameboy/rom_cache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <string>
+
+#include "../../3rdparty/parallel-hashmap/parallel_hashmap/phmap.h"
+
+namespace gameboy::rom_cache {
+
+namespace {
+
+/** what the file looked like when it was last read */
+struct file_entry {
+    filesystem::file_time_type write_time;
+    uintmax_t size;
+    uint64_t hash;
+};
+
+struct cache {
+    std::mutex mutex;
+    phmap::flat_hash_map<std::string, file_entry> files;
+    phmap::flat_hash_map<uint64_t, std::weak_ptr<const file_buffer>> roms;
+};
+
+cache& get_cache()
+{
+    static cache instance;
+    return instance;
+}
+
+/** fnv-1a over 8 byte words */
+uint64_t hash_bytes(const byte_view bytes) noexcept
+{
+    constexpr uint64_t prime = 0x100000001B3u;
+    uint64_t hash = 0xCBF29CE484222325u;
+
+    size_t idx = 0u;
+    for(; idx + sizeof(uint64_t) <= bytes.size(); idx += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, bytes.data() + idx, sizeof(uint64_t));
+        hash = (hash ^ word) * prime;
+    }
+
+    for(; idx < bytes.size(); ++idx) {
+        hash = (hash ^ bytes[idx]) * prime;
+    }
+
+    return hash;
+}
+
+} // namespace
+
+std::shared_ptr<const file_buffer> load(const filesystem::path& rom_path)
+{
+    std::error_code path_err;
+    std::error_code time_err;
+    std::error_code size_err;
+    const auto key = filesystem::weakly_canonical(rom_path, path_err).string();
+    const auto write_time = filesystem::last_write_time(rom_path, time_err);
+    const auto size = filesystem::file_size(rom_path, size_err);
+    const auto cacheable = !path_err && !time_err && !size_err;
+
+    auto& c = get_cache();
+    if(cacheable) {
+        std::lock_guard lock{c.mutex};
+        if(const auto file = c.files.find(key); file != c.files.end()) {
+            const auto cached = c.roms.find(file->second.hash);
+            if(cached != c.roms.end()) {
+                if(auto rom = cached->second.lock(); rom && file->second.write_time == write_time && file->second.size == size) {
+                    return rom;
+                }
+
+                // a rom no cartridge holds anymore is dropped as soon as a lookup finds it
+                if(cached->second.expired()) {
+                    c.roms.erase(cached);
+                }
+            }
+
+            c.files.erase(file);
+        }
+    }
+
+    // read_file terminates if the file cannot be read
+    auto bytes = read_file(rom_path);
+    const auto hash = hash_bytes(bytes.view());
+
+    std::lock_guard lock{c.mutex};
+    auto& cached = c.roms[hash];
+    auto rom = cached.lock();
+    if(!rom) {
+        rom = std::make_shared<const file_buffer>(std::move(bytes));
+        cached = rom;
+    } else if(!std::equal(rom->begin(), rom->end(), bytes.begin(), bytes.end())) {
+        // the hashes of two different roms collide, the cached one is kept
+        c.files.erase(key);
+        return std::make_shared<const file_buffer>(std::move(bytes));
+    }
+
+    if(cacheable) {
+        c.files[key] = file_entry{write_time, size, hash};
+    }
+
+    return rom;
+}
+
+} // namespace gameboy::rom_cache
@@ -0,0 +1,79 @@
+#include "gameboy/scheduler.h"
+
+#include <algorithm>
+
+namespace gameboy {
+
+scheduler::scheduler() noexcept
+{
+    reset();
+}
+
+void scheduler::reset() noexcept
+{
+    now_ = 0u;
+    next_deadline_ = no_deadline;
+    deadlines_.fill(no_deadline);
+    event_delegates_.fill(event_func{});
+}
+
+void scheduler::save_state(state_writer& writer) const
+{
+    writer.begin_section(state_section);
+    writer.write(now_);
+    writer.write(deadlines_);
+    writer.end_section();
+}
+
+void scheduler::load_state(state_reader& reader) noexcept
+{
+    if(!reader.begin_section(state_section)) {
+        return;
+    }
+
+    reader.read(now_);
+    reader.read(deadlines_);
+    reader.end_section();
+
+    find_next_deadline();
+}
+
+void scheduler::advance(const uint64_t cycles)
+{
+    now_ += cycles;
+
+    while(next_deadline_ <= now_) {
+        const auto it = std::find(begin(deadlines_), end(deadlines_), next_deadline_);
+        const auto idx = static_cast<size_t>(std::distance(begin(deadlines_), it));
+
+        *it = no_deadline;
+        find_next_deadline();
+
+        // the handler is free to schedule itself again
+        event_delegates_[idx]();
+    }
+}
+
+void scheduler::add_event_delegate(const event e, const event_func on_event) noexcept
+{
+    event_delegates_[static_cast<size_t>(e)] = on_event;
+}
+
+void scheduler::schedule(const event e, const uint64_t cycle) noexcept
+{
+    deadlines_[static_cast<size_t>(e)] = cycle;
+    find_next_deadline();
+}
+
+void scheduler::cancel(const event e) noexcept
+{
+    deadlines_[static_cast<size_t>(e)] = no_deadline;
+    find_next_deadline();
+}
+
+void scheduler::find_next_deadline() noexcept
+{
+    next_deadline_ = *std::min_element(begin(deadlines_), end(deadlines_));
+}
+
+} // namespace gameboy
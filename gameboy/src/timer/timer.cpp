@@ -1,10 +1,12 @@
 #include "gameboy/timer/timer.h"
 
+#include <algorithm>
 #include <array>
 
 #include "gameboy/bus.h"
 #include "gameboy/cpu/cpu.h"
 #include "gameboy/memory/mmu.h"
+#include "gameboy/scheduler.h"
 
 namespace gameboy {
 
@@ -13,6 +15,9 @@ constexpr address16 tima_addr{0xFF05u};
 constexpr address16 tma_addr{0xFF06u};
 constexpr address16 tac_addr{0xFF07u};
 
+/** tima reads 0 for this many clocks after an overflow before tma is loaded */
+constexpr uint8_t tima_reload_delay = 4u;
+
 timer::timer(const observer<bus> bus)
     : bus_{bus}
 {
@@ -21,14 +26,14 @@ timer::timer(const observer<bus> bus)
 
 void timer::reset() noexcept
 {
+    last_sync_cycle_ = 0u;
     internal_clock_ = 0u;
-    tima_reload_cycles_ = 0;
+    tima_reload_cycles_ = 0u;
     timer_clock_overflow_bit_ = 9u;
     tima_ = 0x00u;
     tma_ = 0x00u;
     tac_ = 0x00u;
     enabled_ = false;
-    previous_tima_reload_bit_ = false;
 
     auto mmu = bus_->get_mmu();
 
@@ -38,36 +43,136 @@ void timer::reset() noexcept
             {connect_arg<&timer::on_write>, this},
         });
     }
+
+    bus_->get_scheduler()->add_event_delegate(scheduler::event::timer, {connect_arg<&timer::on_overflow>, this});
+    schedule_overflow();
 }
 
-void timer::tick(const uint8_t cycles)
+void timer::save_state(state_writer& writer) const
 {
-    update_internal_clock(internal_clock_ + cycles);
-    if(tima_reload_cycles_ > 0) {
-        tima_reload_cycles_ -= cycles;
-        if(tima_reload_cycles_ <= 0) {
-            tima_reload_cycles_ = 0;
-            tima_ = tma_;
-            bus_->get_cpu()->request_interrupt(interrupt::timer);
-        }
+    writer.begin_section(state_section);
+    writer.write(last_sync_cycle_);
+    writer.write(internal_clock_);
+    writer.write(tima_reload_cycles_);
+    writer.write(timer_clock_overflow_bit_);
+    writer.write(tima_);
+    writer.write(tma_);
+    writer.write(tac_);
+    writer.write(enabled_);
+    writer.end_section();
+}
+
+void timer::load_state(state_reader& reader) noexcept
+{
+    if(!reader.begin_section(state_section)) {
+        return;
     }
+
+    reader.read(last_sync_cycle_);
+    reader.read(internal_clock_);
+    reader.read(tima_reload_cycles_);
+    reader.read(timer_clock_overflow_bit_);
+    reader.read(tima_);
+    reader.read(tma_);
+    reader.read(tac_);
+    reader.read(enabled_);
+    reader.end_section();
 }
 
-void timer::update_internal_clock(const uint16_t new_internal_clock) noexcept
+void timer::advance(uint64_t cycles) noexcept
 {
-    internal_clock_ = new_internal_clock;
-
-    const auto tima_reload_bit = enabled_ && bit::test(internal_clock_, timer_clock_overflow_bit_);
-    if(!tima_reload_bit && previous_tima_reload_bit_) {
-        tima_ += 1u;
-        if(tima_ == 0x00u) {
-            // actually 4 cycles but the way timer is implemented
-            // requires a number in range (4, 8]
-            tima_reload_cycles_ = 6;
+    // tima is incremented on every falling edge of the selected internal clock bit,
+    // which happens each time the clock passes a multiple of twice the bit's value
+    const auto edge_shift = timer_clock_overflow_bit_ + 1u;
+
+    while(cycles != 0u) {
+        auto step = cycles;
+        if(tima_reload_cycles_ != 0u) {
+            step = std::min<uint64_t>(step, tima_reload_cycles_);
+        }
+
+        auto overflows = false;
+        if(enabled_) {
+            if(const auto overflow_cycles = clocks_until_overflow(); overflow_cycles <= step) {
+                step = overflow_cycles;
+                overflows = true;
+            }
+
+            const auto edges = ((internal_clock_ + step) >> edge_shift) - (internal_clock_ >> edge_shift);
+            tima_ = static_cast<uint8_t>(tima_.value() + edges);
+        }
+
+        internal_clock_ = static_cast<uint16_t>(internal_clock_ + step);
+        cycles -= step;
+
+        if(tima_reload_cycles_ != 0u) {
+            tima_reload_cycles_ -= static_cast<uint8_t>(step);
+            if(tima_reload_cycles_ == 0u) {
+                tima_ = tma_;
+                bus_->get_cpu()->request_interrupt(interrupt::timer);
+            }
+        }
+
+        if(overflows) {
+            tima_reload_cycles_ = tima_reload_delay;
         }
     }
+}
+
+void timer::sync() noexcept
+{
+    const auto now = bus_->get_scheduler()->now();
+    const auto cycles = now - last_sync_cycle_;
+    last_sync_cycle_ = now;
 
-    previous_tima_reload_bit_ = tima_reload_bit;
+    // scheduler counts in single speed cycles, the timer is clocked by the cpu
+    advance(bus_->get_cpu()->is_in_double_speed() ? cycles << 1u : cycles);
+}
+
+void timer::schedule_overflow() noexcept
+{
+    bus_->get_scheduler()->schedule(scheduler::event::timer, next_overflow_cycle());
+}
+
+uint64_t timer::next_overflow_cycle() const noexcept
+{
+    uint64_t clocks;
+    if(tima_reload_cycles_ != 0u) {
+        clocks = tima_reload_cycles_;
+    } else if(enabled_) {
+        clocks = clocks_until_overflow() + tima_reload_delay;
+    } else {
+        return scheduler::no_deadline;
+    }
+
+    const auto cycles = bus_->get_cpu()->is_in_double_speed() ? (clocks + 1u) >> 1u : clocks;
+    return last_sync_cycle_ + cycles;
+}
+
+void timer::on_overflow() noexcept
+{
+    sync();
+    schedule_overflow();
+}
+
+void timer::increment_tima() noexcept
+{
+    tima_ += 1u;
+    if(tima_ == 0x00u) {
+        tima_reload_cycles_ = tima_reload_delay;
+    }
+}
+
+bool timer::timer_clock_bit() const noexcept
+{
+    return enabled_ && bit::test(internal_clock_, timer_clock_overflow_bit_);
+}
+
+uint64_t timer::clocks_until_overflow() const noexcept
+{
+    const uint64_t period = 1u << (timer_clock_overflow_bit_ + 1u);
+    const uint64_t edges_until_overflow = 0x100u - tima_.value();
+    return period - (internal_clock_ & (period - 1u)) + (edges_until_overflow - 1u) * period;
 }
 
 uint8_t timer::timer_clock_overflow_index_select() const noexcept
@@ -82,8 +187,10 @@ uint8_t timer::timer_clock_overflow_index_select() const noexcept
     return frequency_overflow_bit_indices[tac_.value() & 0x03u];
 }
 
-uint8_t timer::on_read(const address16& address) const noexcept
+uint8_t timer::on_read(const address16& address) noexcept
 {
+    sync();
+
     if(address == div_addr) { return internal_clock_ >> 8u; }
     if(address == tima_addr) { return tima_.value(); }
     if(address == tma_addr) { return tma_.value(); }
@@ -94,19 +201,37 @@ uint8_t timer::on_read(const address16& address) const noexcept
 
 void timer::on_write(const address16& address, const uint8_t data) noexcept
 {
-    if(address == div_addr) { update_internal_clock(0u); }
+    sync();
+
+    if(address == div_addr) {
+        // resetting the clock is seen as a falling edge if the selected bit was set
+        if(timer_clock_bit()) {
+            increment_tima();
+        }
+        internal_clock_ = 0u;
+    }
     else if(address == tima_addr) {
-        if(tima_reload_cycles_ < 4) {
-            tima_reload_cycles_ = 0;
+        // a write in the cycle of the overflow is ignored, a later one before the reload cancels it
+        if(tima_reload_cycles_ < tima_reload_delay) {
+            tima_reload_cycles_ = 0u;
             tima_ = data;
         }
     }
     else if(address == tma_addr) { tma_ = data; }
     else if(address == tac_addr) {
+        const auto previous_clock_bit = timer_clock_bit();
+
         tac_ = data | 0xF8u;
         enabled_ = bit::test(tac_, 2u);
         timer_clock_overflow_bit_ = timer_clock_overflow_index_select();
+
+        // so is disabling the timer or selecting a bit which is not set
+        if(previous_clock_bit && !timer_clock_bit()) {
+            increment_tima();
+        }
     }
+
+    schedule_overflow();
 }
 
 } // namespace gameboy
@@ -1,27 +1,144 @@
 #include "gameboy/util/fileutil.h"
 
 #include <fstream>
-#include <iterator>
+#include <utility>
 
 #include <spdlog/spdlog.h>
 
+#if defined(__unix__) || defined(__APPLE__)
+    #define GAMEBOY_MMAP 1
+    #include <cerrno>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
 namespace gameboy {
 
-std::vector<uint8_t> read_file(const filesystem::path& path)
+namespace {
+
+/** smaller files are cheaper to read than to map */
+constexpr size_t min_mapped_size = 64u * 1024u;
+
+[[noreturn]] void terminate_unreadable(const filesystem::path& path)
+{
+    spdlog::critical("file could not be read: {}", path.string());
+    std::terminate();
+}
+
+} // namespace
+
+file_buffer::file_buffer(const filesystem::path& path)
 {
+#if GAMEBOY_MMAP
+    const auto fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0) {
+        spdlog::critical("stream could not be opened: {}", path.string());
+        std::terminate();
+    }
+
+    struct stat file_stat{};
+    const auto file_size = ::fstat(fd, &file_stat) == 0 && S_ISREG(file_stat.st_mode)
+      ? static_cast<size_t>(file_stat.st_size)
+      : size_t{0u};
+
+    if(file_size >= min_mapped_size) {
+        if(auto* mapping = ::mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0); mapping != MAP_FAILED) {
+            ::close(fd);
+            data_ = static_cast<const uint8_t*>(mapping);
+            size_ = file_size;
+            mapped_ = true;
+            return;
+        }
+    }
+
+    bytes_.resize(file_size);
+    size_t read_size = 0u;
+    while(read_size < bytes_.size()) {
+        const auto result = ::read(fd, bytes_.data() + read_size, bytes_.size() - read_size);
+        if(result == 0) {
+            break;
+        }
+
+        if(result < 0) {
+            if(errno == EINTR) {
+                continue;
+            }
+
+            ::close(fd);
+            terminate_unreadable(path);
+        }
+
+        read_size += static_cast<size_t>(result);
+    }
+
+    ::close(fd);
+    bytes_.resize(read_size);
+#else
     std::ifstream stream{path, std::ios::binary | std::ios::in};
-    stream.unsetf(std::ios::skipws);
     if(!stream.is_open()) {
         spdlog::critical("stream could not be opened: {}", path.string());
         std::terminate();
     }
 
-    std::vector<uint8_t> bytes{
-        std::istream_iterator<uint8_t>{stream},
-        std::istream_iterator<uint8_t>{}
-    };
+    std::error_code err;
+    const auto file_size = filesystem::file_size(path, err);
+    if(err) {
+        terminate_unreadable(path);
+    }
+
+    bytes_.resize(static_cast<size_t>(file_size));
+    if(!stream.read(reinterpret_cast<char*>(bytes_.data()), static_cast<std::streamsize>(bytes_.size()))) {
+        terminate_unreadable(path);
+    }
+#endif //GAMEBOY_MMAP
+
+    data_ = bytes_.data();
+    size_ = bytes_.size();
+}
+
+file_buffer::~file_buffer()
+{
+    release();
+}
+
+file_buffer::file_buffer(file_buffer&& other) noexcept
+    : data_{std::exchange(other.data_, nullptr)},
+      size_{std::exchange(other.size_, 0u)},
+      mapped_{std::exchange(other.mapped_, false)},
+      bytes_{std::move(other.bytes_)} {}
+
+file_buffer& file_buffer::operator=(file_buffer&& other) noexcept
+{
+    if(this != &other) {
+        release();
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0u);
+        mapped_ = std::exchange(other.mapped_, false);
+        bytes_ = std::move(other.bytes_);
+    }
+
+    return *this;
+}
+
+void file_buffer::release() noexcept
+{
+#if GAMEBOY_MMAP
+    if(mapped_) {
+        ::munmap(const_cast<uint8_t*>(data_), size_);
+    }
+#endif //GAMEBOY_MMAP
 
-    return bytes;
+    data_ = nullptr;
+    size_ = 0u;
+    mapped_ = false;
+    bytes_.clear();
+}
+
+file_buffer read_file(const filesystem::path& path)
+{
+    return file_buffer{path};
 }
 
 void write_file(const filesystem::path& path, const std::vector<uint8_t>& data)
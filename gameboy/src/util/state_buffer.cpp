@@ -0,0 +1,67 @@
+#include "gameboy/util/state_buffer.h"
+
+namespace gameboy {
+
+void state_writer::begin_section(const state_tag tag)
+{
+    write(tag);
+    section_offset_ = buffer_.size();
+    write(uint32_t{0u});
+}
+
+void state_writer::end_section() noexcept
+{
+    const auto size = static_cast<uint32_t>(buffer_.size() - section_offset_ - sizeof(uint32_t));
+    std::memcpy(buffer_.data() + section_offset_, &size, sizeof(size));
+}
+
+bool state_reader::begin_section(const state_tag tag) noexcept
+{
+    state_tag section_tag = 0u;
+    uint32_t section_size = 0u;
+    if(!read_section_header(section_tag, section_size) || section_tag != tag) {
+        ok_ = false;
+        return false;
+    }
+
+    section_end_ = offset_ + section_size;
+    return true;
+}
+
+bool state_reader::end_section() noexcept
+{
+    if(offset_ != section_end_) {
+        ok_ = false;
+    }
+
+    section_end_ = size_;
+    return ok_;
+}
+
+bool state_reader::skip_section(const state_tag tag) noexcept
+{
+    state_tag section_tag = 0u;
+    uint32_t section_size = 0u;
+    if(!read_section_header(section_tag, section_size) || section_tag != tag) {
+        ok_ = false;
+        return false;
+    }
+
+    offset_ += section_size;
+    return true;
+}
+
+bool state_reader::read_section_header(state_tag& tag, uint32_t& size) noexcept
+{
+    section_end_ = size_;
+    read(tag);
+    read(size);
+
+    if(!ok_ || size_ - offset_ < size) {
+        ok_ = false;
+    }
+
+    return ok_;
+}
+
+} // namespace gameboy
@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "gameboy/apu/band_limited_buffer.h"
+
+namespace {
+
+constexpr auto clock_rate = 4'194'304u;
+
+} // namespace
+
+TEST(band_limited_buffer, clocks_needed) {
+    gameboy::audio::band_limited_buffer buffer;
+    buffer.set_rates(clock_rate, 44'100u, 2048u);
+
+    const auto clocks = buffer.clocks_needed(2048u);
+    ASSERT_EQ(clocks, 194'784u);
+
+    buffer.end_frame(clocks);
+    ASSERT_EQ(buffer.samples_available(), 2048u);
+    ASSERT_EQ(buffer.clocks_needed(2048u), 0u);
+}
+
+TEST(band_limited_buffer, step_settles_to_amplitude) {
+    gameboy::audio::band_limited_buffer buffer;
+    buffer.set_rates(clock_rate, 48'000u, 256u);
+
+    buffer.add_delta(1'000u, 12'000);
+    buffer.add_delta(10'001u, -2'000);
+    buffer.end_frame(buffer.clocks_needed(256u));
+
+    std::vector<int16_t> samples(256u);
+    buffer.read_samples(samples.data(), 256u, 1u);
+
+    ASSERT_EQ(samples.front(), 0);
+    ASSERT_EQ(samples[100], 12'000);
+    ASSERT_EQ(samples.back(), 10'000);
+}
+
+TEST(band_limited_buffer, tails_carry_over_frames) {
+    gameboy::audio::band_limited_buffer buffer;
+    buffer.set_rates(clock_rate, 32'000u, 64u);
+
+    // the step lands at the very end of the frame and is heard in the next one
+    const auto clocks = buffer.clocks_needed(64u);
+    buffer.add_delta(clocks, 5'000);
+    buffer.end_frame(clocks);
+
+    std::vector<int16_t> samples(64u);
+    buffer.read_samples(samples.data(), 64u, 1u);
+    ASSERT_EQ(samples.back(), 0);
+
+    buffer.end_frame(buffer.clocks_needed(64u));
+    buffer.read_samples(samples.data(), 64u, 1u);
+    ASSERT_EQ(samples.back(), 5'000);
+}
+
+TEST(band_limited_buffer, keeps_steps_past_the_end) {
+    gameboy::audio::band_limited_buffer buffer;
+    buffer.set_rates(clock_rate, 32'000u, 64u);
+
+    // the buffer is not read when it fills up, a step two frames later must not be lost
+    const auto clocks = buffer.clocks_needed(64u);
+    buffer.add_delta(clocks * 2u, 3'000);
+    buffer.end_frame(clocks * 3u);
+
+    std::vector<int16_t> samples(64u);
+    for(auto i = 0u; i < 3u; ++i) {
+        buffer.read_samples(samples.data(), 64u, 1u);
+    }
+    ASSERT_EQ(samples.back(), 3'000);
+}
@@ -0,0 +1,38 @@
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "gameboy/util/fileutil.h"
+#include "rom_tester_env.h"
+
+using namespace gameboy;
+
+namespace {
+
+std::vector<uint8_t> read_with_stream(const filesystem::path& path)
+{
+    std::ifstream stream{path, std::ios::binary | std::ios::in};
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>{stream}, std::istreambuf_iterator<char>{});
+}
+
+} // namespace
+
+TEST(fileutil, read_file_reads_whole_file) {
+    // large enough to be mapped where the platform supports it, and small enough to be read
+    for(const auto* rom_name : {"cpu_instrs.gb", "instr_timing.gb"}) {
+        const auto path = rom_tester_env::get_base_path().append(rom_name);
+        const auto expected = read_with_stream(path);
+
+        const auto file = read_file(path);
+        ASSERT_EQ(std::vector<uint8_t>(file.begin(), file.end()), expected);
+
+        auto moved = read_file(path);
+        const auto data = moved.data();
+        const file_buffer other{std::move(moved)};
+        ASSERT_EQ(other.data(), data);
+        ASSERT_TRUE(moved.empty());
+        ASSERT_EQ(std::vector<uint8_t>(other.begin(), other.end()), expected);
+    }
+}
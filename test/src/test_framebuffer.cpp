@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+#include "gameboy/ppu/framebuffer.h"
+
+using namespace gameboy;
+
+namespace {
+
+std::array<uint8_t, framebuffer::width> make_line(const uint8_t color_table_index)
+{
+    std::array<uint8_t, framebuffer::width> indices{};
+    indices.fill(color_table_index);
+    return indices;
+}
+
+} // namespace
+
+TEST(framebuffer, converts_colors) {
+    framebuffer buffer{pixel_format::rgba8888};
+    buffer.set_color(3u, color{0xF8u, 0xFCu, 0x08u});
+
+    buffer.write_line(10u, make_line(3u));
+    buffer.swap();
+
+    const auto rgba = buffer.front();
+    ASSERT_EQ(rgba.size(), framebuffer::width * framebuffer::height * 4u);
+    ASSERT_EQ(rgba.line(10u)[159u * 4u + 0u], 0xF8u);
+    ASSERT_EQ(rgba.line(10u)[159u * 4u + 1u], 0xFCu);
+    ASSERT_EQ(rgba.line(10u)[159u * 4u + 2u], 0x08u);
+    ASSERT_EQ(rgba.line(10u)[159u * 4u + 3u], 0xFFu);
+
+    buffer.set_format(pixel_format::rgb565);
+    buffer.write_line(0u, make_line(3u));
+    buffer.swap();
+
+    uint16_t rgb565 = 0u;
+    std::memcpy(&rgb565, buffer.front().data(), sizeof(rgb565));
+    ASSERT_EQ(rgb565, (0x1Fu << 11u) | (0x3Fu << 5u) | 0x01u);
+
+    buffer.set_format(pixel_format::index);
+    buffer.write_line(143u, make_line(3u));
+    buffer.swap();
+    ASSERT_EQ(buffer.front().line(143u)[0], 3u);
+}
+
+TEST(framebuffer, maps_indices) {
+    framebuffer buffer{pixel_format::index};
+    buffer.set_index(line_compositor::obj_color_offset + 1u, 2u);
+
+    auto line = make_line(line_compositor::obj_color_offset + 1u);
+    line[0] = 7u;
+    buffer.write_line(0u, line);
+    buffer.swap();
+
+    ASSERT_EQ(buffer.front().data()[0], 7u);
+    ASSERT_EQ(buffer.front().data()[1], 2u);
+}
+
+TEST(framebuffer, front_is_the_completed_frame) {
+    framebuffer buffer{pixel_format::index};
+
+    buffer.write_line(0u, make_line(1u));
+    ASSERT_EQ(buffer.front().data()[0], 0u);
+
+    buffer.swap();
+    buffer.write_line(0u, make_line(2u));
+    ASSERT_EQ(buffer.front().data()[0], 1u);
+
+    buffer.swap();
+    ASSERT_EQ(buffer.front().data()[0], 2u);
+}
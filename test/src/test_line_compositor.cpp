@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "gameboy/ppu/line_compositor.h"
+
+using namespace gameboy;
+
+namespace {
+
+line_buffer make_random_line(std::mt19937& rng)
+{
+    std::uniform_int_distribution<uint32_t> dist{0u, 255u};
+
+    line_buffer buffer;
+    for(auto x = 0u; x < line_buffer::width; ++x) {
+        buffer.bg_color_indices[x] = dist(rng) & 0x3u;
+        buffer.bg_palettes[x] = dist(rng) & 0x7u;
+        buffer.bg_flags[x] = dist(rng) & (line_buffer::bg_flag_present | line_buffer::bg_flag_prioritized);
+        buffer.obj_color_indices[x] = dist(rng) & 0x3u;
+        buffer.obj_palettes[x] = dist(rng) & 0x7u;
+        buffer.obj_flags[x] = dist(rng) & line_buffer::obj_flag_prioritized;
+    }
+
+    return buffer;
+}
+
+} // namespace
+
+TEST(line_compositor, scalar_priorities) {
+    const auto composite = line_compositor::get_kernel(line_compositor::instruction_set::scalar);
+
+    line_buffer buffer;
+    buffer.clear();
+
+    // 0: nothing drawn, 1: bg only, 2: obj over bg color 0, 3: obj behind opaque prioritized bg, 4: obj over opaque bg
+    for(auto x = 1u; x < 5u; ++x) {
+        buffer.bg_color_indices[x] = x == 2u ? 0u : 3u;
+        buffer.bg_palettes[x] = 5u;
+        buffer.bg_flags[x] = line_buffer::bg_flag_present | (x == 3u ? line_buffer::bg_flag_prioritized : 0u);
+    }
+    for(auto x = 2u; x < 5u; ++x) {
+        buffer.obj_color_indices[x] = 1u;
+        buffer.obj_palettes[x] = 2u;
+        buffer.obj_flags[x] = line_buffer::obj_flag_prioritized;
+    }
+
+    std::array<uint8_t, line_buffer::width> indices{};
+    composite(buffer, false, indices.data());
+
+    ASSERT_EQ(indices[0], line_compositor::blank_color_index);
+    ASSERT_EQ(indices[1], 5u * 4u + 3u);
+    ASSERT_EQ(indices[2], line_compositor::obj_color_offset + 2u * 4u + 1u);
+    ASSERT_EQ(indices[3], 5u * 4u + 3u);
+    ASSERT_EQ(indices[4], line_compositor::obj_color_offset + 2u * 4u + 1u);
+
+    composite(buffer, true, indices.data());
+    ASSERT_EQ(indices[3], line_compositor::obj_color_offset + 2u * 4u + 1u);
+}
+
+TEST(line_compositor, kernels_match_scalar) {
+    using line_compositor::instruction_set;
+
+    const auto scalar = line_compositor::get_kernel(instruction_set::scalar);
+    std::mt19937 rng{0x6B1u};
+
+    for(const auto set : {instruction_set::sse2, instruction_set::avx2, instruction_set::neon}) {
+        const auto kernel = line_compositor::get_kernel(set);
+        if(!kernel) {
+            continue;
+        }
+
+        for(auto i = 0; i < 256; ++i) {
+            const auto buffer = make_random_line(rng);
+            const auto master_priority = (i & 1) != 0;
+
+            std::array<uint8_t, line_buffer::width> expected{};
+            std::array<uint8_t, line_buffer::width> actual{};
+            scalar(buffer, master_priority, expected.data());
+            kernel(buffer, master_priority, actual.data());
+
+            ASSERT_EQ(expected, actual);
+        }
+    }
+}
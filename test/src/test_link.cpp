@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+
+#include "gameboy/gameboy.h"
+#include "rom_tester_env.h"
+
+using namespace gameboy;
+
+namespace {
+
+constexpr address16 sb_addr{0xFF01u};
+constexpr address16 sc_addr{0xFF02u};
+constexpr address16 if_addr{0xFF0Fu};
+constexpr uint8_t serial_interrupt = 0x08u;
+
+void on_vblank() noexcept {}
+
+struct serial_log {
+    uint8_t sent = 0x00u;
+    uint32_t transfer_count = 0u;
+
+    uint8_t on_transfer(const uint8_t data)
+    {
+        sent = data;
+        ++transfer_count;
+        return 0xA5u;
+    }
+};
+
+/** starts a transfer with the internal clock and advances the scheduler without executing instructions */
+void check_transfer_length(const uint8_t sc, const uint64_t transfer_cycles)
+{
+    gameboy::gameboy gb{rom_tester_env::get_base_path().append("cpu_instrs.gb")};
+    gb.on_vblank({connect_arg<&on_vblank>});
+
+    serial_log log;
+    gb.on_link_transfer_master({connect_arg<&serial_log::on_transfer>, &log});
+
+    auto mmu = gb.get_bus()->get_mmu();
+    auto scheduler = gb.get_bus()->get_scheduler();
+    mmu->write(if_addr, 0x00u);
+    mmu->write(sb_addr, 0x42u);
+    mmu->write(sc_addr, sc);
+
+    // a single advance covers all eight bits, the transfer still ends after exactly eight periods
+    scheduler->advance(transfer_cycles - 1u);
+    ASSERT_EQ(log.transfer_count, 0u);
+    ASSERT_EQ(mmu->read(if_addr) & serial_interrupt, 0u);
+    ASSERT_NE(mmu->read(sc_addr) & 0x80u, 0u);
+
+    scheduler->advance(1u);
+    ASSERT_EQ(log.transfer_count, 1u);
+    ASSERT_EQ(log.sent, 0x42u);
+    ASSERT_EQ(mmu->read(sb_addr), 0xA5u);
+    ASSERT_NE(mmu->read(if_addr) & serial_interrupt, 0u);
+    ASSERT_EQ(mmu->read(sc_addr) & 0x80u, 0u);
+}
+
+} // namespace
+
+TEST(link, serial_interrupt_after_eight_periods) {
+    check_transfer_length(0x81u, 8u * 512u);
+}
+
+TEST(link, serial_interrupt_after_eight_fast_periods) {
+    check_transfer_length(0x83u, 8u * 16u);
+}
@@ -0,0 +1,322 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <vector>
+
+#include "gameboy/gameboy.h"
+#include "rom_tester_env.h"
+
+using namespace gameboy;
+
+namespace {
+
+constexpr address16 lcdc_addr{0xFF40u};
+constexpr address16 stat_addr{0xFF41u};
+constexpr address16 scx_addr{0xFF43u};
+constexpr address16 ly_addr{0xFF44u};
+constexpr address16 bgp_addr{0xFF47u};
+constexpr address16 obp_0_addr{0xFF48u};
+constexpr address16 wy_addr{0xFF4Au};
+constexpr address16 wx_addr{0xFF4Bu};
+constexpr address16 bgpi_addr{0xFF68u};
+constexpr address16 bgpd_addr{0xFF69u};
+constexpr uint16_t tile_data_addr = 0x8000u;
+constexpr uint16_t map_addr = 0x9800u;
+constexpr uint16_t window_map_addr = 0x9C00u;
+constexpr uint16_t oam_addr = 0xFE00u;
+constexpr uint8_t map_width = 32u;
+
+void on_vblank() noexcept {}
+
+/** advances the scheduler without executing instructions until vram can be written on the line */
+void advance_to_line(gameboy::gameboy& gb, const uint8_t line)
+{
+    auto mmu = gb.get_bus()->get_mmu();
+    auto scheduler = gb.get_bus()->get_scheduler();
+    while(mmu->read(ly_addr) != line || (mmu->read(stat_addr) & 0x03u) == 0x03u) {
+        scheduler->advance(1u);
+    }
+}
+
+/** cycles until ly reads the line, advancing the scheduler one cycle at a time */
+uint32_t cycles_until_line(gameboy::gameboy& gb, const uint8_t line)
+{
+    auto mmu = gb.get_bus()->get_mmu();
+    auto scheduler = gb.get_bus()->get_scheduler();
+
+    uint32_t cycles = 0u;
+    for(; mmu->read(ly_addr) != line; ++cycles) {
+        scheduler->advance(1u);
+    }
+    return cycles;
+}
+
+/** turns the lcd off and on again, then lets the given cycles pass in a single sync */
+uint32_t enable_lcd_across(const uint64_t span)
+{
+    gameboy::gameboy gb{rom_tester_env::get_base_path().append("cpu_instrs.gb")};
+    gb.on_vblank({connect_arg<&on_vblank>});
+
+    auto mmu = gb.get_bus()->get_mmu();
+    mmu->write(lcdc_addr, 0x11u);
+    mmu->write(lcdc_addr, 0x91u);
+    gb.get_bus()->get_scheduler()->advance(span);
+
+    return cycles_until_line(gb, 1u);
+}
+
+void write_tile(gameboy::gameboy& gb, const uint8_t tile_no, const uint8_t low, const uint8_t high)
+{
+    auto mmu = gb.get_bus()->get_mmu();
+    for(uint8_t row = 0u; row < 8u; ++row) {
+        const auto address = static_cast<uint16_t>(tile_data_addr + tile_no * 16u + row * 2u);
+        mmu->write(make_address(address), static_cast<uint8_t>(low ^ row));
+        mmu->write(make_address(static_cast<uint16_t>(address + 1u)), high);
+    }
+}
+
+void write_map_rows(gameboy::gameboy& gb, const uint8_t first_row, const uint8_t last_row, const uint8_t tile_no)
+{
+    auto mmu = gb.get_bus()->get_mmu();
+    for(uint8_t row = first_row; row < last_row; ++row) {
+        for(uint8_t x = 0u; x < map_width; x += 3u) {
+            mmu->write(make_address(static_cast<uint16_t>(map_addr + row * map_width + x)), tile_no);
+        }
+    }
+}
+
+/** draws one frame with tile data and then map entries changing in the middle of it */
+std::vector<uint8_t> draw_changing_frame(const bool rebuild_map_layers)
+{
+    gameboy::gameboy gb{rom_tester_env::get_base_path().append("cpu_instrs.gb")};
+    gb.on_vblank({connect_arg<&on_vblank>});
+
+    // the state is reloaded after every change, which rebuilds the map layers from vram
+    const auto changed = [&]() {
+        if(rebuild_map_layers) {
+            std::vector<uint8_t> state;
+            gb.save_state(state);
+            ASSERT_TRUE(gb.load_state(state));
+        }
+    };
+
+    advance_to_line(gb, 150u);
+
+    // the cgb palettes reset to a single color, every color index gets its own one
+    auto mmu = gb.get_bus()->get_mmu();
+    mmu->write(bgpi_addr, 0x80u);
+    for(const auto data : std::array<uint8_t, 8>{0xFFu, 0x7Fu, 0x18u, 0x63u, 0xE0u, 0x03u, 0x00u, 0x00u}) {
+        mmu->write(bgpd_addr, data);
+    }
+
+    for(uint8_t tile_no = 0u; tile_no < 4u; ++tile_no) {
+        write_tile(gb, tile_no, static_cast<uint8_t>(0x0Fu << tile_no), static_cast<uint8_t>(0x33u * tile_no));
+    }
+    for(uint8_t row = 0u; row < map_width; ++row) {
+        write_map_rows(gb, row, static_cast<uint8_t>(row + 1u), static_cast<uint8_t>(row % 3u));
+    }
+    changed();
+
+    // a whole frame caches every visible row of the map
+    advance_to_line(gb, 100u);
+    advance_to_line(gb, 150u);
+    advance_to_line(gb, 40u);
+    write_tile(gb, 2u, 0xA5u, 0x5Au);
+    changed();
+
+    advance_to_line(gb, 80u);
+    write_map_rows(gb, 12u, 16u, 3u);
+    changed();
+
+    advance_to_line(gb, 150u);
+    const auto frame = gb.frame();
+    return std::vector<uint8_t>(frame.begin(), frame.end());
+}
+
+/** a register write made the given number of dots after the line entered mode 2 */
+struct line_write {
+    uint32_t dot;
+    address16 address;
+    uint8_t data;
+};
+
+struct drawn_line {
+    /** dots from the start of the line until mode 3 ends */
+    uint32_t mode3_end = 0u;
+    std::vector<uint8_t> pixels;
+};
+
+struct line_recorder {
+    uint8_t line = 0u;
+    std::vector<uint8_t> pixels;
+
+    void on_render_line(const uint8_t line_number, const render_line& colors)
+    {
+        if(line_number != line) {
+            return;
+        }
+
+        pixels.clear();
+        for(const auto& c : colors) {
+            pixels.insert(pixels.end(), {c.red, c.green, c.blue});
+        }
+    }
+};
+
+constexpr uint8_t drawn_line_number = 20u;
+constexpr uint32_t mode3_start = 80u;
+
+/**
+ * draws a dmg line with distinct tiles in every column, a window map of its own and an object tile,
+ * the setup is written during the vblank before the frame and the program while the line is drawn
+ */
+drawn_line draw_line(const ppu::renderer renderer, const std::vector<line_write>& setup, const std::vector<line_write>& program)
+{
+    gameboy::gameboy gb{rom_tester_env::get_base_path().append("dmg_sound.gb")};
+    gb.on_vblank({connect_arg<&on_vblank>});
+    gb.set_renderer(renderer);
+
+    line_recorder recorder{drawn_line_number, {}};
+    gb.on_render_line({connect_arg<&line_recorder::on_render_line>, &recorder});
+
+    advance_to_line(gb, 150u);
+    for(uint8_t tile_no = 0u; tile_no < 6u; ++tile_no) {
+        write_tile(gb, tile_no, static_cast<uint8_t>(0x1Du * (tile_no + 1u)), static_cast<uint8_t>(0x6Bu ^ (tile_no << 4u)));
+    }
+
+    auto mmu = gb.get_bus()->get_mmu();
+    for(uint8_t row = 0u; row < map_width; ++row) {
+        for(uint8_t x = 0u; x < map_width; ++x) {
+            mmu->write(make_address(static_cast<uint16_t>(map_addr + row * map_width + x)), static_cast<uint8_t>(x % 4u));
+            mmu->write(make_address(static_cast<uint16_t>(window_map_addr + row * map_width + x)), uint8_t{4u});
+        }
+    }
+
+    mmu->write(bgp_addr, 0xE4u);
+    mmu->write(obp_0_addr, 0x1Bu);
+    mmu->write(lcdc_addr, 0x93u);
+    for(const auto& write : setup) {
+        mmu->write(write.address, write.data);
+    }
+
+    auto scheduler = gb.get_bus()->get_scheduler();
+    const auto mode = [&]() { return mmu->read(stat_addr) & 0x03u; };
+    while(mmu->read(ly_addr) != drawn_line_number - 1u || mode() != 0u) {
+        scheduler->advance(1u);
+    }
+    while(mode() != 2u) {
+        scheduler->advance(1u);
+    }
+
+    drawn_line result;
+    const auto line_start = scheduler->now();
+    for(auto last_mode = mode(); result.mode3_end == 0u; scheduler->advance(1u)) {
+        const auto dot = static_cast<uint32_t>(scheduler->now() - line_start);
+        for(const auto& write : program) {
+            if(write.dot == dot) {
+                mmu->write(write.address, write.data);
+            }
+        }
+
+        const auto current_mode = mode();
+        if(last_mode == 3u && current_mode == 0u) {
+            result.mode3_end = dot;
+        }
+        last_mode = current_mode;
+    }
+
+    result.pixels = recorder.pixels;
+    return result;
+}
+
+std::vector<uint8_t> pixels_of(const drawn_line& line, const size_t first_x, const size_t last_x)
+{
+    return std::vector<uint8_t>(line.pixels.begin() + static_cast<std::ptrdiff_t>(first_x * 3u),
+        line.pixels.begin() + static_cast<std::ptrdiff_t>(last_x * 3u));
+}
+
+std::vector<line_write> setup_obj(const uint8_t x)
+{
+    // the first row of the object is on the drawn line
+    return {
+        {0u, make_address(oam_addr), static_cast<uint8_t>(drawn_line_number + 16u)},
+        {0u, make_address(static_cast<uint16_t>(oam_addr + 1u)), x},
+        {0u, make_address(static_cast<uint16_t>(oam_addr + 2u)), 5u}
+    };
+}
+
+} // namespace
+
+TEST(ppu, map_layers_follow_vram_writes) {
+    ASSERT_EQ(draw_changing_frame(false), draw_changing_frame(true));
+}
+
+TEST(ppu, lcd_enable_delay_ends_within_a_long_sync) {
+    // the delay is 244 cycles, the long span is more than an int16_t counter can take
+    ASSERT_EQ(enable_lcd_across(65'636u), enable_lcd_across(300u));
+}
+
+TEST(ppu, renderers_agree_on_lines_without_mid_line_writes) {
+    struct line_case {
+        std::vector<line_write> setup;
+        uint32_t fifo_mode3_cycles;
+    };
+
+    const std::vector<line_case> cases{
+        {{}, 172u},
+        // the fifo discards the pixels scrolled out of the first tile
+        {{{0u, scx_addr, 3u}}, 175u},
+        // the window restarts the background fetch from x 80
+        {{{0u, lcdc_addr, 0xF3u}, {0u, wy_addr, 0u}, {0u, wx_addr, 87u}}, 178u},
+        // an object fetch takes 6 dots once the background fetcher finishes its tile
+        {setup_obj(48u), 179u},
+        {setup_obj(51u), 182u},
+    };
+
+    const auto plain = draw_line(ppu::renderer::scanline, {}, {});
+    for(const auto& [setup, fifo_mode3_cycles] : cases) {
+        const auto scanline = draw_line(ppu::renderer::scanline, setup, {});
+        const auto fifo = draw_line(ppu::renderer::pixel_fifo, setup, {});
+
+        ASSERT_EQ(scanline.mode3_end, mode3_start + 172u);
+        ASSERT_EQ(fifo.mode3_end, mode3_start + fifo_mode3_cycles);
+        ASSERT_EQ(fifo.pixels.size(), screen_width * 3u);
+        ASSERT_EQ(fifo.pixels, scanline.pixels);
+        if(!setup.empty()) {
+            ASSERT_NE(fifo.pixels, plain.pixels);
+        }
+    }
+}
+
+TEST(ppu, pixel_fifo_applies_mid_line_writes) {
+    // 48 pixels are out when mode 3 is 60 dots in, the first 12 dots fill the fifo
+    constexpr uint32_t write_dot = mode3_start + 60u;
+    constexpr size_t drawn_pixels = 48u;
+
+    const auto old_line = draw_line(ppu::renderer::pixel_fifo, {}, {});
+
+    const std::vector<line_write> palette_program{{write_dot, bgp_addr, 0x1Bu}};
+    const auto new_palette_line = draw_line(ppu::renderer::pixel_fifo, palette_program, {});
+    ASSERT_NE(new_palette_line.pixels, old_line.pixels);
+    const auto palette_fifo = draw_line(ppu::renderer::pixel_fifo, {}, palette_program);
+    ASSERT_EQ(palette_fifo.mode3_end, mode3_start + 172u);
+    ASSERT_EQ(pixels_of(palette_fifo, 0u, drawn_pixels), pixels_of(old_line, 0u, drawn_pixels));
+    ASSERT_EQ(pixels_of(palette_fifo, drawn_pixels, screen_width), pixels_of(new_palette_line, drawn_pixels, screen_width));
+
+    // the scanline renderer draws the line at once after the write
+    const auto palette_scanline = draw_line(ppu::renderer::scanline, {}, palette_program);
+    ASSERT_EQ(palette_scanline.mode3_end, mode3_start + 172u);
+    ASSERT_EQ(palette_scanline.pixels, new_palette_line.pixels);
+
+    // the tile in the fifo keeps the old scroll, the fetcher reads the next tile number with the new one
+    const std::vector<line_write> scroll_program{{write_dot, scx_addr, 8u}};
+    const auto new_scroll_line = draw_line(ppu::renderer::pixel_fifo, scroll_program, {});
+    const auto scroll_fifo = draw_line(ppu::renderer::pixel_fifo, {}, scroll_program);
+    ASSERT_EQ(scroll_fifo.mode3_end, mode3_start + 172u);
+    ASSERT_EQ(pixels_of(scroll_fifo, 0u, drawn_pixels + 8u), pixels_of(old_line, 0u, drawn_pixels + 8u));
+    ASSERT_EQ(pixels_of(scroll_fifo, drawn_pixels + 8u, screen_width), pixels_of(new_scroll_line, drawn_pixels + 8u, screen_width));
+    ASSERT_NE(new_scroll_line.pixels, old_line.pixels);
+
+    const auto scroll_scanline = draw_line(ppu::renderer::scanline, {}, scroll_program);
+    ASSERT_EQ(scroll_scanline.pixels, new_scroll_line.pixels);
+}
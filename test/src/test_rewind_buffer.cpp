@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "gameboy/gameboy.h"
+#include "gameboy/rewind_buffer.h"
+#include "rom_tester_env.h"
+
+using namespace gameboy;
+
+namespace {
+
+void on_vblank() noexcept {}
+
+/** the frame with wram, which also changes when the frame does not */
+std::vector<uint8_t> run_frame(gameboy::gameboy& gb)
+{
+    gb.tick_one_frame();
+
+    const auto frame = gb.frame();
+    std::vector<uint8_t> output(frame.begin(), frame.end());
+
+    auto mmu = gb.get_bus()->get_mmu();
+    for(uint16_t address = 0xC000u; address < 0xE000u; ++address) {
+        output.push_back(mmu->read(make_address(address)));
+    }
+
+    return output;
+}
+
+/** runs frames taking a snapshot before each, then steps back through all snapshots */
+void check_steps_back(const rewind_buffer::config& cfg, const size_t frame_count)
+{
+    gameboy::gameboy gb{rom_tester_env::get_base_path().append("cpu_instrs.gb")};
+    gb.on_vblank({connect_arg<&on_vblank>});
+    for(auto i = 0u; i < 60u; ++i) {
+        gb.tick_one_frame();
+    }
+
+    rewind_buffer rewind{make_observer(gb), cfg};
+
+    std::vector<std::vector<uint8_t>> outputs;
+    for(size_t i = 0u; i < frame_count; ++i) {
+        rewind.on_frame();
+        outputs.push_back(run_frame(gb));
+    }
+
+    ASSERT_LE(rewind.memory_used(), cfg.memory_budget + 64_kb);
+
+    const auto snapshot_count = rewind.snapshot_count();
+    ASSERT_GT(snapshot_count, 0u);
+    ASSERT_LE(snapshot_count, frame_count);
+
+    for(size_t i = 0u; i < snapshot_count; ++i) {
+        ASSERT_TRUE(rewind.step_back());
+        ASSERT_EQ(run_frame(gb), outputs[frame_count - 1u - i]);
+    }
+
+    ASSERT_FALSE(rewind.step_back());
+}
+
+} // namespace
+
+TEST(rewind_buffer, steps_back_through_all_snapshots) {
+    check_steps_back(rewind_buffer::config{1024_kb, 1u}, 120u);
+}
+
+TEST(rewind_buffer, drops_oldest_snapshots_over_budget) {
+    check_steps_back(rewind_buffer::config{8_kb, 1u}, 120u);
+}
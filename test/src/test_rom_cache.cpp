@@ -0,0 +1,31 @@
+#include <gtest/gtest.h>
+
+#include "gameboy/cartridge.h"
+#include "gameboy/rom_cache.h"
+#include "rom_tester_env.h"
+
+using namespace gameboy;
+
+TEST(rom_cache, shares_roms_between_cartridges) {
+    const auto rom_path = rom_tester_env::get_base_path().append("cpu_instrs.gb");
+    const cartridge first{rom_path};
+    const cartridge second{rom_path};
+    ASSERT_EQ(first.rom().data(), second.rom().data());
+
+    const cartridge other{rom_tester_env::get_base_path().append("instr_timing.gb")};
+    ASSERT_NE(first.rom().data(), other.rom().data());
+}
+
+TEST(rom_cache, drops_roms_no_one_holds) {
+    const auto rom_path = rom_tester_env::get_base_path().append("instr_timing.gb");
+    auto rom = rom_cache::load(rom_path);
+    ASSERT_EQ(rom_cache::load(rom_path), rom);
+
+    const std::vector<uint8_t> bytes(rom->begin(), rom->end());
+    const std::weak_ptr<const file_buffer> cached = rom;
+    rom.reset();
+    ASSERT_TRUE(cached.expired());
+
+    rom = rom_cache::load(rom_path);
+    ASSERT_EQ(std::vector<uint8_t>(rom->begin(), rom->end()), bytes);
+}
@@ -14,9 +14,13 @@ namespace
 
 class test_rom_runner {
 public:
-    explicit test_rom_runner(std::string path)
+    test_rom_runner(std::string path, const gameboy::cpu::execution_mode mode, const gameboy::ppu::renderer renderer)
         : rom_path_{std::move(path)},
-          gb_{rom_path_} {}
+          gb_{rom_path_}
+    {
+        gb_.set_execution_mode(mode);
+        gb_.set_renderer(renderer);
+    }
 
     uint8_t on_link_transfer(const uint8_t data) noexcept
     {
@@ -70,12 +74,14 @@ private:
     bool test_result_ = false;
 };
 
-void do_run_test(const fs::path& path)
+void do_run_test(const fs::path& path,
+  const gameboy::cpu::execution_mode mode = gameboy::cpu::execution_mode::interpreter,
+  const gameboy::ppu::renderer renderer = gameboy::ppu::renderer::scanline)
 {
     for(const auto& file : fs::directory_iterator{path}) {
         std::cout << "running test rom at " << file.path() << '\n';
 
-        test_rom_runner runner{file.path().string()};
+        test_rom_runner runner{file.path().string(), mode, renderer};
         ASSERT_TRUE(runner.run());
     }
 }
@@ -86,6 +92,15 @@ TEST(run_roms, test_cpu_instrs) {
     do_run_test(rom_tester_env::get_base_path().append("cpu_instrs"));
 }
 
+TEST(run_roms, test_cpu_instrs_cached_interpreter) {
+    do_run_test(rom_tester_env::get_base_path().append("cpu_instrs"), gameboy::cpu::execution_mode::cached_interpreter);
+}
+
+TEST(run_roms, test_cpu_instrs_pixel_fifo) {
+    do_run_test(rom_tester_env::get_base_path().append("cpu_instrs"),
+      gameboy::cpu::execution_mode::interpreter, gameboy::ppu::renderer::pixel_fifo);
+}
+
 TEST(run_roms, DISABLED_test_cgb_sound) {
     do_run_test(rom_tester_env::get_base_path().append("cgb_sound"));
 }
@@ -0,0 +1,189 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include "gameboy/gameboy.h"
+#include "rom_tester_env.h"
+
+namespace {
+
+void on_vblank() noexcept {}
+
+struct serial_log {
+    std::string text;
+
+    uint8_t on_transfer(const uint8_t data)
+    {
+        text += static_cast<char>(data);
+        return 0xFFu;
+    }
+};
+
+struct line_counter {
+    size_t count = 0u;
+
+    void on_render_line([[maybe_unused]] const uint8_t line_number, [[maybe_unused]] const gameboy::render_line& line) noexcept { ++count; }
+};
+
+/** wram, hram and the registers that change with every cycle */
+std::vector<uint8_t> read_memory(gameboy::gameboy& gb)
+{
+    auto mmu = gb.get_bus()->get_mmu();
+
+    std::vector<uint8_t> memory;
+    for(uint16_t address = 0xC000u; address < 0xE000u; ++address) {
+        memory.push_back(mmu->read(gameboy::make_address(address)));
+    }
+    for(uint16_t address = 0xFF80u; address < 0xFFFFu; ++address) {
+        memory.push_back(mmu->read(gameboy::make_address(address)));
+    }
+    for(const auto address : std::array<uint16_t, 4>{0xFF04u, 0xFF05u, 0xFF41u, 0xFF44u}) {
+        memory.push_back(mmu->read(gameboy::make_address(address)));
+    }
+
+    return memory;
+}
+
+/**
+ * runs whole frames and records every frame with the memory after it, then a few
+ * instructions so that the state is taken in the middle of a line
+ */
+std::vector<std::vector<uint8_t>> run_frames(gameboy::gameboy& gb, const size_t frame_count)
+{
+    std::vector<std::vector<uint8_t>> frames;
+    for(size_t i = 0u; i < frame_count; ++i) {
+        gb.tick_one_frame();
+
+        const auto frame = gb.frame();
+        frames.emplace_back(frame.begin(), frame.end());
+        frames.push_back(read_memory(gb));
+    }
+
+    for(auto i = 0u; i < 1'234u; ++i) {
+        gb.tick();
+    }
+
+    return frames;
+}
+
+void check_resumes_identically(const gameboy::ppu::renderer renderer)
+{
+    gameboy::gameboy gb{rom_tester_env::get_base_path().append("cpu_instrs.gb")};
+    gb.on_vblank({gameboy::connect_arg<&on_vblank>});
+    gb.set_renderer(renderer);
+
+    serial_log log;
+    gb.on_link_transfer_master({gameboy::connect_arg<&serial_log::on_transfer>, &log});
+    run_frames(gb, 120u);
+
+    std::vector<uint8_t> state;
+    gb.save_state(state);
+    log.text.clear();
+
+    const auto frames = run_frames(gb, 120u);
+    const auto text = log.text;
+    log.text.clear();
+
+    ASSERT_TRUE(gb.load_state(state));
+    ASSERT_EQ(run_frames(gb, 120u), frames);
+    ASSERT_EQ(log.text, text);
+}
+
+/** the serial output followed by the state after running the same frames in the given mode */
+std::vector<uint8_t> run_in_mode(const gameboy::ppu::render_mode mode, const uint32_t frame_interval)
+{
+    gameboy::gameboy gb{rom_tester_env::get_base_path().append("cpu_instrs.gb")};
+    gb.on_vblank({gameboy::connect_arg<&on_vblank>});
+    gb.set_render_mode(mode, frame_interval);
+
+    serial_log log;
+    gb.on_link_transfer_master({gameboy::connect_arg<&serial_log::on_transfer>, &log});
+    run_frames(gb, 300u);
+
+    std::vector<uint8_t> state;
+    gb.save_state(state);
+    state.insert(state.begin(), log.text.begin(), log.text.end());
+    return state;
+}
+
+} // namespace
+
+TEST(save_state, resumes_identically) {
+    check_resumes_identically(gameboy::ppu::renderer::scanline);
+}
+
+TEST(save_state, resumes_identically_pixel_fifo) {
+    check_resumes_identically(gameboy::ppu::renderer::pixel_fifo);
+}
+
+TEST(save_state, clone_runs_independently) {
+    gameboy::gameboy gb{rom_tester_env::get_base_path().append("cpu_instrs.gb")};
+    gb.on_vblank({gameboy::connect_arg<&on_vblank>});
+    gb.set_renderer(gameboy::ppu::renderer::pixel_fifo);
+
+    serial_log log;
+    gb.on_link_transfer_master({gameboy::connect_arg<&serial_log::on_transfer>, &log});
+    run_frames(gb, 120u);
+
+    const auto copy = gb.clone();
+    ASSERT_NE(copy, nullptr);
+    copy->on_vblank({gameboy::connect_arg<&on_vblank>});
+    copy->on_link_transfer_master({gameboy::connect_arg<&serial_log::on_transfer>, &log});
+    ASSERT_EQ(copy->get_bus()->get_cartridge()->rom().data(), gb.get_bus()->get_cartridge()->rom().data());
+    log.text.clear();
+
+    const auto frames = run_frames(gb, 120u);
+    const auto text = log.text;
+    log.text.clear();
+
+    ASSERT_EQ(run_frames(*copy, 120u), frames);
+    ASSERT_EQ(log.text, text);
+}
+
+TEST(save_state, clone_does_not_take_callbacks) {
+    gameboy::gameboy gb{rom_tester_env::get_base_path().append("cpu_instrs.gb")};
+    gb.on_vblank({gameboy::connect_arg<&on_vblank>});
+
+    line_counter counter;
+    gb.on_render_line({gameboy::connect_arg<&line_counter::on_render_line>, &counter});
+    gb.tick_one_frame();
+
+    const auto copy = gb.clone();
+    ASSERT_NE(copy, nullptr);
+    copy->on_vblank({gameboy::connect_arg<&on_vblank>});
+
+    const auto line_count = counter.count;
+    ASSERT_GT(line_count, 0u);
+    copy->tick_one_frame();
+    ASSERT_EQ(counter.count, line_count);
+}
+
+TEST(save_state, rejects_invalid_states) {
+    gameboy::gameboy gb{rom_tester_env::get_base_path().append("cpu_instrs.gb")};
+    gb.on_vblank({gameboy::connect_arg<&on_vblank>});
+    run_frames(gb, 10u);
+
+    std::vector<uint8_t> state;
+    gb.save_state(state);
+
+    gameboy::gameboy other{rom_tester_env::get_base_path().append("instr_timing.gb")};
+    ASSERT_FALSE(other.load_state(state));
+
+    auto truncated = state;
+    truncated.pop_back();
+    ASSERT_FALSE(gb.load_state(truncated));
+
+    auto bad_version = state;
+    bad_version[8u] ^= 0xFFu;
+    ASSERT_FALSE(gb.load_state(bad_version));
+
+    ASSERT_TRUE(gb.load_state(state));
+}
+
+TEST(save_state, render_modes_do_not_change_emulation) {
+    const auto full = run_in_mode(gameboy::ppu::render_mode::full, 1u);
+    ASSERT_EQ(run_in_mode(gameboy::ppu::render_mode::skip_n, 3u), full);
+    ASSERT_EQ(run_in_mode(gameboy::ppu::render_mode::timing_only, 1u), full);
+}